@@ -0,0 +1,451 @@
+#pragma once
+#include "LoggerConfig.h"
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace logger {
+namespace fmt {
+
+/**
+ * @brief {} 风格格式化（编译期解析格式串，运行期只做拼接）
+ *
+ * 支持的占位符：
+ *   {}        默认格式
+ *   {:x} {:X} {:b} {:d}   整数进制
+ *   {:.N} {:.Nf}          浮点定点 N 位小数
+ *   {:e} {:g}             浮点科学计数 / 通用
+ *   {{ }}                 转义花括号
+ * 数值转换使用 std::to_chars，不依赖 locale，也不在运行期解析格式串。
+ */
+
+struct FormatSpec {
+    char type = 0;          // 0 表示默认
+    int precision = -1;     // -1 表示未指定
+};
+
+struct FormatPiece {
+    uint16_t begin = 0;     // 字面量在格式串中的偏移
+    uint16_t len = 0;
+    bool is_arg = false;
+};
+
+struct CompiledFormat {
+    static constexpr size_t kMaxPieces = 48;
+
+    const char* str = nullptr;
+    FormatPiece pieces[kMaxPieces] = {};
+    FormatSpec arg_specs[kMaxPieces] = {};
+    size_t piece_count = 0;
+    size_t arg_count = 0;
+    size_t literal_bytes = 0;
+    bool ok = true;
+
+    constexpr bool valid() const { return ok; }
+};
+
+namespace detail {
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr void addLiteral(CompiledFormat& f, size_t begin, size_t len) {
+    if (len == 0) return;
+    f.literal_bytes += len;
+    if (f.piece_count > 0) {
+        FormatPiece& last = f.pieces[f.piece_count - 1];
+        if (!last.is_arg && last.begin + last.len == begin) {
+            last.len = static_cast<uint16_t>(last.len + len);
+            return;
+        }
+    }
+    if (f.piece_count == CompiledFormat::kMaxPieces) {
+        f.ok = false;
+        return;
+    }
+    FormatPiece& p = f.pieces[f.piece_count++];
+    p.begin = static_cast<uint16_t>(begin);
+    p.len = static_cast<uint16_t>(len);
+    p.is_arg = false;
+}
+
+// 解析 "{" 与 "}" 之间的内容（不含花括号），返回是否合法
+constexpr bool parseSpec(const char* s, size_t len, FormatSpec& spec) {
+    if (len == 0) return true;
+    if (s[0] != ':') return false;
+    size_t i = 1;
+    if (i < len && s[i] == '.') {
+        ++i;
+        if (i >= len || !isDigit(s[i])) return false;
+        int prec = 0;
+        while (i < len && isDigit(s[i])) {
+            prec = prec * 10 + (s[i] - '0');
+            if (prec > 64) return false;
+            ++i;
+        }
+        spec.precision = prec;
+    }
+    if (i < len) {
+        char t = s[i++];
+        switch (t) {
+            case 'd': case 'x': case 'X': case 'b':
+            case 'f': case 'e': case 'g': case 's':
+                spec.type = t;
+                break;
+            default:
+                return false;
+        }
+    }
+    return i == len;
+}
+
+} // namespace detail
+
+// 解析格式串；LOG_FMT 以 static constexpr 形式在编译期求值，解码器在运行期调用
+constexpr CompiledFormat compile(const char* s, size_t n) {
+    CompiledFormat f;
+    f.str = s;
+    if (n > UINT16_MAX) {
+        f.ok = false;
+        return f;
+    }
+    size_t lit_begin = 0;
+    size_t i = 0;
+    while (i < n) {
+        char c = s[i];
+        if (c == '{') {
+            detail::addLiteral(f, lit_begin, i - lit_begin);
+            if (i + 1 < n && s[i + 1] == '{') {
+                detail::addLiteral(f, i, 1);
+                i += 2;
+                lit_begin = i;
+                continue;
+            }
+            size_t close = i + 1;
+            while (close < n && s[close] != '}' && s[close] != '{') ++close;
+            if (close >= n || s[close] != '}') {
+                f.ok = false;
+                return f;
+            }
+            if (f.piece_count == CompiledFormat::kMaxPieces) {
+                f.ok = false;
+                return f;
+            }
+            FormatSpec spec;
+            if (!detail::parseSpec(s + i + 1, close - i - 1, spec)) {
+                f.ok = false;
+                return f;
+            }
+            FormatPiece& p = f.pieces[f.piece_count++];
+            p.is_arg = true;
+            f.arg_specs[f.arg_count++] = spec;
+            i = close + 1;
+            lit_begin = i;
+        } else if (c == '}') {
+            if (i + 1 < n && s[i + 1] == '}') {
+                detail::addLiteral(f, lit_begin, i - lit_begin);
+                detail::addLiteral(f, i, 1);
+                i += 2;
+                lit_begin = i;
+                continue;
+            }
+            f.ok = false;  // 孤立的 '}'
+            return f;
+        } else {
+            ++i;
+        }
+    }
+    detail::addLiteral(f, lit_begin, n - lit_begin);
+    return f;
+}
+
+template <size_t L>
+constexpr CompiledFormat compile(const char (&s)[L]) {
+    return compile(s, L - 1);
+}
+
+// 仅用于在不求值语境下统计参数个数
+template <typename... Args>
+char (&countArgs(const Args&...))[sizeof...(Args) + 1];
+
+namespace detail {
+
+template <typename>
+constexpr bool kUnsupported = false;
+
+// 字符数组（字面量）按字符串处理，不做空指针判断
+template <typename T>
+constexpr bool isCharPtr() {
+    using D = std::decay_t<T>;
+    return !std::is_array_v<T> &&
+           (std::is_same_v<D, const char*> || std::is_same_v<D, char*>);
+}
+
+template <typename T>
+size_t bound(const T& v, const FormatSpec& spec) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) {
+        return 5;
+    } else if constexpr (std::is_same_v<D, char>) {
+        return 1;
+    } else if constexpr (isCharPtr<T>()) {
+        return v ? std::strlen(v) : 6;
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        return std::string_view(v).size();
+    } else if constexpr (std::is_floating_point_v<D>) {
+        if (spec.precision < 0 && spec.type != 'f') return 32;
+        int prec = spec.precision < 0 ? 6 : spec.precision;
+        double mag = v < 0 ? -static_cast<double>(v) : static_cast<double>(v);
+        // 定点格式整数部分可能长达 309 位，仅在量级确实很大时才预留
+        return (mag < 1e15 ? 18 : 320) + static_cast<size_t>(prec) + 8;
+    } else if constexpr (std::is_integral_v<D>) {
+        return spec.type == 'b' ? sizeof(D) * 8 + 1 : 21;
+    } else if constexpr (std::is_pointer_v<D>) {
+        return 2 + sizeof(void*) * 2;
+    } else {
+        static_assert(kUnsupported<D>, "LOG_FMT: unsupported argument type");
+        return 0;
+    }
+}
+
+template <typename T>
+char* write(char* out, const T& v, const FormatSpec& spec) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) {
+        const char* s = v ? "true" : "false";
+        size_t n = v ? 4 : 5;
+        std::memcpy(out, s, n);
+        return out + n;
+    } else if constexpr (std::is_same_v<D, char>) {
+        *out = v;
+        return out + 1;
+    } else if constexpr (isCharPtr<T>()) {
+        std::string_view sv = v ? std::string_view(v) : std::string_view("(null)");
+        std::memcpy(out, sv.data(), sv.size());
+        return out + sv.size();
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        std::string_view sv(v);
+        std::memcpy(out, sv.data(), sv.size());
+        return out + sv.size();
+    } else if constexpr (std::is_floating_point_v<D>) {
+        // 调用方已按 bound() 预留空间
+        char* const end = out + bound(v, spec);
+        std::to_chars_result r;
+        if (spec.type == 'e') {
+            r = spec.precision < 0
+                ? std::to_chars(out, end, v, std::chars_format::scientific)
+                : std::to_chars(out, end, v, std::chars_format::scientific, spec.precision);
+        } else if (spec.type == 'g') {
+            r = spec.precision < 0
+                ? std::to_chars(out, end, v, std::chars_format::general)
+                : std::to_chars(out, end, v, std::chars_format::general, spec.precision);
+        } else if (spec.precision >= 0 || spec.type == 'f') {
+            r = std::to_chars(out, end, v, std::chars_format::fixed,
+                              spec.precision < 0 ? 6 : spec.precision);
+        } else {
+            r = std::to_chars(out, end, v);
+        }
+        return r.ptr;
+    } else if constexpr (std::is_integral_v<D>) {
+        int base = spec.type == 'x' || spec.type == 'X' ? 16 : spec.type == 'b' ? 2 : 10;
+        char* p = std::to_chars(out, out + bound(v, spec), v, base).ptr;
+        if (spec.type == 'X') {
+            for (char* c = out; c != p; ++c) {
+                if (*c >= 'a' && *c <= 'f') *c = static_cast<char>(*c - 'a' + 'A');
+            }
+        }
+        return p;
+    } else if constexpr (std::is_pointer_v<D>) {
+        out[0] = '0';
+        out[1] = 'x';
+        return std::to_chars(out + 2, out + bound(v, spec),
+                             reinterpret_cast<uintptr_t>(v), 16).ptr;
+    } else {
+        static_assert(kUnsupported<D>, "LOG_FMT: unsupported argument type");
+        return out;
+    }
+}
+
+inline char* writeLiterals(char* out, const CompiledFormat& f, size_t& piece) {
+    while (piece < f.piece_count && !f.pieces[piece].is_arg) {
+        std::memcpy(out, f.str + f.pieces[piece].begin, f.pieces[piece].len);
+        out += f.pieces[piece].len;
+        ++piece;
+    }
+    return out;
+}
+
+} // namespace detail
+
+// 输出长度上界：调用方据此一次性预留条目空间
+template <typename... Args>
+size_t formattedSizeBound(const CompiledFormat& f, const Args&... args) {
+    size_t total = f.literal_bytes;
+    size_t i = 0;
+    ((total += detail::bound(args, f.arg_specs[i++])), ...);
+    return total;
+}
+
+// 直接写入 out（空间至少为 formattedSizeBound），返回实际长度
+template <typename... Args>
+size_t formatTo(char* out, const CompiledFormat& f, const Args&... args) {
+    char* p = out;
+    size_t piece = 0;
+    size_t i = 0;
+    p = detail::writeLiterals(p, f, piece);
+    ((p = detail::write(p, args, f.arg_specs[i++]),
+      ++piece,
+      p = detail::writeLiterals(p, f, piece)), ...);
+    return static_cast<size_t>(p - out);
+}
+
+// ===== 紧凑二进制编码（compact_text 模式）=====
+// 参数按原生宽度（小端）写入；字符串为 u32 长度 + 字节；指针统一为 u64
+
+enum class ArgType : uint8_t {
+    Bool = 1, Char, I8, I16, I32, I64, U8, U16, U32, U64, F32, F64, String, Pointer
+};
+
+namespace detail {
+
+template <typename T>
+constexpr ArgType argTypeOf() {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) return ArgType::Bool;
+    else if constexpr (std::is_same_v<D, char>) return ArgType::Char;
+    else if constexpr (std::is_convertible_v<const T&, std::string_view> || isCharPtr<T>())
+        return ArgType::String;
+    else if constexpr (std::is_same_v<D, float>) return ArgType::F32;
+    else if constexpr (std::is_floating_point_v<D>) return ArgType::F64;
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+        return sizeof(D) == 1 ? ArgType::I8 : sizeof(D) == 2 ? ArgType::I16
+             : sizeof(D) == 4 ? ArgType::I32 : ArgType::I64;
+    else if constexpr (std::is_integral_v<D>)
+        return sizeof(D) == 1 ? ArgType::U8 : sizeof(D) == 2 ? ArgType::U16
+             : sizeof(D) == 4 ? ArgType::U32 : ArgType::U64;
+    else if constexpr (std::is_pointer_v<D>) return ArgType::Pointer;
+    else {
+        static_assert(kUnsupported<D>, "LOG_FMT: unsupported argument type");
+        return ArgType::Bool;
+    }
+}
+
+template <typename T>
+std::string_view asString(const T& v) {
+    if constexpr (isCharPtr<T>()) {
+        return v ? std::string_view(v) : std::string_view("(null)");
+    } else {
+        return std::string_view(v);
+    }
+}
+
+template <typename T>
+size_t encodedSize(const T& v) {
+    using D = std::decay_t<T>;
+    if constexpr (argTypeOf<T>() == ArgType::String) {
+        return sizeof(uint32_t) + asString(v).size();
+    } else if constexpr (std::is_pointer_v<D>) {
+        return sizeof(uint64_t);
+    } else {
+        return sizeof(D);
+    }
+}
+
+template <typename T>
+char* encode(char* out, const T& v) {
+    using D = std::decay_t<T>;
+    if constexpr (argTypeOf<T>() == ArgType::String) {
+        std::string_view sv = asString(v);
+        uint32_t len = static_cast<uint32_t>(sv.size());
+        std::memcpy(out, &len, sizeof(len));
+        std::memcpy(out + sizeof(len), sv.data(), sv.size());
+        return out + sizeof(len) + sv.size();
+    } else if constexpr (std::is_pointer_v<D>) {
+        uint64_t p = reinterpret_cast<uintptr_t>(v);
+        std::memcpy(out, &p, sizeof(p));
+        return out + sizeof(p);
+    } else {
+        D copy = v;
+        std::memcpy(out, &copy, sizeof(D));
+        return out + sizeof(D);
+    }
+}
+
+} // namespace detail
+
+// 类型擦除的写入回调：避免把模板实例化带进 Logger/LoggerCore 的编译单元
+using FormatWriter = size_t (*)(char* out, const void* ctx);
+using FormatBound = size_t (*)(const void* ctx);
+
+/**
+ * @brief 某一参数类型组合的格式化操作表（每种 Args... 一份静态实例）
+ *
+ * LoggerCore 根据当前模式选择文本格式化或紧凑编码，
+ * 两种路径都先求上界、再直接写进条目存储。
+ */
+struct FormatOps {
+    FormatBound text_bound;
+    FormatWriter text_write;
+    FormatBound binary_bound;
+    FormatWriter binary_write;
+    const ArgType* arg_types;
+    size_t arg_count;
+};
+
+/**
+ * @brief 日志调用点的静态元数据（每个 LOG_* 宏展开处一份）
+ *
+ * 常量初始化，无运行期构造开销；首次以紧凑模式写出时才向 LoggerCore 注册并获得 id。
+ */
+struct CallSite {
+    constexpr CallSite(LogLevel level, const char* file, const char* function,
+                       int line, const CompiledFormat& format)
+        : level(level), file(file), function(function), line(line), format(format) {}
+
+    const LogLevel level;
+    const char* const file;
+    const char* const function;
+    const int line;
+    const CompiledFormat& format;
+    std::atomic<uint32_t> id{0};   // 0 表示尚未注册
+};
+
+template <typename... Args>
+struct FormatOpsFor {
+    using Ctx = std::tuple<const CompiledFormat&, const Args&...>;
+
+    static size_t textBound(const void* ctx) {
+        return std::apply([](const CompiledFormat& f, const Args&... args) {
+            return formattedSizeBound(f, args...);
+        }, *static_cast<const Ctx*>(ctx));
+    }
+    static size_t textWrite(char* out, const void* ctx) {
+        return std::apply([out](const CompiledFormat& f, const Args&... args) {
+            return formatTo(out, f, args...);
+        }, *static_cast<const Ctx*>(ctx));
+    }
+    static size_t binaryBound(const void* ctx) {
+        return std::apply([](const CompiledFormat&, const Args&... args) {
+            return (size_t{0} + ... + detail::encodedSize(args));
+        }, *static_cast<const Ctx*>(ctx));
+    }
+    static size_t binaryWrite(char* out, const void* ctx) {
+        return std::apply([out](const CompiledFormat&, const Args&... args) {
+            char* p = out;
+            ((p = detail::encode(p, args)), ...);
+            return static_cast<size_t>(p - out);
+        }, *static_cast<const Ctx*>(ctx));
+    }
+
+    static constexpr ArgType kTypes[sizeof...(Args) + 1] = {detail::argTypeOf<Args>()..., ArgType::Bool};
+    static constexpr FormatOps kOps = {
+        &textBound, &textWrite, &binaryBound, &binaryWrite, kTypes, sizeof...(Args)
+    };
+};
+
+} // namespace fmt
+} // namespace logger
@@ -0,0 +1,21 @@
+#pragma once
+#include "LoggerConfig.h"
+#include <atomic>
+
+namespace logger {
+
+/**
+ * @brief 运行时级别闸门
+ *
+ * LoggerCore 是唯一写者；日志宏在求值任何参数之前内联读取它，
+ * 被过滤的调用不会产生函数调用或字符串构造。
+ * 初始值为 DEBUG：初始化完成前不拦截，由首次调用触发加载配置。
+ */
+alignas(64) inline std::atomic<LogLevel> g_level_gate{LogLevel::DEBUG};
+
+inline bool levelEnabled(LogLevel level) {
+    return static_cast<int>(level) >=
+           static_cast<int>(g_level_gate.load(std::memory_order_relaxed));
+}
+
+} // namespace logger
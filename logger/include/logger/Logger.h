@@ -1,14 +1,17 @@
 #pragma once
 #include "LoggerConfig.h"
+#include "LogLevelGate.h"
+#include "LogFormat.h"
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
-namespace logger {
-
-// 前向声明
+// 前向声明（LoggerCore 位于全局命名空间）
 class LoggerCore;
 
+namespace logger {
+
 /**
  * @brief 日志系统统一入口（Facade模式 + PIMPL）
  * 
@@ -37,12 +40,24 @@ public:
     void init(const LoggerConfig& config);
     
     // ===== 日志接口 =====
+    // string_view 同时接收字面量、左值和临时 std::string，消息只在入队时拷贝一次
     
-    void debug(const std::string& msg, const char* file, const char* func, int line);
-    void info(const std::string& msg, const char* file, const char* func, int line);
-    void warning(const std::string& msg, const char* file, const char* func, int line);
-    void error(const std::string& msg, const char* file, const char* func, int line);
-    void critical(const std::string& msg, const char* file, const char* func, int line);
+    void debug(std::string_view msg, const char* file, const char* func, int line);
+    void info(std::string_view msg, const char* file, const char* func, int line);
+    void warning(std::string_view msg, const char* file, const char* func, int line);
+    void error(std::string_view msg, const char* file, const char* func, int line);
+    void critical(std::string_view msg, const char* file, const char* func, int line);
+    
+    /**
+     * @brief {} 风格格式化日志（由 LOG_* 宏调用，格式串已在编译期校验）
+     *
+     * 文本模式下格式化为字符串；compact_text 模式下只记录调用点 id 与参数原始字节。
+     */
+    template <typename... Args>
+    void format(fmt::CallSite& site, const Args&... args) {
+        typename fmt::FormatOpsFor<Args...>::Ctx ctx(site.format, args...);
+        formatted(site, fmt::FormatOpsFor<Args...>::kOps, &ctx);
+    }
     
     // ===== 特殊日志接口 =====
     
@@ -61,8 +76,11 @@ public:
     
     LoggerConfig getConfig() const;
     bool isInitialized() const;
+    size_t queueCapacity() const;   // 共享异步队列的实际容量
     
 private:
+    void formatted(fmt::CallSite& site, const fmt::FormatOps& ops, const void* ctx);
+    
     Logger();
     ~Logger();
     Logger(const Logger&) = delete;
@@ -14,6 +14,83 @@ enum class LogLevel {
     ERROR,
     CRITICAL
 };
+// 异步队列满时的处理策略
+enum class OverflowPolicy {
+    DropOldest,   // 丢弃最旧的条目（默认）
+    DropNewest,   // 丢弃新写入的条目
+    Block         // 生产者等待空位
+};
+// 异步队列拓扑
+enum class AsyncQueueMode {
+    Shared,       // 所有生产者共享一个无锁 MPMC 队列
+    PerThread     // 每个生产者线程一个 SPSC 缓冲，消费者按时间戳归并；
+                  // 打时间戳后 merge_window_ms 内入缓冲的条目全局有序，切换拓扑时共享队列中的残留条目不参与归并
+};
+// 文本日志时间戳的小数位
+enum class TimestampPrecision {
+    Seconds,      // 2024-01-01 12:00:00
+    Millis,       // 2024-01-01 12:00:00.123
+    Micros,       // 2024-01-01 12:00:00.123456
+    Nanos         // 2024-01-01 12:00:00.123456789
+};
+// 段文件的写出后端
+enum class IoBackend {
+    Stream,       // std::ofstream（默认）
+    Fd,           // 裸 fd + 页对齐暂存区 + writev
+    Uring,        // io_uring 异步写，多缓冲在途；内核不支持时退回 Fd
+    Mmap,         // 预分配段 + mmap，生产者线程无锁直接写入（仅 binary 模块，其余退回 Fd）
+    Direct        // O_DIRECT 对齐块写出，轮转/压缩后的文件移出页缓存（大流量 binary/bag）
+};
+// 轮转后段文件的压缩编解码器
+enum class CompressionCodec {
+    Gzip,         // zlib deflate（默认，.gz）
+    Zstd,         // zstd，大段可按块并行（.zst）
+    Lz4           // LZ4 frame，压缩最快（.lz4）
+};
+// 后台压缩线程池配置（进程级，所有模块共享）
+struct CompressionConfig {
+    size_t threads = 1;     // 同时压缩的段数上限
+    int nice = 10;          // 压缩线程的 nice 值，越大优先级越低
+    double cpu_budget = 0;  // 压缩可用的平均 CPU 核数（含并行分块线程），0 为不限
+};
+// 全局磁盘预算（进程级，所有模块共享；各模块的配额见 ModuleConfig::disk_*）
+struct DiskConfig {
+    size_t total_mb = 0;            // 所有模块段文件的总大小上限，0 为不限
+    size_t soft_min_free_mb = 100;  // 可用空间低于此值时跨模块回收旧段
+    size_t hard_min_free_mb = 50;   // 可用空间低于此值时暂停写入（冷层迁移也保留这么多余量）
+    double migrate_mb_per_sec = 16; // 段跨文件系统迁往冷层时的复制限速，0 为不限
+};
+// 控制台输出配置（独立于文件模块）
+struct ConsoleConfig {
+    bool enabled = true;
+    LogLevel level = LogLevel::DEBUG;    // 控制台自身的阈值（在全局级别之上再过滤）
+    bool use_stderr = false;
+    size_t max_pending_bytes = 256 * 1024;  // 终端写不动时的积压上限，超出后丢弃
+};
+// 文本模块的刷新策略：何时把用户态缓冲交给内核
+// Interval 在异步模式下由空闲的工作线程兜底；同步模式只在下次写入时检查
+struct FlushPolicy {
+    enum class Mode {
+        Always,      // 每批写入后刷新（默认，与旧行为一致）
+        Never,       // 只在缓冲写满、轮转或关闭时刷新
+        Bytes,       // 累计未刷新字节达到 every_bytes 时刷新
+        Interval     // 距上次刷新超过 interval 时刷新
+    };
+    Mode mode = Mode::Always;
+    size_t every_bytes = 64 * 1024;
+    std::chrono::milliseconds interval{1000};
+    bool flush_on_level = true;           // 批内出现 >= level 的记录时立即刷新
+    LogLevel level = LogLevel::ERROR;
+    size_t buffer_bytes = 64 * 1024;      // 文件流的用户态缓冲大小
+    bool sync = false;                    // 刷新时 fdatasync（fd / uring 后端）
+};
+
+// 冷存储层：已封口并压缩的段在后台从热层迁移过去
+struct ColdTierConfig {
+    std::string dir;        // 冷层根目录，其下按 <module>/<进程名> 组织
+    size_t max_mb = 0;      // 本层段文件总大小上限，超出时最旧的段移往下一层（最后一层删除），0 为不限
+};
+
 //单个模块配置
 struct ModuleConfig {
     std::string name;
@@ -22,6 +99,39 @@ struct ModuleConfig {
     std::chrono::minutes max_age{60};
     size_t reserve_n = 8;
     bool compress_old = true;
+    std::string sink_type;            // text / binary / bag / compact；为空时按模块名推断
+    std::vector<std::string> topics;  // binary 按 tag、bag 按 topic 定向；为空表示承接其余所有条目
+    FlushPolicy flush;                // 由 LoggerConfig 解析 "flush" 对象（需要级别解析）
+    IoBackend io_backend = IoBackend::Stream;
+    CompressionCodec compression_codec = CompressionCodec::Gzip;
+    int compression_level = 0;        // 0 表示编解码器默认级别
+    int compression_workers = 0;      // 单个段内的并行压缩线程数（大段按块并行，辅助线程计入 CPU 预算；0 为单线程）
+    bool compression_adaptive = false; // 按积压与负载自动选级别，空闲时高压缩率重压（仅轮转后压缩）
+    bool compress_stream = false;     // 边写边压缩为可独立解码的帧（段末带帧索引），轮转后不再二次压缩
+    size_t compress_frame_kb = 1024;  // 边写边压缩的目标帧大小；刷新会提前结束当前帧
+    bool compression_dict = false;    // 用最近的段训练 zstd 字典压缩（仅 zstd 的轮转后压缩，优先于 adaptive）
+    size_t compression_dict_kb = 64;  // 字典大小
+    size_t compression_dict_retrain = 64; // 每压缩多少个段重新训练一次字典
+    size_t disk_quota_mb = 0;         // 模块段文件总大小上限（按字节保留），0 为不限
+    size_t disk_min_mb = 0;           // 全局回收时至少为本模块保留的大小
+    double disk_weight = 1.0;         // 全局回收优先级：越小越先被回收
+    std::chrono::minutes retain_age{0}; // 最后写入早于此时长的段被删除（按时间保留，所有层），0 为不限
+    std::vector<ColdTierConfig> cold_tiers; // 冷存储层，从近到远；disk_* 配额只计热层
+    
+    ModuleConfig() = default;
+    ModuleConfig(std::string name_, std::string pattern_, size_t max_bytes_,
+                 std::chrono::minutes max_age_, size_t reserve_n_, bool compress_old_,
+                 std::string sink_type_ = "", std::vector<std::string> topics_ = {})
+        : name(std::move(name_)), pattern(std::move(pattern_)), max_bytes(max_bytes_)
+        , max_age(max_age_), reserve_n(reserve_n_), compress_old(compress_old_)
+        , sink_type(std::move(sink_type_)), topics(std::move(topics_)) {}
+    
+    // 实际使用的 Sink 类型（兼容旧配置：模块名即类型）
+    std::string resolvedSinkType() const {
+        if (!sink_type.empty()) return sink_type;
+        if (name == "binary" || name == "bag" || name == "compact") return name;
+        return "text";
+    }
     
     // 从JSON加载
     static ModuleConfig fromJson(const json& j) {
@@ -32,19 +142,76 @@ struct ModuleConfig {
         cfg.max_age = std::chrono::minutes(j.value("max_age_minutes", 60));
         cfg.reserve_n = j.value("reserve_n", 8);
         cfg.compress_old = j.value("compress_old", true);
+        cfg.sink_type = j.value("sink_type", "");
+        cfg.topics = j.value("topics", std::vector<std::string>{});
+        std::string backend = j.value("io_backend", "stream");
+        cfg.io_backend = backend == "fd" ? IoBackend::Fd
+                       : backend == "uring" ? IoBackend::Uring
+                       : backend == "mmap" ? IoBackend::Mmap
+                       : backend == "direct" ? IoBackend::Direct : IoBackend::Stream;
+        std::string codec = j.value("compression_codec", "gzip");
+        cfg.compression_codec = codec == "zstd" ? CompressionCodec::Zstd
+                              : codec == "lz4" ? CompressionCodec::Lz4 : CompressionCodec::Gzip;
+        cfg.compression_level = j.value("compression_level", 0);
+        cfg.compression_workers = j.value("compression_workers", 0);
+        cfg.compression_adaptive = j.value("compression_adaptive", false);
+        cfg.compress_stream = j.value("compress_stream", false);
+        cfg.compress_frame_kb = j.value("compress_frame_kb", 1024);
+        cfg.compression_dict = j.value("compression_dict", false);
+        cfg.compression_dict_kb = j.value("compression_dict_kb", 64);
+        cfg.compression_dict_retrain = j.value("compression_dict_retrain", 64);
+        cfg.disk_quota_mb = j.value("disk_quota_mb", 0);
+        cfg.disk_min_mb = j.value("disk_min_mb", 0);
+        cfg.disk_weight = j.value("disk_weight", 1.0);
+        cfg.retain_age = std::chrono::minutes(j.value("retain_minutes", 0));
+        if (j.contains("cold_tiers") && j["cold_tiers"].is_array()) {
+            for (const auto& t : j["cold_tiers"]) {
+                cfg.cold_tiers.push_back({t.value("dir", ""), t.value("max_mb", size_t{0})});
+            }
+        }
         return cfg;
     }
     
     // 转为JSON
     json toJson() const {
-        return {
+        json j = {
             {"name", name},
+            {"sink_type", resolvedSinkType()},
             {"pattern", pattern},
             {"max_bytes_mb", max_bytes / (1024 * 1024)},
             {"max_age_minutes", max_age.count()},
             {"reserve_n", reserve_n},
-            {"compress_old", compress_old}
+            {"compress_old", compress_old},
+            {"io_backend", io_backend == IoBackend::Fd ? "fd"
+                         : io_backend == IoBackend::Uring ? "uring"
+                         : io_backend == IoBackend::Mmap ? "mmap"
+                         : io_backend == IoBackend::Direct ? "direct" : "stream"},
+            {"compression_codec", compression_codec == CompressionCodec::Zstd ? "zstd"
+                                : compression_codec == CompressionCodec::Lz4 ? "lz4" : "gzip"},
+            {"compression_level", compression_level},
+            {"compression_workers", compression_workers},
+            {"compression_adaptive", compression_adaptive},
+            {"compress_stream", compress_stream},
+            {"compress_frame_kb", compress_frame_kb},
+            {"compression_dict", compression_dict},
+            {"compression_dict_kb", compression_dict_kb},
+            {"compression_dict_retrain", compression_dict_retrain},
+            {"disk_quota_mb", disk_quota_mb},
+            {"disk_min_mb", disk_min_mb},
+            {"disk_weight", disk_weight},
+            {"retain_minutes", retain_age.count()}
         };
+        if (!topics.empty()) {
+            j["topics"] = topics;
+        }
+        if (!cold_tiers.empty()) {
+            json tiers = json::array();
+            for (const auto& t : cold_tiers) {
+                tiers.push_back({{"dir", t.dir}, {"max_mb", t.max_mb}});
+            }
+            j["cold_tiers"] = std::move(tiers);
+        }
+        return j;
     }
 };
 
@@ -57,6 +224,15 @@ struct LoggerConfig {
     LogLevel log_level = LogLevel::INFO;
     bool async_mode = true;
     size_t async_queue_size = 10000;
+    OverflowPolicy overflow_policy = OverflowPolicy::DropOldest;
+    AsyncQueueMode async_queue_mode = AsyncQueueMode::Shared;
+    size_t thread_queue_size = 4096;  // PerThread 模式下每线程缓冲容量
+    size_t merge_window_ms = 10;      // PerThread 归并的乱序窗口：条目最多滞留这么久等待较慢的线程，0 表示只在单批内排序
+    bool compact_text = false;        // 文本日志以 调用点id+参数 的二进制形式写入 compact 模块
+    TimestampPrecision timestamp_precision = TimestampPrecision::Seconds;
+    ConsoleConfig console;
+    CompressionConfig compression;
+    DiskConfig disk;
     
     // 模块配置（支持多模块）
     std::vector<ModuleConfig> modules;
@@ -86,11 +262,42 @@ struct LoggerConfig {
         cfg.log_level = parseLogLevel(level_str);
         cfg.async_mode = j.value("async_mode", true);
         cfg.async_queue_size = j.value("async_queue_size", 10000);
+        cfg.overflow_policy = parseOverflowPolicy(j.value("overflow_policy", "drop_oldest"));
+        cfg.async_queue_mode = j.value("async_queue_mode", "shared") == "per_thread"
+            ? AsyncQueueMode::PerThread : AsyncQueueMode::Shared;
+        cfg.thread_queue_size = j.value("thread_queue_size", 4096);
+        cfg.merge_window_ms = j.value("merge_window_ms", 10);
+        cfg.compact_text = j.value("compact_text", false);
+        cfg.timestamp_precision = parseTimestampPrecision(j.value("timestamp_precision", "s"));
+        if (j.contains("console") && j["console"].is_object()) {
+            const auto& c = j["console"];
+            cfg.console.enabled = c.value("enabled", true);
+            cfg.console.level = parseLogLevel(c.value("level", "DEBUG"));
+            cfg.console.use_stderr = c.value("stream", "stdout") == "stderr";
+            cfg.console.max_pending_bytes = c.value("max_pending_kb", 256) * 1024;
+        }
+        if (j.contains("compression") && j["compression"].is_object()) {
+            const auto& c = j["compression"];
+            cfg.compression.threads = c.value("threads", 1);
+            cfg.compression.nice = c.value("nice", 10);
+            cfg.compression.cpu_budget = c.value("cpu_budget", 0.0);
+        }
+        if (j.contains("disk") && j["disk"].is_object()) {
+            const auto& d = j["disk"];
+            cfg.disk.total_mb = d.value("total_mb", 0);
+            cfg.disk.soft_min_free_mb = d.value("soft_min_free_mb", 100);
+            cfg.disk.hard_min_free_mb = d.value("hard_min_free_mb", 50);
+            cfg.disk.migrate_mb_per_sec = d.value("migrate_mb_per_sec", 16.0);
+        }
         
         // 加载模块配置
         if (j.contains("modules") && j["modules"].is_array()) {
             for (const auto& mod : j["modules"]) {
-                cfg.modules.push_back(ModuleConfig::fromJson(mod));
+                ModuleConfig mod_cfg = ModuleConfig::fromJson(mod);
+                if (mod.contains("flush") && mod["flush"].is_object()) {
+                    mod_cfg.flush = parseFlushPolicy(mod["flush"]);
+                }
+                cfg.modules.push_back(std::move(mod_cfg));
             }
         } else {
             // 默认三个模块
@@ -117,10 +324,35 @@ struct LoggerConfig {
         j["log_level"] = logLevelToString(log_level);
         j["async_mode"] = async_mode;
         j["async_queue_size"] = async_queue_size;
+        j["overflow_policy"] = overflowPolicyToString(overflow_policy);
+        j["async_queue_mode"] = async_queue_mode == AsyncQueueMode::PerThread ? "per_thread" : "shared";
+        j["thread_queue_size"] = thread_queue_size;
+        j["merge_window_ms"] = merge_window_ms;
+        j["compact_text"] = compact_text;
+        j["timestamp_precision"] = timestampPrecisionToString(timestamp_precision);
+        j["console"] = {
+            {"enabled", console.enabled},
+            {"level", logLevelToString(console.level)},
+            {"stream", console.use_stderr ? "stderr" : "stdout"},
+            {"max_pending_kb", console.max_pending_bytes / 1024}
+        };
+        j["compression"] = {
+            {"threads", compression.threads},
+            {"nice", compression.nice},
+            {"cpu_budget", compression.cpu_budget}
+        };
+        j["disk"] = {
+            {"total_mb", disk.total_mb},
+            {"soft_min_free_mb", disk.soft_min_free_mb},
+            {"hard_min_free_mb", disk.hard_min_free_mb},
+            {"migrate_mb_per_sec", disk.migrate_mb_per_sec}
+        };
         
         json modules_json = json::array();
         for (const auto& mod : modules) {
-            modules_json.push_back(mod.toJson());
+            json mod_json = mod.toJson();
+            mod_json["flush"] = flushPolicyToJson(mod.flush);
+            modules_json.push_back(std::move(mod_json));
         }
         j["modules"] = modules_json;
         
@@ -155,6 +387,76 @@ private:
         }
     }
     
+    static FlushPolicy parseFlushPolicy(const json& j) {
+        FlushPolicy p;
+        std::string mode = j.value("mode", "always");
+        if (mode == "never") p.mode = FlushPolicy::Mode::Never;
+        else if (mode == "bytes") p.mode = FlushPolicy::Mode::Bytes;
+        else if (mode == "interval") p.mode = FlushPolicy::Mode::Interval;
+        else p.mode = FlushPolicy::Mode::Always;
+        p.every_bytes = j.value("every_kb", 64) * 1024;
+        p.interval = std::chrono::milliseconds(j.value("interval_ms", 1000));
+        // "level": "OFF" 关闭按级别立即刷新
+        std::string level = j.value("level", "ERROR");
+        p.flush_on_level = level != "OFF";
+        if (p.flush_on_level) {
+            p.level = parseLogLevel(level);
+        }
+        p.buffer_bytes = j.value("buffer_kb", 64) * 1024;
+        p.sync = j.value("sync", false);
+        return p;
+    }
+    
+    static json flushPolicyToJson(const FlushPolicy& p) {
+        const char* mode = "always";
+        switch (p.mode) {
+            case FlushPolicy::Mode::Never: mode = "never"; break;
+            case FlushPolicy::Mode::Bytes: mode = "bytes"; break;
+            case FlushPolicy::Mode::Interval: mode = "interval"; break;
+            default: break;
+        }
+        return {
+            {"mode", mode},
+            {"every_kb", p.every_bytes / 1024},
+            {"interval_ms", p.interval.count()},
+            {"level", p.flush_on_level ? logLevelToString(p.level) : std::string("OFF")},
+            {"buffer_kb", p.buffer_bytes / 1024},
+            {"sync", p.sync}
+        };
+    }
+    
+    static OverflowPolicy parseOverflowPolicy(const std::string& s) {
+        if (s == "drop_newest") return OverflowPolicy::DropNewest;
+        if (s == "block") return OverflowPolicy::Block;
+        return OverflowPolicy::DropOldest;
+    }
+    
+    static std::string overflowPolicyToString(OverflowPolicy p) {
+        switch (p) {
+            case OverflowPolicy::DropNewest: return "drop_newest";
+            case OverflowPolicy::Block: return "block";
+            default: return "drop_oldest";
+        }
+    }
+    
+public:
+    static TimestampPrecision parseTimestampPrecision(const std::string& s) {
+        if (s == "ms") return TimestampPrecision::Millis;
+        if (s == "us") return TimestampPrecision::Micros;
+        if (s == "ns") return TimestampPrecision::Nanos;
+        return TimestampPrecision::Seconds;
+    }
+    
+    static std::string timestampPrecisionToString(TimestampPrecision p) {
+        switch (p) {
+            case TimestampPrecision::Millis: return "ms";
+            case TimestampPrecision::Micros: return "us";
+            case TimestampPrecision::Nanos: return "ns";
+            default: return "s";
+        }
+    }
+    
+private:
     static std::vector<ModuleConfig> createDefaultModules() {
         return {
             ModuleConfig{
@@ -1,18 +1,68 @@
 #pragma once
 #include "Logger.h"
+#include <chrono>
+#include <string>
+
+// ===== 编译期最低级别 =====
+// 低于 LOGGER_MIN_LEVEL 的调用在编译期整体剔除（0=DEBUG ... 4=CRITICAL）
+// 例：-DLOGGER_MIN_LEVEL=1 去掉所有 LOG_DEBUG
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 0
+#endif
+
+#define LOGGER_LVL_DEBUG    0
+#define LOGGER_LVL_INFO     1
+#define LOGGER_LVL_WARN     2
+#define LOGGER_LVL_WARNING  2
+#define LOGGER_LVL_ERROR    3
+#define LOGGER_LVL_CRITICAL 4
+
+#define LOGGER_ENUM_DEBUG    LogLevel::DEBUG
+#define LOGGER_ENUM_INFO     LogLevel::INFO
+#define LOGGER_ENUM_WARN     LogLevel::WARNING
+#define LOGGER_ENUM_WARNING  LogLevel::WARNING
+#define LOGGER_ENUM_ERROR    LogLevel::ERROR
+#define LOGGER_ENUM_CRITICAL LogLevel::CRITICAL
+
+// 所有日志宏的公共展开：先做编译期剔除，再内联读取原子级别闸门，最后才求值参数。
+// 每个展开处有一份常量初始化的 CallSite（级别、位置、格式串），供 compact_text 模式注册。
+#define LOGGER_FMT_IMPL_(level, fmt_str, ...) do { \
+    static constexpr ::logger::fmt::CompiledFormat logger_fmt_ = \
+        ::logger::fmt::compile(fmt_str); \
+    static_assert(logger_fmt_.valid(), "LOG_FMT: malformed format string"); \
+    if constexpr (LOGGER_LVL_##level >= LOGGER_MIN_LEVEL) { \
+        static ::logger::fmt::CallSite logger_site_(LOGGER_ENUM_##level, \
+            __FILE__, __FUNCTION__, __LINE__, logger_fmt_); \
+        if (logger::levelEnabled(LOGGER_ENUM_##level)) { \
+            logger::Logger::instance().format(logger_site_, ##__VA_ARGS__); \
+        } \
+    } \
+} while(0)
+
+#define LOG_AT_(level, msg_expr) LOGGER_FMT_IMPL_(level, "{}", msg_expr)
 
 // ===== 基础日志宏 =====
-#define LOG_DEBUG(msg)    logger::Logger::instance().debug(msg, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_INFO(msg)     logger::Logger::instance().info(msg, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_WARN(msg)     logger::Logger::instance().warning(msg, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_ERROR(msg)    logger::Logger::instance().error(msg, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_CRITICAL(msg) logger::Logger::instance().critical(msg, __FILE__, __FUNCTION__, __LINE__)
+#define LOG_DEBUG(msg)    LOG_AT_(DEBUG, msg)
+#define LOG_INFO(msg)     LOG_AT_(INFO, msg)
+#define LOG_WARN(msg)     LOG_AT_(WARN, msg)
+#define LOG_WARNING(msg)  LOG_AT_(WARNING, msg)
+#define LOG_ERROR(msg)    LOG_AT_(ERROR, msg)
+#define LOG_CRITICAL(msg) LOG_AT_(CRITICAL, msg)
+
+// ===== 惰性日志宏 =====
+// 仅在级别启用时调用 fn()，fn 返回可转换为 std::string_view 的值
+// 例：LOG_LAZY(DEBUG, [&] { return dumpState(); });
+#define LOG_LAZY(level, fn) LOG_AT_(level, (fn)())
 
 // ===== 格式化日志宏 =====
-#define LOG_FMT(level, fmt, ...) do { \
-    char buf_[2048]; \
-    snprintf(buf_, sizeof(buf_), fmt, ##__VA_ARGS__); \
-    LOG_##level(std::string(buf_)); \
+// {} 风格：格式串在编译期解析并校验（非法格式或参数个数不符直接编译失败），
+// 结果不截断，直接写入日志条目
+// 例：LOG_INFO_FMT("read {} bytes from {} in {:.3f} ms", n, path, ms);
+#define LOG_FMT(level, fmt_str, ...) do { \
+    static_assert(::logger::fmt::compile(fmt_str).arg_count == \
+        sizeof(::logger::fmt::countArgs(__VA_ARGS__)) - 1, \
+        "LOG_FMT: placeholder count does not match argument count"); \
+    LOGGER_FMT_IMPL_(level, fmt_str, ##__VA_ARGS__); \
 } while(0)
 
 // 便捷别名
@@ -20,6 +70,7 @@
 #define LOG_INFO_FMT(fmt, ...)  LOG_FMT(INFO, fmt, ##__VA_ARGS__)
 #define LOG_WARN_FMT(fmt, ...)  LOG_FMT(WARN, fmt, ##__VA_ARGS__)
 #define LOG_ERROR_FMT(fmt, ...) LOG_FMT(ERROR, fmt, ##__VA_ARGS__)
+#define LOG_CRITICAL_FMT(fmt, ...) LOG_FMT(CRITICAL, fmt, ##__VA_ARGS__)
 
 // ===== 条件日志宏 =====
 #define LOG_IF(level, condition, msg) do { \
@@ -38,7 +89,7 @@ public:
     ~ScopeTimer() {
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start_);
-        LOG_INFO_FMT("[PERF] %s took %ld ms", name_.c_str(), duration.count());
+        LOG_INFO_FMT("[PERF] {} took {} ms", name_, duration.count());
     }
     
 private:
@@ -1,6 +1,7 @@
 #include "../../logger/include/logger/Logger.h"
 #include "../../logger/include/logger/LoggerConfig.h"
 #include "core/LoggerCore.h"  
+#include <atomic>
 #include <filesystem>
 #include <iostream>
 
@@ -11,7 +12,7 @@ class Logger::Impl {
 public:
     LoggerCore& core;
     std::string config_path_;
-    bool initialized_ = false;
+    std::atomic<bool> initialized_{false};
     
     Impl() : core(LoggerCore::instance()) {}
     
@@ -63,31 +64,36 @@ void Logger::init(const LoggerConfig& config) {
     pimpl_->initialized_ = true;
 }
 
-void Logger::debug(const std::string& msg, const char* file, const char* func, int line) {
-    if (!pimpl_->initialized_) init();
+void Logger::debug(std::string_view msg, const char* file, const char* func, int line) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
     pimpl_->core.log(LogLevel::DEBUG, msg, file, func, line);
 }
 
-void Logger::info(const std::string& msg, const char* file, const char* func, int line) {
-    if (!pimpl_->initialized_) init();
+void Logger::info(std::string_view msg, const char* file, const char* func, int line) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
     pimpl_->core.log(LogLevel::INFO, msg, file, func, line);
 }
 
-void Logger::warning(const std::string& msg, const char* file, const char* func, int line) {
-    if (!pimpl_->initialized_) init();
+void Logger::warning(std::string_view msg, const char* file, const char* func, int line) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
     pimpl_->core.log(LogLevel::WARNING, msg, file, func, line);
 }
 
-void Logger::error(const std::string& msg, const char* file, const char* func, int line) {
-    if (!pimpl_->initialized_) init();
+void Logger::error(std::string_view msg, const char* file, const char* func, int line) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
     pimpl_->core.log(LogLevel::ERROR, msg, file, func, line);
 }
 
-void Logger::critical(const std::string& msg, const char* file, const char* func, int line) {
-    if (!pimpl_->initialized_) init();
+void Logger::critical(std::string_view msg, const char* file, const char* func, int line) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
     pimpl_->core.log(LogLevel::CRITICAL, msg, file, func, line);
 }
 
+void Logger::formatted(fmt::CallSite& site, const fmt::FormatOps& ops, const void* ctx) {
+    if (!pimpl_->initialized_.load(std::memory_order_acquire)) init();
+    pimpl_->core.logFormatted(site, ops, ctx);
+}
+
 void Logger::binary(const void* data, size_t size, const std::string& tag) {
     if (!pimpl_->initialized_) init();
     pimpl_->core.logBinary(data, size, tag);
@@ -116,7 +122,7 @@ void Logger::reload() {
 }
 
 void Logger::flush() {
-    // 可以添加刷新所有Sink的逻辑
+    pimpl_->core.flush();
 }
 
 LoggerConfig Logger::getConfig() const {
@@ -127,4 +133,8 @@ bool Logger::isInitialized() const {
     return pimpl_->initialized_;
 }
 
+size_t Logger::queueCapacity() const {
+    return pimpl_->core.queueCapacity();
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include "../../include/logger/LogFormat.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 调用点元数据的持久副本（compact_text 模式下写入段文件，供解码器还原文本）
+struct CallSiteInfo {
+    uint32_t id = 0;
+    LogLevel level = LogLevel::INFO;
+    int line = 0;
+    std::string file;
+    std::string function;
+    std::string format;
+    std::vector<logger::fmt::ArgType> arg_types;
+};
+
+/**
+ * @brief 进程级调用点注册表
+ *
+ * CallSite::id 是宏展开处的静态变量，跨 LoggerCore 重新初始化保持不变，
+ * 因此注册表也必须是进程级单例。只增不删，查询返回的指针长期有效。
+ */
+class CallSiteRegistry {
+public:
+    static CallSiteRegistry& instance() {
+        static CallSiteRegistry inst;
+        return inst;
+    }
+
+    // 返回调用点 id（首次调用时分配，从 1 开始）
+    uint32_t registerSite(logger::fmt::CallSite& site, const logger::fmt::FormatOps& ops) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        uint32_t id = site.id.load(std::memory_order_relaxed);
+        if (id != 0) return id;
+
+        CallSiteInfo info;
+        info.id = static_cast<uint32_t>(sites_.size() + 1);
+        info.level = site.level;
+        info.line = site.line;
+        info.file = site.file;
+        info.function = site.function;
+        info.format = site.format.str;
+        info.arg_types.assign(ops.arg_types, ops.arg_types + ops.arg_count);
+        sites_.push_back(std::move(info));
+
+        id = sites_.back().id;
+        site.id.store(id, std::memory_order_release);
+        return id;
+    }
+
+    const CallSiteInfo* lookup(uint32_t id) const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (id == 0 || id > sites_.size()) return nullptr;
+        return &sites_[id - 1];
+    }
+
+private:
+    CallSiteRegistry() = default;
+    CallSiteRegistry(const CallSiteRegistry&) = delete;
+    CallSiteRegistry& operator=(const CallSiteRegistry&) = delete;
+
+    mutable std::mutex mtx_;
+    std::deque<CallSiteInfo> sites_;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief compact_text 段文件格式（小端，字段紧密排列）
+ *
+ *   文件头   "CLOG" | u16 version | u16 reserved
+ *   时钟锚点 u8 kAnchor | u64 mono_ns | u64 wall_ns
+ *   调用点   u8 kSiteDef | u32 id | u8 level | i32 line | u8 nargs | u8 types[nargs]
+ *            | u16 len + file | u16 len + function | u16 len + format
+ *   日志     u8 kEvent | u32 id | u64 mono_ns | u32 args_len | args
+ *
+ * 每个段在首次引用某调用点前写出其定义，因此段文件可独立解码；
+ * 追加到旧段时可能出现同一 id 的重复定义，解码器以最近一次为准。
+ * 事件只记录单调时钟刻度；每次打开段都会写一条锚点记录
+ * （单调时钟在重启后不连续），解码器用其后最近的锚点换算墙钟。
+ */
+namespace CompactLogFormat {
+    constexpr char kMagic[4] = {'C', 'L', 'O', 'G'};
+    constexpr uint16_t kVersion = 2;
+    constexpr uint8_t kSiteDef = 1;
+    constexpr uint8_t kEvent = 2;
+    constexpr uint8_t kAnchor = 3;
+}
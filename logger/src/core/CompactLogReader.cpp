@@ -0,0 +1,205 @@
+#include "CompactLogReader.h"
+#include "CompactLogFormat.h"
+#include "LoggerCore.h"
+#include "../manager/CompressionStrategies.h"
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using logger::fmt::ArgType;
+
+struct SiteDef {
+    LogLevel level = LogLevel::INFO;
+    int line = 0;
+    std::string file;
+    std::string function;
+    std::string format;
+    std::vector<ArgType> arg_types;
+};
+
+// 顺序读取缓冲区，越界时置 ok = false
+class ByteCursor {
+public:
+    ByteCursor(const char* data, size_t size) : p_(data), end_(data + size) {}
+    
+    template <typename T>
+    T read() {
+        T v{};
+        if (static_cast<size_t>(end_ - p_) < sizeof(T)) {
+            ok = false;
+            p_ = end_;
+            return v;
+        }
+        std::memcpy(&v, p_, sizeof(T));
+        p_ += sizeof(T);
+        return v;
+    }
+    
+    std::string_view bytes(size_t n) {
+        if (static_cast<size_t>(end_ - p_) < n) {
+            ok = false;
+            p_ = end_;
+            return {};
+        }
+        std::string_view v(p_, n);
+        p_ += n;
+        return v;
+    }
+    
+    bool done() const { return p_ >= end_; }
+    bool ok = true;
+    
+private:
+    const char* p_;
+    const char* end_;
+};
+
+template <typename T>
+void appendArg(std::string& out, const T& v, const logger::fmt::FormatSpec& spec) {
+    size_t old = out.size();
+    out.resize(old + logger::fmt::detail::bound(v, spec));
+    char* end = logger::fmt::detail::write(&out[old], v, spec);
+    out.resize(static_cast<size_t>(end - out.data()));
+}
+
+bool appendDecodedArg(std::string& out, ArgType type, ByteCursor& args,
+                      const logger::fmt::FormatSpec& spec) {
+    switch (type) {
+        case ArgType::Bool: appendArg(out, args.read<bool>(), spec); break;
+        case ArgType::Char: appendArg(out, args.read<char>(), spec); break;
+        case ArgType::I8: appendArg(out, args.read<int8_t>(), spec); break;
+        case ArgType::I16: appendArg(out, args.read<int16_t>(), spec); break;
+        case ArgType::I32: appendArg(out, args.read<int32_t>(), spec); break;
+        case ArgType::I64: appendArg(out, args.read<int64_t>(), spec); break;
+        case ArgType::U8: appendArg(out, args.read<uint8_t>(), spec); break;
+        case ArgType::U16: appendArg(out, args.read<uint16_t>(), spec); break;
+        case ArgType::U32: appendArg(out, args.read<uint32_t>(), spec); break;
+        case ArgType::U64: appendArg(out, args.read<uint64_t>(), spec); break;
+        case ArgType::F32: appendArg(out, args.read<float>(), spec); break;
+        case ArgType::F64: appendArg(out, args.read<double>(), spec); break;
+        case ArgType::String: {
+            uint32_t len = args.read<uint32_t>();
+            appendArg(out, args.bytes(len), spec);
+            break;
+        }
+        case ArgType::Pointer: {
+            uint64_t p = args.read<uint64_t>();
+            appendArg(out, reinterpret_cast<const void*>(static_cast<uintptr_t>(p)), spec);
+            break;
+        }
+        default:
+            return false;
+    }
+    return args.ok;
+}
+
+// 按调用点格式串把参数字节还原为消息文本
+bool renderMessage(const SiteDef& site, std::string_view arg_bytes, std::string& out) {
+    auto f = logger::fmt::compile(site.format.data(), site.format.size());
+    if (!f.valid() || f.arg_count != site.arg_types.size()) return false;
+    
+    ByteCursor args(arg_bytes.data(), arg_bytes.size());
+    size_t arg = 0;
+    for (size_t i = 0; i < f.piece_count; ++i) {
+        const auto& piece = f.pieces[i];
+        if (!piece.is_arg) {
+            out.append(f.str + piece.begin, piece.len);
+            continue;
+        }
+        if (!appendDecodedArg(out, site.arg_types[arg], args, f.arg_specs[arg])) {
+            return false;
+        }
+        ++arg;
+    }
+    return true;
+}
+
+} // namespace
+
+bool CompactLogReader::decodeFile(const std::filesystem::path& path, const LineCallback& on_line,
+                                  TimestampPrecision precision) {
+    std::string data;
+    if (!readSegmentFile(path, data)) {
+        std::cerr << "[CompactLogReader] Failed to read " << path << "\n";
+        return false;
+    }
+    
+    ByteCursor cur(data.data(), data.size());
+    auto magic = cur.bytes(sizeof(CompactLogFormat::kMagic));
+    if (!cur.ok || std::memcmp(magic.data(), CompactLogFormat::kMagic, magic.size()) != 0) {
+        std::cerr << "[CompactLogReader] Not a compact log segment: " << path << "\n";
+        return false;
+    }
+    uint16_t version = cur.read<uint16_t>();
+    cur.read<uint16_t>();
+    if (version != CompactLogFormat::kVersion) {
+        std::cerr << "[CompactLogReader] Unsupported version " << version << "\n";
+        return false;
+    }
+    
+    std::unordered_map<uint32_t, SiteDef> sites;
+    ClockAnchor anchor;
+    bool has_anchor = false;
+    TimestampFormatter timestamps(precision);
+    std::string line;
+    std::string message;
+    
+    while (!cur.done()) {
+        uint8_t tag = cur.read<uint8_t>();
+        if (tag == CompactLogFormat::kSiteDef) {
+            uint32_t id = cur.read<uint32_t>();
+            SiteDef def;
+            def.level = static_cast<LogLevel>(cur.read<uint8_t>());
+            def.line = cur.read<int32_t>();
+            uint8_t nargs = cur.read<uint8_t>();
+            for (auto b : cur.bytes(nargs)) {
+                def.arg_types.push_back(static_cast<ArgType>(b));
+            }
+            def.file = std::string(cur.bytes(cur.read<uint16_t>()));
+            def.function = std::string(cur.bytes(cur.read<uint16_t>()));
+            def.format = std::string(cur.bytes(cur.read<uint16_t>()));
+            if (!cur.ok) break;
+            sites[id] = std::move(def);  // 追加写入的段可能重复定义，以最近一次为准
+        } else if (tag == CompactLogFormat::kAnchor) {
+            anchor.mono_ns = cur.read<uint64_t>();
+            anchor.wall_ns = cur.read<uint64_t>();
+            has_anchor = cur.ok;
+        } else if (tag == CompactLogFormat::kEvent) {
+            uint32_t id = cur.read<uint32_t>();
+            uint64_t mono_ns = cur.read<uint64_t>();
+            uint32_t args_len = cur.read<uint32_t>();
+            auto args = cur.bytes(args_len);
+            if (!cur.ok) break;
+            
+            auto it = sites.find(id);
+            if (!has_anchor) {
+                std::cerr << "[CompactLogReader] Event precedes clock anchor\n";
+                return false;
+            }
+            if (it == sites.end()) {
+                std::cerr << "[CompactLogReader] Event references undefined site " << id << "\n";
+                return false;
+            }
+            message.clear();
+            if (!renderMessage(it->second, args, message)) {
+                std::cerr << "[CompactLogReader] Malformed arguments for site " << id << "\n";
+                return false;
+            }
+            line.clear();
+            appendTextLine(line, timestamps, anchor.toWall(mono_ns), it->second.level,
+                           it->second.file, it->second.line, it->second.function, message);
+            on_line(line);
+        } else {
+            cur.ok = false;
+            break;
+        }
+    }
+    
+    if (!cur.ok) {
+        std::cerr << "[CompactLogReader] Truncated or corrupt segment: " << path << "\n";
+    }
+    return cur.ok;
+}
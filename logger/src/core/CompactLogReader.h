@@ -0,0 +1,21 @@
+#pragma once
+#include "../../include/logger/LoggerConfig.h"
+#include <filesystem>
+#include <functional>
+#include <string>
+
+/**
+ * @brief compact_text 段解码器
+ *
+ * 把紧凑段（可为 .gz / .zst / .lz4）还原为与文本模块完全相同的行格式，
+ * 供 clog_decode 工具和测试使用。
+ */
+class CompactLogReader {
+public:
+    using LineCallback = std::function<void(const std::string& line)>;
+    
+    // 逐行回调；文件无法打开或内容损坏时返回 false（已解码的行仍会回调）
+    // 段内只有单调刻度，时间戳精度由调用方指定
+    static bool decodeFile(const std::filesystem::path& path, const LineCallback& on_line,
+                           TimestampPrecision precision = TimestampPrecision::Micros);
+};
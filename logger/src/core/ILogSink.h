@@ -1,7 +1,52 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include "../../include/logger/LoggerConfig.h"
+
+// ===== 批量写入的记录视图（只在一次 write*Batch 调用期间有效）=====
+
+struct TextRecord {
+    std::string_view line;      // 不含换行符
+    LogLevel level = LogLevel::INFO;  // 供按级别刷新的策略使用
+};
+
+struct BinaryRecord {
+    std::string_view tag;
+    const uint8_t* data;
+    size_t size;
+    uint64_t timestamp;
+};
+
+struct MessageRecord {
+    std::string_view topic;
+    std::string_view type;
+    const uint8_t* data;
+    size_t size;
+    uint64_t timestamp;
+};
+
+struct CompactRecord {
+    uint32_t site_id;
+    uint64_t mono_ns;           // 单调时钟刻度
+    const uint8_t* args;
+    size_t size;
+};
+
+// 连续记录的只读视图（C++17 没有 std::span）
+template <typename T>
+struct RecordSpan {
+    const T* ptr = nullptr;
+    size_t count = 0;
+    
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+};
 
 // 日志输出接口
 class ILogSink {
@@ -12,17 +57,56 @@ public:
     virtual void writeText(const std::string& formatted_message) = 0;
     
     // 写入二进制数据
-    virtual void writeBinary(const std::vector<uint8_t>& data, 
-                            const std::string& tag, 
+    virtual void writeBinary(const uint8_t* data, size_t size,
+                            std::string_view tag, 
                             uint64_t timestamp) = 0;
     
     // 写入消息记录
-    virtual void writeMessage(const std::string& topic,
-                             const std::string& type,
-                             const std::vector<uint8_t>& data,
+    virtual void writeMessage(std::string_view topic,
+                             std::string_view type,
+                             const uint8_t* data, size_t size,
                              uint64_t timestamp) = 0;
+    
+    // 写入紧凑文本日志（调用点 id + 参数原始字节；mono_ns 为单调时钟刻度）
+    virtual void writeCompact(uint32_t site_id, uint64_t mono_ns,
+                              const uint8_t* args, size_t size) = 0;
+    
+    // 批量写入：文件类 Sink 重写为一次加锁、一次轮转检查、一次连续写；
+    // 默认实现逐条转发
+    virtual void writeTextBatch(RecordSpan<TextRecord> records) {
+        std::string line;
+        for (const auto& r : records) {
+            line.assign(r.line);
+            writeText(line);
+        }
+    }
+    
+    virtual void writeBinaryBatch(RecordSpan<BinaryRecord> records) {
+        for (const auto& r : records) {
+            writeBinary(r.data, r.size, r.tag, r.timestamp);
+        }
+    }
+    
+    virtual void writeMessageBatch(RecordSpan<MessageRecord> records) {
+        for (const auto& r : records) {
+            writeMessage(r.topic, r.type, r.data, r.size, r.timestamp);
+        }
+    }
+    
+    virtual void writeCompactBatch(RecordSpan<CompactRecord> records) {
+        for (const auto& r : records) {
+            writeCompact(r.site_id, r.mono_ns, r.args, r.size);
+        }
+    }
+    
     // 刷新缓冲
     virtual void flush() = 0;
+    
+    // 按刷新策略检查到期的缓冲（工作线程空闲时调用），默认无操作
+    virtual void flushIfDue() {}
+    
+    // 是否允许生产者线程直接并发调用 writeBinary（不经队列与工作线程）
+    virtual bool appendsConcurrently() const { return false; }
 protected:
     // 检查是否需要轮转
     virtual bool needRotate() = 0;
@@ -37,6 +121,13 @@ class ITextSink {
 public:
     virtual ~ITextSink() = default;
     virtual void writeText(const std::string& formatted_message) = 0;
+    virtual void writeTextBatch(RecordSpan<TextRecord> records) {
+        std::string line;
+        for (const auto& r : records) {
+            line.assign(r.line);
+            writeText(line);
+        }
+    }
     virtual void flush() = 0;
 };
 
@@ -44,9 +135,14 @@ public:
 class IBinarySink {
 public:
     virtual ~IBinarySink() = default;
-    virtual void writeBinary(const std::vector<uint8_t>& data, 
-                            const std::string& tag, 
+    virtual void writeBinary(const uint8_t* data, size_t size,
+                            std::string_view tag, 
                             uint64_t timestamp) = 0;
+    virtual void writeBinaryBatch(RecordSpan<BinaryRecord> records) {
+        for (const auto& r : records) {
+            writeBinary(r.data, r.size, r.tag, r.timestamp);
+        }
+    }
     virtual void flush() = 0;
 };
 
@@ -54,9 +150,14 @@ public:
 class IMessageSink {
 public:
     virtual ~IMessageSink() = default;
-    virtual void writeMessage(const std::string& topic,
-                             const std::string& type,
-                             const std::vector<uint8_t>& data,
+    virtual void writeMessage(std::string_view topic,
+                             std::string_view type,
+                             const uint8_t* data, size_t size,
                              uint64_t timestamp) = 0;
+    virtual void writeMessageBatch(RecordSpan<MessageRecord> records) {
+        for (const auto& r : records) {
+            writeMessage(r.topic, r.type, r.data, r.size, r.timestamp);
+        }
+    }
     virtual void flush() = 0;
 };
\ No newline at end of file
@@ -1,56 +1,315 @@
 #include "LoggerCore.h"
 
 #include "../manager/RollingFileManager.h"
+#include "../manager/CompressionPool.h"
+#include "../manager/CompressionStrategies.h"
+#include "../manager/AdaptiveCompression.h"
+#include "../manager/DictionaryCompression.h"
+#include "../manager/DiskQuotaManager.h"
+#include "../manager/TierMigrator.h"
 #include "../sinks/TextRollingFileSink.h"    
 #include "../sinks/BinaryRollingFileSink.h"   
 #include "../sinks/BagSink.h" 
+#include "../sinks/CompactTextSink.h"
+#include "../sinks/ConsoleSink.h"
+#include <unistd.h>
+#include "CallSiteRegistry.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <iterator>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
 
 // ============================================
-// ILogEntry 实现（多态的核心）
+// LogEntry 实现（按 kind 分发，替代虚函数）
 // ============================================
-void TextLogEntry::writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) {
-    auto it = sinks.find("text");
-    if (it != sinks.end()) {
-        // 格式化在这里完成，减少耦合
-        std::ostringstream oss;
-        oss << timestamp << " ";
-        
-        switch (level) {
-            case LogLevel::DEBUG: oss << "DEBUG"; break;
-            case LogLevel::INFO: oss << "INFO"; break;
-            case LogLevel::WARNING: oss << "WARNING"; break;
-            case LogLevel::ERROR: oss << "ERROR"; break;
-            case LogLevel::CRITICAL: oss << "CRITICAL"; break;
+namespace {
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::CRITICAL: return "CRITICAL";
+        default: return "UNKNOWN";
+    }
+}
+}
+
+void appendTextLine(std::string& out, TimestampFormatter& timestamps, uint64_t wall_ns,
+                    LogLevel level, std::string_view file, int line,
+                    std::string_view function, std::string_view message) {
+    char line_buf[16];
+    int line_len = std::snprintf(line_buf, sizeof(line_buf), "%d", line);
+    
+    timestamps.append(out, wall_ns);
+    out.append(" ")
+       .append(levelName(level)).append(" ")
+       .append(file).append(":").append(line_buf, line_len).append(" ")
+       .append(function).append(" - ")
+       .append(message);
+}
+
+void LogEntry::assign(SlabPool& pool, std::initializer_list<std::string_view> segments) {
+    releaseOverflow();
+    
+    size_t total = 0;
+    size_t i = 0;
+    for (auto seg : segments) {
+        if (i == kMaxSegments) break;
+        seg_len_[i++] = static_cast<uint32_t>(seg.size());
+        total += seg.size();
+    }
+    for (; i < kMaxSegments; ++i) {
+        seg_len_[i] = 0;
+    }
+    
+    char* dst = inline_;
+    if (total > kInlineCapacity) {
+        overflow_ = pool.acquire(total, overflow_cap_);
+        pool_ = &pool;
+        dst = overflow_;
+    }
+    
+    i = 0;
+    for (auto seg : segments) {
+        if (i++ == kMaxSegments) break;
+        std::memcpy(dst, seg.data(), seg.size());
+        dst += seg.size();
+    }
+}
+
+char* LogEntry::reserve(SlabPool& pool, size_t capacity) {
+    releaseOverflow();
+    std::memset(seg_len_, 0, sizeof(seg_len_));
+    if (capacity > kInlineCapacity) {
+        overflow_ = pool.acquire(capacity, overflow_cap_);
+        pool_ = &pool;
+        return overflow_;
+    }
+    return inline_;
+}
+
+std::string_view LogEntry::segment(size_t i) const {
+    if (i >= kMaxSegments) return {};
+    size_t offset = 0;
+    for (size_t k = 0; k < i; ++k) {
+        offset += seg_len_[k];
+    }
+    return std::string_view(payload() + offset, seg_len_[i]);
+}
+
+size_t LogEntry::payloadSize() const {
+    size_t total = 0;
+    for (auto len : seg_len_) {
+        total += len;
+    }
+    return total;
+}
+
+void LogEntry::releaseOverflow() {
+    if (overflow_) {
+        pool_->release(overflow_, overflow_cap_);
+        overflow_ = nullptr;
+        pool_ = nullptr;
+        overflow_cap_ = 0;
+    }
+}
+
+void LogEntry::moveFrom(LogEntry& other) {
+    kind = other.kind;
+    level = other.level;
+    line = other.line;
+    tick_ns = other.tick_ns;
+    file = other.file;
+    function = other.function;
+    std::memcpy(seg_len_, other.seg_len_, sizeof(seg_len_));
+    
+    if (other.overflow_) {
+        // 溢出缓冲直接转移所有权
+        overflow_ = other.overflow_;
+        overflow_cap_ = other.overflow_cap_;
+        pool_ = other.pool_;
+        other.overflow_ = nullptr;
+        other.pool_ = nullptr;
+        other.overflow_cap_ = 0;
+    } else {
+        std::memcpy(inline_, other.inline_, payloadSize());
+    }
+    std::memset(other.seg_len_, 0, sizeof(other.seg_len_));
+}
+
+// ============================================
+// 批量分发
+// ============================================
+template <typename Record>
+void BatchDispatcher::group(std::vector<SinkRecords<Record>>& groups, size_t& used,
+                            ILogSink* sink, const Record& record) {
+    for (size_t i = 0; i < used; ++i) {
+        if (groups[i].sink == sink) {
+            groups[i].records.push_back(record);
+            return;
         }
-        
-        oss << " " << file << ":" << line << " "
-            << function << " - " << message;
-        
-        std::string formatted = oss.str();
-        
-        // 控制台输出
-        std::cout << formatted << std::endl;
-        
-        // 写入 Sink
-        it->second->writeText(formatted);
     }
+    if (used == groups.size()) {
+        groups.emplace_back();
+    }
+    groups[used].sink = sink;
+    groups[used].records.push_back(record);
+    ++used;
 }
 
-void BinaryLogEntry::writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) {
-    auto it = sinks.find("binary");
-    if (it != sinks.end()) {
-        it->second->writeBinary(data, tag, timestamp);
+void BatchDispatcher::add(const LogEntry& entry, const RoutingTable& routes,
+                          ConsoleSink* console) {
+    switch (entry.kind) {
+        case EntryKind::Text: {
+            const auto& targets = routes.route(EntryKind::Text);
+            bool to_console = console && console->accepts(entry.level);
+            if (targets.empty() && !to_console) return;
+            
+            // 格式化在这里完成，渲染缓冲跨批次复用，稳态下不再分配
+            size_t begin = text_buf_.size();
+            appendTextLine(text_buf_, timestamps_, clock_.toWallNanos(entry.tick_ns),
+                           entry.level, entry.file, entry.line, entry.function, entry.segment(0));
+            size_t len = text_buf_.size() - begin;
+            
+            // 控制台只入缓冲，由消费者在批次结束时统一写出
+            if (to_console) {
+                console->append(std::string_view(text_buf_).substr(begin, len));
+            }
+            if (!targets.empty()) {
+                text_spans_.push_back(TextSpan{begin, len, entry.level});
+                text_targets_ = &targets;
+            }
+            break;
+        }
+        case EntryKind::Binary: {
+            const auto& targets = routes.route(EntryKind::Binary, entry.segment(0));
+            if (targets.empty()) return;
+            auto data = entry.segment(1);
+            BinaryRecord record{entry.segment(0), reinterpret_cast<const uint8_t*>(data.data()),
+                                data.size(), clock_.toWallNanos(entry.tick_ns) / 1000};
+            for (ILogSink* sink : targets) {
+                // 映射段 Sink 已由生产者线程直接写入
+                if (sink->appendsConcurrently()) continue;
+                group(binary_, binary_used_, sink, record);
+            }
+            break;
+        }
+        case EntryKind::Message: {
+            const auto& targets = routes.route(EntryKind::Message, entry.segment(0));
+            if (targets.empty()) return;
+            auto data = entry.segment(2);
+            MessageRecord record{entry.segment(0), entry.segment(1),
+                                 reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                                 clock_.toWallNanos(entry.tick_ns) / 1000};
+            for (ILogSink* sink : targets) {
+                group(message_, message_used_, sink, record);
+            }
+            break;
+        }
+        case EntryKind::Compact: {
+            const auto& targets = routes.route(EntryKind::Compact);
+            if (targets.empty()) return;
+            auto payload = entry.segment(0);
+            uint32_t site_id = 0;
+            std::memcpy(&site_id, payload.data(), sizeof(site_id));
+            // 原样写出单调刻度，段文件头中的锚点负责离线换算
+            CompactRecord record{site_id, entry.tick_ns,
+                                 reinterpret_cast<const uint8_t*>(payload.data()) + sizeof(site_id),
+                                 payload.size() - sizeof(site_id)};
+            for (ILogSink* sink : targets) {
+                group(compact_, compact_used_, sink, record);
+            }
+            break;
+        }
     }
 }
 
-void MessageLogEntry::writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) {
-    auto it = sinks.find("bag");
-    if (it != sinks.end()) {
-        it->second->writeMessage(topic, type, data, timestamp);
+void BatchDispatcher::flush() {
+    if (!text_spans_.empty()) {
+        text_records_.clear();
+        for (const auto& span : text_spans_) {
+            text_records_.push_back(TextRecord{std::string_view(text_buf_).substr(span.begin, span.len),
+                                               span.level});
+        }
+        for (ILogSink* sink : *text_targets_) {
+            sink->writeTextBatch({text_records_.data(), text_records_.size()});
+        }
+        text_spans_.clear();
+        text_targets_ = nullptr;
     }
+    text_buf_.clear();
+    
+    for (size_t i = 0; i < binary_used_; ++i) {
+        auto& g = binary_[i];
+        g.sink->writeBinaryBatch({g.records.data(), g.records.size()});
+        g.records.clear();
+    }
+    binary_used_ = 0;
+    
+    for (size_t i = 0; i < message_used_; ++i) {
+        auto& g = message_[i];
+        g.sink->writeMessageBatch({g.records.data(), g.records.size()});
+        g.records.clear();
+    }
+    message_used_ = 0;
+    
+    for (size_t i = 0; i < compact_used_; ++i) {
+        auto& g = compact_[i];
+        g.sink->writeCompactBatch({g.records.data(), g.records.size()});
+        g.records.clear();
+    }
+    compact_used_ = 0;
+}
+
+// ============================================
+// Sink 路由表
+// ============================================
+namespace {
+// Sink 类型 → 它承接的条目类型
+bool entryKindForSinkType(const std::string& sink_type, EntryKind& kind) {
+    if (sink_type == "text") kind = EntryKind::Text;
+    else if (sink_type == "binary") kind = EntryKind::Binary;
+    else if (sink_type == "bag") kind = EntryKind::Message;
+    else if (sink_type == "compact") kind = EntryKind::Compact;
+    else return false;
+    return true;
+}
+}
+
+void RoutingTable::clear() {
+    for (auto& r : kinds_) {
+        r.fallback.clear();
+        r.keyed.clear();
+    }
+}
+
+void RoutingTable::add(EntryKind kind, ILogSink* sink, const std::vector<std::string>& topics) {
+    KindRoutes& r = kinds_[static_cast<size_t>(kind)];
+    if (topics.empty()) {
+        r.fallback.push_back(sink);
+        return;
+    }
+    for (const auto& topic : topics) {
+        auto it = std::find_if(r.keyed.begin(), r.keyed.end(),
+                               [&](const auto& kv) { return kv.first == topic; });
+        if (it == r.keyed.end()) {
+            r.keyed.emplace_back(topic, SinkList{});
+            it = std::prev(r.keyed.end());
+        }
+        it->second.push_back(sink);
+    }
+}
+
+bool RoutingTable::has(EntryKind kind) const {
+    const KindRoutes& r = kinds_[static_cast<size_t>(kind)];
+    return !r.fallback.empty() || !r.keyed.empty();
 }
 
 // ============================================
@@ -63,20 +322,43 @@ public:
         const ModuleConfig& config,
         const std::string& sink_type) override
     {
+        std::shared_ptr<ICompressionStrategy> compression;
+        if (config.compression_dict && config.compression_codec == CompressionCodec::Zstd &&
+            !config.compress_stream) {
+            compression = std::make_shared<ZstdDictionaryStrategy>(
+                config.compression_level, config.compression_dict_kb * 1024,
+                config.compression_dict_retrain);
+        } else if (config.compression_adaptive && !config.compress_stream) {
+            compression = std::make_shared<AdaptiveCompressionStrategy>(
+                config.compression_codec, config.compression_level, config.compression_workers);
+        } else {
+            compression = makeCompressionStrategy(
+                config.compression_codec, config.compression_level, config.compression_workers,
+                config.compress_stream ? config.compress_frame_kb * 1024 : 0);
+        }
         if (sink_type == "text") {
             return std::make_shared<TextRollingFileSink>(
                 base_dir, config.name, config.pattern,
-                config.max_bytes, config.max_age, config.reserve_n, config.compress_old
+                config.max_bytes, config.max_age, config.reserve_n, config.compress_old,
+                config.flush, config.io_backend, compression
             );
         } else if (sink_type == "binary") {
             return std::make_shared<BinaryRollingFileSink>(
                 base_dir, config.name, config.pattern,
-                config.max_bytes, config.max_age, config.reserve_n, config.compress_old
+                config.max_bytes, config.max_age, config.reserve_n, config.compress_old,
+                config.io_backend, compression
             );
         } else if (sink_type == "bag") {
             return std::make_shared<BagSink>(
                 base_dir, config.name, config.pattern,
-                config.max_bytes, config.max_age, config.reserve_n, config.compress_old
+                config.max_bytes, config.max_age, config.reserve_n, config.compress_old,
+                config.io_backend, compression
+            );
+        } else if (sink_type == "compact") {
+            return std::make_shared<CompactTextSink>(
+                base_dir, config.name, config.pattern,
+                config.max_bytes, config.max_age, config.reserve_n, config.compress_old,
+                config.io_backend, compression
             );
         }
         
@@ -85,29 +367,40 @@ public:
 };
 
 // ============================================
-// LoggerCore 实现
+// 线程私有缓冲句柄（PerThread 模式）
 // ============================================
-LoggerCore::LoggerCore() {
-    queue_ = std::queue<std::unique_ptr<ILogEntry>>();
+namespace {
+// 线程退出时析构：只标记关闭，真正的回收由工作线程在排空后完成
+struct ThreadBufferHandle {
+    std::shared_ptr<ThreadLogBuffer> buffer;
+    uint64_t generation = 0;
+    
+    ~ThreadBufferHandle() {
+        if (buffer) {
+            buffer->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadBufferHandle t_buffer_handle;
 }
 
+// ============================================
+// LoggerCore 实现
+// ============================================
+LoggerCore::LoggerCore()
+    : queue_(std::make_unique<MpmcRingBuffer<LogEntry>>(max_queue_size_)) {}
+
 LoggerCore::~LoggerCore() {
     stop_ = true;
-    cv_.notify_all();
+    wakeWorker();
     
     if (worker_.joinable()) {
         worker_.join();
     }
     
     // 处理残留数据
-    std::lock_guard<std::mutex> lock(queue_mtx_);
-    while (!queue_.empty()) {
-        auto& entry = queue_.front();
-        if (entry) {
-            entry->writeTo(sinks_);
-        }
-        queue_.pop();
-    }
+    drainQueue();
 }
 
 LoggerCore& LoggerCore::instance() {
@@ -138,30 +431,88 @@ void LoggerCore::initFromConfig(const LoggerConfig& config,
         factory = std::make_unique<DefaultSinkFactory>();
     }
     
+    // 先停掉工作线程（停止时会排空队列），再等已读到异步标志的生产者离开：
+    // 此后生产者改走同步路径，不再触碰队列与直写 Sink
+    setAsyncMode(false);
+    quiesceProducers();
+    drainQueue();   // 工作线程退出后才入队的条目
+    
     // 更新配置
     current_config_ = config;
-    current_level_.store(config.log_level);
+    logger::g_level_gate.store(config.log_level);
     max_queue_size_ = config.async_queue_size;
+    overflow_policy_ = config.overflow_policy;
+    // 容量不变时沿用原队列
+    if (MpmcRingBuffer<LogEntry>::capacityFor(max_queue_size_) != queue_->capacity()) {
+        queue_ = std::make_unique<MpmcRingBuffer<LogEntry>>(max_queue_size_);
+    }
+    queue_mode_.store(config.async_queue_mode);
+    {
+        std::lock_guard<std::mutex> reg_lock(registry_mtx_);
+        thread_queue_size_ = config.thread_queue_size;
+    }
+    merge_window_ns_ = static_cast<uint64_t>(config.merge_window_ms) * 1000000;
+    // 换代：各生产者线程下次写日志时按新容量重新申请缓冲
+    buffer_generation_.fetch_add(1, std::memory_order_release);
+    
+    CompressionPool::instance().configure(config.compression.threads, config.compression.nice);
+    CompressionPool::instance().setCpuBudget(config.compression.cpu_budget);
+    
+    // 磁盘配额须在创建 Sink 前生效：RollingFileManager 构造时读取可用空间阈值
+    {
+        constexpr uint64_t MB = 1024 * 1024;
+        std::map<std::string, ModuleDiskQuota> quotas;
+        for (const auto& mod_config : config.modules) {
+            ModuleDiskQuota q;
+            q.max_bytes = mod_config.disk_quota_mb * MB;
+            q.min_bytes = mod_config.disk_min_mb * MB;
+            q.weight = mod_config.disk_weight;
+            q.max_age = mod_config.retain_age;
+            for (const auto& tier : mod_config.cold_tiers) {
+                q.cold_tiers.push_back({tier.dir, tier.max_mb * MB});
+            }
+            quotas[mod_config.name] = q;
+        }
+        DiskQuotaManager::instance().configure(
+            config.disk.total_mb * MB,
+            DiskPolicy::fromMB(config.disk.soft_min_free_mb, config.disk.hard_min_free_mb, 2),
+            std::move(quotas));
+        TierMigrator::instance().setRate(static_cast<uint64_t>(config.disk.migrate_mb_per_sec * MB));
+    }
+    
+    // 工作线程已停止、生产者已离开：Sink 表只需与同步路径互斥
+    std::unique_lock<std::mutex> sync_lock(sync_write_mtx_);
     
     // 清空旧 Sink
+    direct_binary_.store(false);
     sinks_.clear();
+    routes_.clear();
+    console_.reset();
+    
+    if (config.console.enabled) {
+        console_ = std::make_shared<ConsoleSink>(
+            config.console.use_stderr ? STDERR_FILENO : STDOUT_FILENO,
+            config.console.level, config.console.max_pending_bytes);
+    }
     
-    // 创建新 Sink
+    // 创建新 Sink，并一次性解析路由
+    bool direct = false;
     for (const auto& mod_config : config.modules) {
-        std::string sink_type = "text"; // 默认类型
-        
-        // 根据模块名推断类型（可改进为配置项）
-        if (mod_config.name == "text") {
-            sink_type = "text";
-        } else if (mod_config.name == "binary") {
-            sink_type = "binary";
-        } else if (mod_config.name == "bag") {
-            sink_type = "bag";
+        std::string sink_type = mod_config.resolvedSinkType();
+        EntryKind kind;
+        if (!entryKindForSinkType(sink_type, kind)) {
+            std::cerr << "[Logger] Unknown sink_type \"" << sink_type << "\" for module "
+                      << mod_config.name << std::endl;
+            continue;
         }
         
         try {
             auto sink = factory->createSink(config.base_dir, mod_config, sink_type);
             sinks_[mod_config.name] = sink;
+            routes_.add(kind, sink.get(), mod_config.topics);
+            if (kind == EntryKind::Binary && sink->appendsConcurrently()) {
+                direct = true;
+            }
             std::cout << "[Logger] Created sink: " << mod_config.name << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "[Logger] Failed to create sink " << mod_config.name 
@@ -169,6 +520,20 @@ void LoggerCore::initFromConfig(const LoggerConfig& config,
         }
     }
     
+    // 紧凑文本模式需要 compact 类型的模块承接输出
+    bool compact = config.compact_text && routes_.has(EntryKind::Compact);
+    if (config.compact_text && !compact) {
+        std::cerr << "[Logger] compact_text requires a module with sink_type \"compact\"; "
+                  << "falling back to plain text" << std::endl;
+    }
+    compact_text_.store(compact);
+    direct_binary_.store(direct);
+    
+    worker_batch_.setPrecision(config.timestamp_precision);
+    sync_batch_.setPrecision(config.timestamp_precision);
+    sync_lock.unlock();
+    resumeProducers();
+    
     // 设置异步模式
     setAsyncMode(config.async_mode);
 }
@@ -205,18 +570,43 @@ void LoggerCore::initSinks(const std::filesystem::path& base_dir,
 
 
 void LoggerCore::setLogLevel(LogLevel level) {
-    current_level_ = level;
+    logger::g_level_gate.store(level);
+}
+
+void LoggerCore::flush() {
+    // initFromConfig 在 sync_write_mtx_ 下重建 Sink 表：先在锁内取快照，刷新不占用同步写锁
+    std::vector<std::shared_ptr<ILogSink>> sinks;
+    std::shared_ptr<ConsoleSink> console;
+    {
+        std::lock_guard<std::mutex> lock(sync_write_mtx_);
+        sinks.reserve(sinks_.size());
+        for (const auto& [name, sink] : sinks_) {
+            sinks.push_back(sink);
+        }
+        console = console_;
+    }
+    for (const auto& sink : sinks) {
+        sink->flush();
+    }
+    if (console) {
+        console->flush();
+    }
 }
 
 void LoggerCore::setAsyncMode(bool enable) {
     if (enable && !async_mode_) {
         async_mode_ = true;
         worker_ = std::thread(&LoggerCore::processAsyncQueue, this);
-        std::cout << "[Logger] Async mode enabled (queue size: " 
-                  << max_queue_size_ << ")" << std::endl;
+        if (queue_mode_ == AsyncQueueMode::PerThread) {
+            std::cout << "[Logger] Async mode enabled (per-thread buffers: " 
+                      << thread_queue_size_ << ")" << std::endl;
+        } else {
+            std::cout << "[Logger] Async mode enabled (queue size: " 
+                      << queue_->capacity() << ")" << std::endl;
+        }
     } else if (!enable && async_mode_) {
         stop_ = true;
-        cv_.notify_all();
+        wakeWorker();
         if (worker_.joinable()) {
             worker_.join();
         }
@@ -256,18 +646,62 @@ LoggerConfig LoggerCore::getCurrentConfig() const {
     return current_config_;
 }
 
+size_t LoggerCore::queueCapacity() const {
+    return queue_->capacity();
+}
+
 
 
-void LoggerCore::log(LogLevel level, const std::string& message,
-                     const std::string& file, const std::string& function, int line) {
-    if (static_cast<int>(level) < static_cast<int>(current_level_.load())) {
+void LoggerCore::log(LogLevel level, std::string_view message,
+                     const char* file, const char* function, int line) {
+    if (!logger::levelEnabled(level)) {
         return;
     }
     
+    LogEntry entry;
+    entry.kind = EntryKind::Text;
+    entry.level = level;
+    entry.line = line;
+    entry.tick_ns = MonotonicClock::now();
+    entry.file = file;
+    entry.function = function;
+    entry.assign(pool_, {message});
+    
+    if (async_mode_) {
+        enqueueAsync(std::move(entry));
+    } else {
+        processEntry(std::move(entry));
+    }
+}
 
-    auto entry = std::make_unique<TextLogEntry>(
-        level, message, file, function, getCurrentTime(), line
-    );
+void LoggerCore::logFormatted(logger::fmt::CallSite& site, const logger::fmt::FormatOps& ops,
+                              const void* ctx) {
+    if (!logger::levelEnabled(site.level)) {
+        return;
+    }
+    
+    LogEntry entry;
+    entry.level = site.level;
+    entry.line = site.line;
+    entry.tick_ns = MonotonicClock::now();
+    entry.file = site.file;
+    entry.function = site.function;
+    
+    if (compact_text_.load(std::memory_order_relaxed)) {
+        // 紧凑模式：只记录调用点 id 与参数原始字节，格式化留给离线解码器
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0) {
+            id = CallSiteRegistry::instance().registerSite(site, ops);
+        }
+        entry.kind = EntryKind::Compact;
+        char* dst = entry.reserve(pool_, sizeof(id) + ops.binary_bound(ctx));
+        std::memcpy(dst, &id, sizeof(id));
+        entry.commit(sizeof(id) + ops.binary_write(dst + sizeof(id), ctx));
+    } else {
+        // 参数只经历一次拷贝：直接格式化进条目的内联区或溢出缓冲
+        entry.kind = EntryKind::Text;
+        entry.commit(ops.text_write(entry.reserve(pool_, ops.text_bound(ctx)), ctx));
+    }
     
     if (async_mode_) {
         enqueueAsync(std::move(entry));
@@ -277,15 +711,25 @@ void LoggerCore::log(LogLevel level, const std::string& message,
 }
 
 void LoggerCore::logBinary(const void* data, size_t size, const std::string& tag) {
-    std::vector<uint8_t> data_vec(static_cast<const uint8_t*>(data), 
-                                  static_cast<const uint8_t*>(data) + size);
-    
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (direct_binary_.load(std::memory_order_acquire)) {
+        // 映射段 Sink 在调用线程上直接预留并拷贝，不经队列与工作线程；
+        // 只有还存在普通 Sink 时才继续入队
+        bool queued;
+        if (enterProducer()) {
+            queued = appendDirectBinary(data, size, tag);
+            leaveProducer();
+        } else {
+            // 重配置中：Sink 表在同步写入锁下替换
+            std::lock_guard<std::mutex> lock(sync_write_mtx_);
+            queued = appendDirectBinary(data, size, tag);
+        }
+        if (!queued) return;
+    }
     
-    auto entry = std::make_unique<BinaryLogEntry>(
-        std::move(data_vec), tag, timestamp
-    );
+    LogEntry entry;
+    entry.kind = EntryKind::Binary;
+    entry.tick_ns = MonotonicClock::now();
+    entry.assign(pool_, {tag, std::string_view(static_cast<const char*>(data), size)});
     
     if (async_mode_) {
         enqueueAsync(std::move(entry));
@@ -294,14 +738,27 @@ void LoggerCore::logBinary(const void* data, size_t size, const std::string& tag
     }
 }
 
+bool LoggerCore::appendDirectBinary(const void* data, size_t size, const std::string& tag) {
+    bool queued = false;
+    uint64_t ts = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    for (ILogSink* sink : routes_.route(EntryKind::Binary, tag)) {
+        if (sink->appendsConcurrently()) {
+            sink->writeBinary(static_cast<const uint8_t*>(data), size, tag, ts);
+        } else {
+            queued = true;
+        }
+    }
+    return queued;
+}
+
 void LoggerCore::recordMessage(const std::string& topic, const std::string& type,
                                const std::vector<uint8_t>& data) {
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-    
-    auto entry = std::make_unique<MessageLogEntry>(
-        topic, type, data, timestamp
-    );
+    LogEntry entry;
+    entry.kind = EntryKind::Message;
+    entry.tick_ns = MonotonicClock::now();
+    entry.assign(pool_, {topic, type,
+        std::string_view(reinterpret_cast<const char*>(data.data()), data.size())});
     
     if (async_mode_) {
         enqueueAsync(std::move(entry));
@@ -310,86 +767,346 @@ void LoggerCore::recordMessage(const std::string& topic, const std::string& type
     }
 }
 
-void LoggerCore::processEntry(std::unique_ptr<ILogEntry> entry) {
-    if (!entry) return;
-    
+void LoggerCore::processEntry(LogEntry&& entry) {
     // 同步模式直接写入，使用独立的锁
     std::lock_guard<std::mutex> lock(sync_write_mtx_);
-    entry->writeTo(sinks_);
+    sync_batch_.add(entry, routes_, console_.get());
+    sync_batch_.flush();
+    if (console_) {
+        console_->flush();
+    }
+}
+
+void LoggerCore::dispatchBatch(std::vector<LogEntry>& batch) {
+    for (const auto& entry : batch) {
+        worker_batch_.add(entry, routes_, console_.get());
+    }
+    worker_batch_.flush();
+    if (console_) {
+        console_->flush();
+    }
+    // 条目（及其溢出缓冲）在批量写完之后才释放
+    batch.clear();
+}
+
+void LoggerCore::enqueueAsync(LogEntry&& entry) {
+    if (!enterProducer()) {
+        // 重配置中：队列可能被替换，改为同步写入
+        processEntry(std::move(entry));
+        return;
+    }
+    if (queue_mode_.load(std::memory_order_relaxed) == AsyncQueueMode::PerThread) {
+        enqueuePerThread(std::move(entry));
+    } else {
+        enqueueShared(std::move(entry));
+    }
+    leaveProducer();
+}
+
+void LoggerCore::enqueueShared(LogEntry&& entry) {
+    while (!queue_->tryPush(entry)) {
+        switch (overflow_policy_) {
+            case OverflowPolicy::DropOldest: {
+                // 与消费者竞争弹出队头，腾出一个槽位后重试
+                LogEntry victim;
+                if (queue_->tryPop(victim)) {
+                    noteDrop();
+                }
+                break;
+            }
+            case OverflowPolicy::DropNewest:
+                noteDrop();
+                return;
+            case OverflowPolicy::Block:
+                if (stop_ || quiescing_.load(std::memory_order_relaxed)) {
+                    // 工作线程正在退出或正在重配置，退化为同步写入，避免永久等待
+                    processEntry(std::move(entry));
+                    return;
+                }
+                wakeWorker();
+                std::this_thread::yield();
+                break;
+        }
+    }
+    
+    // 与工作线程的 "置休眠标志 → 复查队列" 构成 Dekker 式握手
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker_sleeping_.load(std::memory_order_relaxed)) {
+        wakeWorker();
+    }
 }
 
-void LoggerCore::enqueueAsync(std::unique_ptr<ILogEntry> entry) {
-    if (!entry) return;
+void LoggerCore::enqueuePerThread(LogEntry&& entry) {
+    ThreadLogBuffer& buf = localBuffer();
+    
+    uint64_t tick = entry.tick();
+    while (!buf.ring.tryPush(entry)) {
+        switch (overflow_policy_) {
+            case OverflowPolicy::DropOldest:
+                // SPSC 缓冲只有消费者能弹出队头，生产者无法淘汰旧条目，
+                // 因此在该模式下退化为丢弃新条目
+            case OverflowPolicy::DropNewest:
+                noteDrop();
+                return;
+            case OverflowPolicy::Block:
+                if (stop_ || quiescing_.load(std::memory_order_relaxed)) {
+                    buf.waiting.store(false, std::memory_order_release);
+                    processEntry(std::move(entry));
+                    return;
+                }
+                buf.waiting.store(true, std::memory_order_seq_cst);
+                wakeWorker();
+                std::this_thread::yield();
+                break;
+        }
+    }
+    buf.last_tick.store(tick, std::memory_order_release);
+    if (buf.waiting.load(std::memory_order_relaxed)) {
+        buf.waiting.store(false, std::memory_order_release);
+    }
     
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker_sleeping_.load(std::memory_order_relaxed)) {
+        wakeWorker();
+    } else if (buf.wake_on_push.load(std::memory_order_relaxed)) {
+        buf.wake_on_push.store(false, std::memory_order_relaxed);
+        wakeWorker();
+    }
+}
+
+ThreadLogBuffer& LoggerCore::localBuffer() {
+    ThreadBufferHandle& h = t_buffer_handle;
+    uint64_t gen = buffer_generation_.load(std::memory_order_acquire);
+    if (h.buffer && h.generation == gen) {
+        return *h.buffer;
+    }
+    
+    // 首次写日志或配置换代：注册新缓冲，旧缓冲交给工作线程排空后回收
+    if (h.buffer) {
+        h.buffer->closed.store(true, std::memory_order_release);
+    }
     {
-        std::lock_guard<std::mutex> lock(queue_mtx_);
-        if (queue_.size() >= max_queue_size_) {
-            queue_.pop();
-            static size_t drop_count = 0;
-            if (++drop_count % 1000 == 0) {
-                std::cerr << "[Logger] Queue overflow, dropped " 
-                          << drop_count << " entries" << std::endl;
+        std::lock_guard<std::mutex> lock(registry_mtx_);
+        h.buffer = std::make_shared<ThreadLogBuffer>(thread_queue_size_);
+        thread_buffers_.push_back(h.buffer);
+    }
+    h.generation = gen;
+    registry_version_.fetch_add(1, std::memory_order_release);
+    return *h.buffer;
+}
+
+void LoggerCore::refreshMergeBuffers() {
+    uint64_t version = registry_version_.load(std::memory_order_acquire);
+    if (version == merge_version_) return;
+    
+    std::lock_guard<std::mutex> lock(registry_mtx_);
+    merge_buffers_ = thread_buffers_;
+    merge_version_ = version;
+}
+
+size_t LoggerCore::mergeThreadBuffers(std::vector<LogEntry>& out,
+                                      size_t max_count, bool release_all) {
+    merge_release_ns_ = 0;
+    merge_limiter_.reset();
+    refreshMergeBuffers();
+    if (merge_buffers_.empty() || max_count == 0) return 0;
+    
+    // 水位线：各存活缓冲此后入队的条目都不会早于它。单线程内时间戳单调，
+    // 缓冲的下界是它最近入队的时间戳；其余线程的下界按乱序窗口推进，避免空闲线程挡住归并。
+    // 先取当前时刻再读各缓冲，打完时间戳后窗口内入队的条目都不会落在水位线之下；
+    // 等待空位的生产者不受窗口限制，它手中的条目入队前水位线停在它的下界
+    uint64_t now = MonotonicClock::now();
+    uint64_t idle_floor = now > merge_window_ns_ ? now - merge_window_ns_ : 0;
+    uint64_t watermark = UINT64_MAX;
+    const std::shared_ptr<ThreadLogBuffer>* limiter = nullptr;
+    for (const auto& buf : merge_buffers_) {
+        // 已关闭的缓冲不会再有新条目
+        if (buf->closed.load(std::memory_order_acquire)) continue;
+        bool waiting = buf->waiting.load(std::memory_order_acquire);
+        uint64_t tick = buf->last_tick.load(std::memory_order_acquire);
+        uint64_t bound = waiting ? tick : std::max(tick, idle_floor);
+        if (bound < watermark) {
+            watermark = bound;
+            // 下界来自该线程自己的时间戳时，它再次入队即可推进水位线
+            limiter = (waiting || tick >= idle_floor) ? &buf : nullptr;
+        }
+    }
+    
+    // 以各缓冲的队头时间戳建小顶堆，做 k 路归并
+    using HeadRef = std::pair<uint64_t, size_t>;
+    std::priority_queue<HeadRef, std::vector<HeadRef>, std::greater<HeadRef>> heads;
+    for (size_t i = 0; i < merge_buffers_.size(); ++i) {
+        if (auto* front = merge_buffers_[i]->ring.front()) {
+            heads.emplace(front->tick(), i);
+        }
+    }
+    
+    size_t n = 0;
+    bool saw_closed = false;
+    while (n < max_count && !heads.empty()) {
+        if (!release_all && heads.top().first > watermark) {
+            // 更早的条目可能还在较慢的线程手里：留在缓冲中，最迟出窗时放行
+            merge_release_ns_ = heads.top().first + merge_window_ns_;
+            if (limiter) {
+                merge_limiter_ = *limiter;
+                merge_limiter_tick_ = watermark;
             }
+            break;
         }
+        size_t i = heads.top().second;
+        heads.pop();
         
-        queue_.push(std::move(entry));
+        auto& ring = merge_buffers_[i]->ring;
+        out.push_back(std::move(*ring.front()));
+        ring.pop();
+        ++n;
+        
+        if (auto* front = ring.front()) {
+            heads.emplace(front->tick(), i);
+        }
+    }
+    
+    for (const auto& buf : merge_buffers_) {
+        if (buf->closed.load(std::memory_order_relaxed)) {
+            saw_closed = true;
+            break;
+        }
+    }
+    if (saw_closed) {
+        reclaimThreadBuffers();
+    }
+    return n;
+}
+
+void LoggerCore::reclaimThreadBuffers() {
+    // closed 以 release 写入，先读到 closed 再判空，保证看见该线程最后一次写入
+    auto drained = [](const std::shared_ptr<ThreadLogBuffer>& buf) {
+        return buf->closed.load(std::memory_order_acquire) && buf->ring.emptyApprox();
+    };
+    
+    {
+        std::lock_guard<std::mutex> lock(registry_mtx_);
+        thread_buffers_.erase(
+            std::remove_if(thread_buffers_.begin(), thread_buffers_.end(), drained),
+            thread_buffers_.end());
+        merge_buffers_ = thread_buffers_;
+    }
+    merge_version_ = registry_version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+bool LoggerCore::threadBuffersEmpty() {
+    refreshMergeBuffers();
+    for (const auto& buf : merge_buffers_) {
+        if (!buf->ring.emptyApprox()) return false;
+    }
+    return true;
+}
+
+bool LoggerCore::enterProducer() {
+    // 与 quiesceProducers 的 "置标志 → 查计数" 构成 Dekker 式握手：
+    // 要么重配置方看到本生产者在途，要么本生产者看到重配置标志
+    producers_.fetch_add(1, std::memory_order_seq_cst);
+    if (!quiescing_.load(std::memory_order_seq_cst)) {
+        return true;
+    }
+    leaveProducer();
+    return false;
+}
+
+void LoggerCore::leaveProducer() {
+    producers_.fetch_sub(1, std::memory_order_release);
+}
+
+void LoggerCore::quiesceProducers() {
+    quiescing_.store(true, std::memory_order_seq_cst);
+    while (producers_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
     }
+}
+
+void LoggerCore::resumeProducers() {
+    quiescing_.store(false, std::memory_order_release);
+}
+
+void LoggerCore::wakeWorker() {
+    std::lock_guard<std::mutex> lock(wake_mtx_);
     cv_.notify_one();
 }
 
+void LoggerCore::noteDrop() {
+    size_t n = drop_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (n % 1000 == 0) {
+        std::cerr << "[Logger] Queue overflow, dropped " 
+                  << n << " entries" << std::endl;
+    }
+}
+
 void LoggerCore::processAsyncQueue() {
-    std::vector<std::unique_ptr<ILogEntry>> batch;
-    batch.reserve(100); 
+    std::vector<LogEntry> batch;
+    batch.reserve(kDrainBatch);
     while (!stop_) {
-        // 等待数据或停止信号
-        {
-            std::unique_lock<std::mutex> lock(queue_mtx_);
-            cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
-                return !queue_.empty() || stop_;
-            });
-            
-            while (!queue_.empty() && batch.size() < 100) {
-                batch.push_back(std::move(queue_.front()));
-                queue_.pop();
+        // 批量取出，不持有任何锁；两种拓扑都轮询，保证运行时切换不丢条目
+        size_t n = queue_->popBulk(std::back_inserter(batch), kDrainBatch);
+        n += mergeThreadBuffers(batch, kDrainBatch - n);
+        
+        if (n == 0 && merge_release_ns_ != 0) {
+            // 只剩被水位线挡住的条目：睡到最早的条目出窗，或卡住水位线的线程再次入队；
+            // 其他生产者入队不会推进水位线，不必唤醒工作线程
+            auto limiter = std::move(merge_limiter_);
+            auto advanced = [this, &limiter] {
+                return limiter && limiter->last_tick.load(std::memory_order_seq_cst) != merge_limiter_tick_;
+            };
+            if (limiter) {
+                // 与生产者的 "写 last_tick → 查唤醒标志" 构成 Dekker 式握手
+                limiter->wake_on_push.store(true, std::memory_order_seq_cst);
             }
+            uint64_t now = MonotonicClock::now();
+            // 卡住水位线的是等待空位的生产者时不受窗口限制，只能等它入队
+            uint64_t wait_ns = merge_release_ns_ > now
+                ? merge_release_ns_ - now : std::max<uint64_t>(merge_window_ns_, 1000000);
+            if (!advanced() && queue_->emptyApprox()) {
+                std::unique_lock<std::mutex> lock(wake_mtx_);
+                cv_.wait_for(lock, std::chrono::nanoseconds(wait_ns), [this, &advanced] {
+                    return !queue_->emptyApprox() || stop_.load() || advanced();
+                });
+            }
+            if (limiter) {
+                limiter->wake_on_push.store(false, std::memory_order_relaxed);
+            }
+            continue;
         }
-        
-        // 在锁外处理数据（提高并发性能）
-        for (auto& entry : batch) {
-            if (entry) {
-                entry->writeTo(sinks_);
+        if (n == 0) {
+            // 队列为空：先声明休眠，再复查一次，防止丢失唤醒
+            worker_sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue_->emptyApprox() && threadBuffersEmpty() && !stop_) {
+                std::unique_lock<std::mutex> lock(wake_mtx_);
+                cv_.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                    return !queue_->emptyApprox() || !threadBuffersEmpty() || stop_;
+                });
             }
+            worker_sleeping_.store(false, std::memory_order_relaxed);
+            // 空闲时补做按时间的刷新，避免低流量下数据长期滞留在用户态缓冲
+            for (auto& [name, sink] : sinks_) {
+                sink->flushIfDue();
+            }
+            continue;
         }
-        batch.clear();
+        
+        dispatchBatch(batch);
     }
     
     // 处理残留数据
-    std::lock_guard<std::mutex> lock(queue_mtx_);
-    while (!queue_.empty()) {
-        auto& entry = queue_.front();
-        if (entry) {
-            entry->writeTo(sinks_);
-        }
-        queue_.pop();
-    }
+    drainQueue();
 }
 
-std::string LoggerCore::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&t);
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
-}
-
-std::string LoggerCore::logLevelToString(LogLevel level) {
-    switch (level) {
-        case LogLevel::DEBUG: return "DEBUG";
-        case LogLevel::INFO: return "INFO";
-        case LogLevel::WARNING: return "WARNING";
-        case LogLevel::ERROR: return "ERROR";
-        case LogLevel::CRITICAL: return "CRITICAL";
-        default: return "UNKNOWN";
+void LoggerCore::drainQueue() {
+    std::vector<LogEntry> batch;
+    batch.reserve(kDrainBatch);
+    while (queue_->popBulk(std::back_inserter(batch), kDrainBatch) > 0) {
+        dispatchBatch(batch);
+    }
+    while (mergeThreadBuffers(batch, kDrainBatch, true) > 0) {
+        dispatchBatch(batch);
     }
-}
\ No newline at end of file
+}
@@ -11,64 +11,188 @@
 #include <chrono>
 #include <filesystem>
 #include "../../include/logger/LoggerConfig.h"
-#include <queue>
+#include "../../include/logger/LogLevelGate.h"
+#include "../../include/logger/LogFormat.h"
+#include "MpmcRingBuffer.h"
+#include "SpscRingBuffer.h"
+#include "SlabPool.h"
+#include "Timestamp.h"
+#include <string_view>
+#include <initializer_list>
+#include <array>
 class LoggerCore;
+class ConsoleSink;
 
 
 
-class ILogEntry {
+// 条目类型标签（替代 ILogEntry 继承体系）
+enum class EntryKind : uint8_t {
+    Text,       // 段0 = 消息
+    Binary,     // 段0 = tag，段1 = 数据
+    Message,    // 段0 = topic，段1 = type，段2 = 数据
+    Compact     // 段0 = u32 调用点 id + 参数原始字节（compact_text 模式）
+};
+constexpr size_t kEntryKindCount = 4;
+
+/**
+ * @brief 初始化时解析好的 Sink 路由表，分发时按 EntryKind 下标取目标列表
+ *
+ * Binary/Message 条目可按 tag/topic 定向到专用模块（如每个大流量 topic 一个 bag），
+ * 未被任何模块认领的 tag/topic 落到该类型下未声明 topics 的模块。
+ * 表内只存裸指针，Sink 的所有权在 LoggerCore::sinks_。
+ */
+class RoutingTable {
 public:
-    virtual ~ILogEntry() = default;
-    // 纯虚函数：每种条目自己决定如何写入
-    virtual void writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) = 0; 
-    // 估算大小（用于磁盘空间检查）
-    virtual size_t estimateSize() const { return 0; }
+    using SinkList = std::vector<ILogSink*>;
+    
+    void clear();
+    void add(EntryKind kind, ILogSink* sink, const std::vector<std::string>& topics);
+    bool has(EntryKind kind) const;
+    
+    // key 为 tag/topic；专用模块很少，线性比较即可
+    const SinkList& route(EntryKind kind, std::string_view key = {}) const {
+        const KindRoutes& r = kinds_[static_cast<size_t>(kind)];
+        for (const auto& [topic, sinks] : r.keyed) {
+            if (topic == key) return sinks;
+        }
+        return r.fallback;
+    }
+    
+private:
+    struct KindRoutes {
+        SinkList fallback;
+        std::vector<std::pair<std::string, SinkList>> keyed;
+    };
+    std::array<KindRoutes, kEntryKindCount> kinds_;
 };
-class TextLogEntry : public ILogEntry {
+
+// 渲染一行文本日志（LogEntry 与紧凑段解码器共用，保证输出一致）
+void appendTextLine(std::string& out, TimestampFormatter& timestamps, uint64_t wall_ns,
+                    LogLevel level, std::string_view file, int line,
+                    std::string_view function, std::string_view message);
+
+/**
+ * @brief 定长日志条目（按值存放在环形队列槽位中）
+ *
+ * 小负载直接存放在内联区；超出部分从 SlabPool 取溢出缓冲，
+ * 工作线程写完后随条目析构归还。file/function 只保存指向
+ * __FILE__/__FUNCTION__ 等静态字面量的指针，不做拷贝。
+ */
+class LogEntry {
 public:
-    LogLevel level;
-    std::string message;
-    std::string file;
-    std::string function;
-    std::string timestamp;
-    int line;
+    static constexpr size_t kInlineCapacity = 176;
+    static constexpr size_t kMaxSegments = 3;
 
+    LogEntry() = default;
+    ~LogEntry() { releaseOverflow(); }
+    LogEntry(LogEntry&& other) noexcept { moveFrom(other); }
+    LogEntry& operator=(LogEntry&& other) noexcept {
+        if (this != &other) {
+            releaseOverflow();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    LogEntry(const LogEntry&) = delete;
+    LogEntry& operator=(const LogEntry&) = delete;
 
-    TextLogEntry(LogLevel level, std::string message, std::string file, 
-                 std::string function, std::string timestamp, int line)
-        : level(level), message(std::move(message)), file(std::move(file)), 
-          function(std::move(function)), timestamp(std::move(timestamp)), line(line) {}
+    // 把各段数据拷入内联区（放不下时使用池化溢出缓冲）
+    void assign(SlabPool& pool, std::initializer_list<std::string_view> segments);
+    // 预留单段空间供格式化器直接写入，写完后用 commit 记录实际长度
+    char* reserve(SlabPool& pool, size_t capacity);
+    void commit(size_t len) { seg_len_[0] = static_cast<uint32_t>(len); }
+    std::string_view segment(size_t i) const;
+    size_t payloadSize() const;
 
-    void writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) override;
-    size_t estimateSize() const override { return message.size() + 128; }
+    // 估算大小（用于磁盘空间检查）
+    size_t estimateSize() const { return payloadSize() + 128; }
+    // 产生时刻（单调时钟纳秒），用于多线程缓冲的时间戳归并
+    uint64_t tick() const { return tick_ns; }
+
+    EntryKind kind = EntryKind::Text;
+    LogLevel level = LogLevel::INFO;
+    int line = 0;
+    uint64_t tick_ns = 0;   // 生产者只记录单调刻度，墙钟换算在消费者侧
+    const char* file = "";
+    const char* function = "";
+
+private:
+    const char* payload() const { return overflow_ ? overflow_ : inline_; }
+    void releaseOverflow();
+    void moveFrom(LogEntry& other);
+
+    uint32_t seg_len_[kMaxSegments] = {};
+    uint32_t overflow_cap_ = 0;
+    SlabPool* pool_ = nullptr;
+    char* overflow_ = nullptr;
+    char inline_[kInlineCapacity];
 };
-class BinaryLogEntry : public ILogEntry {
+static_assert(sizeof(LogEntry) <= 256, "LogEntry should fit in four cache lines");
+
+/**
+ * @brief 消费者侧的批量分发器
+ *
+ * 先把一批条目渲染并按目标 Sink 归组，再对每个 Sink 调用一次 write*Batch
+ * （一次加锁、一次轮转检查、一次连续写）。记录视图指向条目自身或内部缓冲，
+ * 调用方须保证条目在 flush 返回前有效。同步路径与工作线程各持一份，非线程安全。
+ */
+class BatchDispatcher {
 public:
-    std::vector<uint8_t> data;
-    std::string tag;
-    uint64_t timestamp;
-    // 默认构造函数
-    
-    BinaryLogEntry(const std::vector<uint8_t>& data,const std::string& tag, uint64_t timestamp):
-    data(data), tag(tag), timestamp(timestamp) {}
-    void writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) override;
-    size_t estimateSize() const override { return data.size() + tag.size() + 16; }
+    void setPrecision(TimestampPrecision precision) { timestamps_.setPrecision(precision); }
+    
+    // console 为空表示控制台输出已关闭；路由表须在 flush 前保持不变
+    void add(const LogEntry& entry, const RoutingTable& routes, ConsoleSink* console);
+    void flush();
+    
+private:
+    template <typename Record>
+    struct SinkRecords {
+        ILogSink* sink = nullptr;
+        std::vector<Record> records;
+    };
+    
+    struct TextSpan {
+        size_t begin;
+        size_t len;
+        LogLevel level;
+    };
+    
+    // 按 Sink 归组；分组对象跨批次复用，只增不缩
+    template <typename Record>
+    static void group(std::vector<SinkRecords<Record>>& groups, size_t& used,
+                      ILogSink* sink, const Record& record);
+    
+    WallClock clock_;                // 单调刻度 → 墙钟
+    TimestampFormatter timestamps_;  // 按秒缓存的时间前缀
+    
+    // 文本行都渲染进同一块缓冲，flush 时再生成视图（避免扩容使视图失效）
+    std::string text_buf_;
+    std::vector<TextSpan> text_spans_;
+    std::vector<TextRecord> text_records_;
+    const RoutingTable::SinkList* text_targets_ = nullptr;
+    
+    std::vector<SinkRecords<BinaryRecord>> binary_;
+    std::vector<SinkRecords<MessageRecord>> message_;
+    std::vector<SinkRecords<CompactRecord>> compact_;
+    size_t binary_used_ = 0;
+    size_t message_used_ = 0;
+    size_t compact_used_ = 0;
 };
 
-
-class MessageLogEntry : public ILogEntry {
-public:
-    std::string topic;
-    std::string type;
-    std::vector<uint8_t> data;
-    uint64_t timestamp;
-    MessageLogEntry(const std::string& topic, const std::string& type,
-             const std::vector<uint8_t>& data, uint64_t timestamp)
-    : topic(topic), type(type), data(data), timestamp(timestamp) {}
-
-    void writeTo(const std::map<std::string, std::shared_ptr<ILogSink>>& sinks) override;
-    size_t estimateSize() const override { return data.size() + topic.size() + type.size() + 16; }
+// 生产者线程私有的 SPSC 缓冲（PerThread 模式）
+struct ThreadLogBuffer {
+    explicit ThreadLogBuffer(size_t capacity) : ring(capacity) {}
+    SpscRingBuffer<LogEntry> ring;
+    // 线程退出（或缓冲换代）后置位；消费者排空后回收
+    std::atomic<bool> closed{false};
+    // 最近一次入缓冲的条目时间戳（单线程内单调），消费者据此计算归并水位线
+    std::atomic<uint64_t> last_tick{0};
+    // Block 策略下生产者正等待空位：手中条目的时间戳不早于 last_tick，归并不得越过它
+    std::atomic<bool> waiting{false};
+    // 工作线程因本缓冲卡住水位线而休眠：下次入队后唤醒它
+    std::atomic<bool> wake_on_push{false};
 };
+
 struct SinkConfig {
     std::string module_name;
     std::string pattern;
@@ -111,10 +235,16 @@ public:
     void setAsyncMode(bool enable);
     void reloadConfig(const std::string& config_path);
     
+    // 刷新所有 Sink 的文件缓冲（异步队列中尚未写出的条目不在此列）
+    void flush();
     
     // 写文本日志
-    void log(LogLevel level, const std::string& message,
-            const std::string& file, const std::string& function, int line);
+    void log(LogLevel level, std::string_view message,
+            const char* file, const char* function, int line);
+    
+    // 写格式化文本日志：直接格式化（或紧凑编码）进条目存储
+    void logFormatted(logger::fmt::CallSite& site, const logger::fmt::FormatOps& ops,
+                      const void* ctx);
     
     // 写二进制日志
     void logBinary(const void* data, size_t size, const std::string& tag = "binary");
@@ -126,6 +256,8 @@ public:
     ~LoggerCore();
     //查询当前配置
     LoggerConfig getCurrentConfig() const;
+    // 共享异步队列的实际容量（向上取整为 2 的幂）
+    size_t queueCapacity() const;
     
 private:
     LoggerCore();
@@ -134,37 +266,94 @@ private:
     
 
     // 核心写入逻辑（同步）
-    void processEntry(std::unique_ptr<ILogEntry> entry);
+    void processEntry(LogEntry&& entry);
+    // 工作线程写出一批条目（含控制台的一次 writev）
+    void dispatchBatch(std::vector<LogEntry>& batch);
     
     // 异步队列管理
-    void enqueueAsync(std::unique_ptr<ILogEntry> entry);
+    void enqueueAsync(LogEntry&& entry);
+    void enqueueShared(LogEntry&& entry);
+    void enqueuePerThread(LogEntry&& entry);
+    ThreadLogBuffer& localBuffer();
     void processAsyncQueue();
+    // 只取出不晚于水位线的条目；release_all 时（排空）忽略水位线
+    size_t mergeThreadBuffers(std::vector<LogEntry>& out, size_t max_count,
+                              bool release_all = false);
+    void refreshMergeBuffers();
+    void reclaimThreadBuffers();
+    bool threadBuffersEmpty();
+    void drainQueue();
+    void wakeWorker();
+    void noteDrop();
     
-    // 辅助函数
-    std::string getCurrentTime();
-    std::string logLevelToString(LogLevel level);
+    // 映射段 Sink 在调用线程上直写；返回是否还有需要入队的普通 Sink
+    bool appendDirectBinary(const void* data, size_t size, const std::string& tag);
+    
+    // 生产者准入：直接访问队列或直写 Sink 的生产者登记在途，重配置前等待它们全部离开
+    bool enterProducer();
+    void leaveProducer();
+    void quiesceProducers();
+    void resumeProducers();
+
     // 成员变量
-    std::map<std::string, std::shared_ptr<ILogSink>> sinks_;
+    std::map<std::string, std::shared_ptr<ILogSink>> sinks_;  // 按模块名持有
+    RoutingTable routes_;
+    std::shared_ptr<ConsoleSink> console_;  // 不属于任何文件模块，按批次 writev
     LoggerConfig current_config_;
-    std::atomic<LogLevel> current_level_{LogLevel::INFO};
     
-    // 异步模式
-    std::atomic<bool> async_mode_{false};
-    std::atomic<bool> stop_{false};
+    // 生产者热路径只读的原子变量，独占一个缓存行
+    // （级别过滤使用 logger::g_level_gate，宏可在头文件内联读取）
+    alignas(kCacheLineSize) std::atomic<bool> async_mode_{false};
+    std::atomic<AsyncQueueMode> queue_mode_{AsyncQueueMode::Shared};
+    std::atomic<bool> compact_text_{false};
+    std::atomic<bool> direct_binary_{false};   // 存在可由生产者直接写入的 binary Sink
+    std::atomic<bool> quiescing_{false};       // 重配置中：生产者改走同步路径
+    
+    // 工作线程控制标志（仅启停时写入）
+    alignas(kCacheLineSize) std::atomic<bool> stop_{false};
     std::thread worker_;
     
+    // 工作线程空闲标志：生产者仅在其为 true 时才去唤醒
+    alignas(kCacheLineSize) std::atomic<bool> worker_sleeping_{false};
     
+    // 溢出丢弃计数（仅在队列满时写入）
+    alignas(kCacheLineSize) std::atomic<size_t> drop_count_{0};
     
-
-
-    // 双缓冲（正确实现）
-    std::queue<std::unique_ptr<ILogEntry>> queue_;
+    // 正在访问队列或直写 Sink 的生产者数
+    alignas(kCacheLineSize) std::atomic<size_t> producers_{0};
+    
+    // 溢出缓冲池：必须先于所有持有条目的队列构造、后于它们析构
+    SlabPool pool_;
+    
+    // 无锁有界队列（替代 mutex + std::queue），按值存放条目；
+    // 容量与策略须先于 queue_ 声明，构造函数按它们建队列
     size_t max_queue_size_ = 10000;
-    std::mutex queue_mtx_;
+    OverflowPolicy overflow_policy_ = OverflowPolicy::DropOldest;
+    std::unique_ptr<MpmcRingBuffer<LogEntry>> queue_;
+    static constexpr size_t kDrainBatch = 256;
+    
+    // PerThread 模式：各线程缓冲的注册表（仅注册/回收时加锁）
+    size_t thread_queue_size_ = 4096;
+    std::atomic<uint64_t> buffer_generation_{1};
+    std::vector<std::shared_ptr<ThreadLogBuffer>> thread_buffers_;
+    std::mutex registry_mtx_;
+    std::atomic<uint64_t> registry_version_{0};
+    // 工作线程私有的注册表快照，版本变化时才重新加锁拷贝
+    std::vector<std::shared_ptr<ThreadLogBuffer>> merge_buffers_;
+    uint64_t merge_version_ = 0;
+    uint64_t merge_window_ns_ = 10000000;   // 乱序窗口（仅在工作线程停止时修改）
+    uint64_t merge_release_ns_ = 0;         // 被水位线挡住的最早条目的放行时刻，0 表示没有
+    std::shared_ptr<ThreadLogBuffer> merge_limiter_;   // 以最近入队时间戳卡住水位线的缓冲
+    uint64_t merge_limiter_tick_ = 0;
+    
+    // 仅用于空闲时的休眠/唤醒，不在入队路径上加锁
+    std::mutex wake_mtx_;
     std::condition_variable cv_;
     
     // 同步写入锁（与异步分离）
     std::mutex sync_write_mtx_;
+    BatchDispatcher sync_batch_;   // 同步路径的分发器（受 sync_write_mtx_ 保护）
+    BatchDispatcher worker_batch_; // 工作线程的分发器
     mutable std::mutex config_mtx_;
 
 };
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 缓存行大小（x86/ARM 常见值），用于隔离高频写入的原子变量
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * @brief 有界无锁多生产者多消费者环形队列（Vyukov 序列号槽位算法）
+ *
+ * 每个槽位带一个序列号：
+ *   seq == pos        → 槽位空闲，可被位置为 pos 的生产者写入
+ *   seq == pos + 1    → 槽位已写入，可被位置为 pos 的消费者读取
+ * head_/tail_ 分别独占一个缓存行，避免生产者与消费者互相伪共享。
+ * 容量向上取整为 2 的幂。
+ */
+template <typename T>
+class MpmcRingBuffer {
+public:
+    explicit MpmcRingBuffer(size_t capacity)
+        : capacity_(capacityFor(capacity)),
+          mask_(capacity_ - 1),
+          slots_(new Slot[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+    MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+    // 尝试入队，队列满时返回 false（value 保持不变）
+    bool tryPush(T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // 已满
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 尝试出队，队列空时返回 false
+    bool tryPop(T& out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(slot.value);
+                    slot.seq.store(pos + capacity_, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // 为空
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 批量出队：最多取 max_count 个，返回实际数量
+    template <typename OutputIt>
+    size_t popBulk(OutputIt out, size_t max_count) {
+        size_t n = 0;
+        T tmp;
+        while (n < max_count && tryPop(tmp)) {
+            *out++ = std::move(tmp);
+            ++n;
+        }
+        return n;
+    }
+
+    // 近似长度（并发下仅作参考）
+    size_t sizeApprox() const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+    size_t capacity() const { return capacity_; }
+    // 按请求容量构造时的实际容量
+    static size_t capacityFor(size_t requested) { return roundUpPow2(requested < 2 ? 2 : requested); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t roundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    char pad_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+};
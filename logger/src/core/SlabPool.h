@@ -0,0 +1,70 @@
+#pragma once
+#include "MpmcRingBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 按尺寸分级的溢出缓冲池（供超出内联容量的日志条目使用）
+ *
+ * 生产者 acquire，工作线程写完条目后 release；每级一个无锁空闲链表，
+ * 稳态下缓冲在两端之间循环复用，不再触发堆分配。
+ * 超过最大级别的请求直接走 new/delete。
+ */
+class SlabPool {
+public:
+    static constexpr size_t kClassCount = 5;
+    static constexpr uint32_t kClassSizes[kClassCount] = {512, 2048, 8192, 32768, 131072};
+    static constexpr size_t kClassDepth[kClassCount] = {1024, 256, 64, 16, 8};
+
+    SlabPool() {
+        for (size_t i = 0; i < kClassCount; ++i) {
+            free_[i] = std::make_unique<MpmcRingBuffer<char*>>(kClassDepth[i]);
+        }
+    }
+
+    ~SlabPool() {
+        for (auto& list : free_) {
+            char* p = nullptr;
+            while (list->tryPop(p)) {
+                delete[] p;
+            }
+        }
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // 取一块至少 bytes 大小的缓冲，capacity 返回实际容量（release 时原样传回）
+    char* acquire(size_t bytes, uint32_t& capacity) {
+        int cls = classFor(bytes);
+        if (cls < 0) {
+            capacity = static_cast<uint32_t>(bytes);
+            return new char[bytes];
+        }
+        capacity = kClassSizes[cls];
+        char* p = nullptr;
+        if (free_[cls]->tryPop(p)) {
+            return p;
+        }
+        return new char[capacity];
+    }
+
+    void release(char* p, uint32_t capacity) {
+        if (!p) return;
+        int cls = classFor(capacity);
+        if (cls < 0 || kClassSizes[cls] != capacity || !free_[cls]->tryPush(p)) {
+            delete[] p;  // 超大块或空闲链表已满
+        }
+    }
+
+private:
+    static int classFor(size_t bytes) {
+        for (size_t i = 0; i < kClassCount; ++i) {
+            if (bytes <= kClassSizes[i]) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    std::unique_ptr<MpmcRingBuffer<char*>> free_[kClassCount];
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "MpmcRingBuffer.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief 有界无锁单生产者单消费者环形队列
+ *
+ * 生产者只写 tail_，消费者只写 head_；双方各自缓存对端游标，
+ * 只有在缓存值显示 满/空 时才去读取对端的原子变量，减少跨核缓存行传输。
+ * 容量向上取整为 2 的幂。
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t capacity)
+        : capacity_(roundUpPow2(capacity < 2 ? 2 : capacity)),
+          mask_(capacity_ - 1),
+          slots_(new T[capacity_]) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // 生产者：尝试入队，满时返回 false（value 保持不变）
+    bool tryPush(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ >= capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ >= capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者：查看队头元素，空时返回 nullptr
+    T* front() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    // 消费者：弹出队头（必须先通过 front() 确认非空）
+    void pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    bool emptyApprox() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t roundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    // 消费者侧
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+
+    // 生产者侧
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+};
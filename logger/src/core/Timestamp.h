@@ -0,0 +1,111 @@
+#pragma once
+#include "../../include/logger/LoggerConfig.h"
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+/**
+ * @brief 日志时间戳：生产者只取单调时钟原始刻度，消费者负责换算与渲染
+ *
+ * CLOCK_MONOTONIC 走 vDSO，不进内核、不取 glibc 时区锁；
+ * 墙钟换算依赖 ClockAnchor（同一时刻采样的单调/墙钟值对）。
+ */
+class MonotonicClock {
+public:
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+};
+
+// 单调刻度与墙钟（纳秒，Unix 纪元）的对应关系；写入段文件头供离线换算
+struct ClockAnchor {
+    uint64_t mono_ns = 0;
+    uint64_t wall_ns = 0;
+
+    static ClockAnchor capture() {
+        timespec wall;
+        ClockAnchor a;
+        a.mono_ns = MonotonicClock::now();
+        clock_gettime(CLOCK_REALTIME, &wall);
+        a.wall_ns = static_cast<uint64_t>(wall.tv_sec) * 1000000000ull + static_cast<uint64_t>(wall.tv_nsec);
+        return a;
+    }
+
+    // 刻度可能早于锚点（条目在锚点采样前产生），按有符号差值换算
+    uint64_t toWall(uint64_t mono) const {
+        return wall_ns + static_cast<uint64_t>(static_cast<int64_t>(mono - mono_ns));
+    }
+};
+
+/**
+ * @brief 消费者侧的单调→墙钟换算器
+ *
+ * 周期性重新采样锚点，吸收 NTP 对墙钟的调整；非线程安全，
+ * 每个消费者上下文（同步路径 / 工作线程）各持一份。
+ */
+class WallClock {
+public:
+    static constexpr uint64_t kReanchorIntervalNs = 60ull * 1000000000ull;
+
+    uint64_t toWallNanos(uint64_t mono) {
+        if (anchor_.mono_ns == 0 || mono - anchor_.mono_ns > kReanchorIntervalNs) {
+            // 无符号比较：早于锚点的刻度差值极大，同样触发重采样
+            anchor_ = ClockAnchor::capture();
+        }
+        return anchor_.toWall(mono);
+    }
+
+private:
+    ClockAnchor anchor_;
+};
+
+/**
+ * @brief 文本时间戳渲染，按秒缓存 "YYYY-mm-dd HH:MM:SS" 前缀
+ *
+ * localtime_r/strftime 每秒最多调用一次，其余只追加小数部分。非线程安全。
+ */
+class TimestampFormatter {
+public:
+    explicit TimestampFormatter(TimestampPrecision precision = TimestampPrecision::Seconds)
+        : precision_(precision) {}
+
+    void setPrecision(TimestampPrecision precision) { precision_ = precision; }
+    TimestampPrecision precision() const { return precision_; }
+
+    void append(std::string& out, uint64_t wall_ns) {
+        int64_t sec = static_cast<int64_t>(wall_ns / 1000000000ull);
+        if (sec != cached_sec_) {
+            std::time_t t = static_cast<std::time_t>(sec);
+            std::tm tm{};
+            localtime_r(&t, &tm);
+            prefix_len_ = std::strftime(prefix_, sizeof(prefix_), "%Y-%m-%d %H:%M:%S", &tm);
+            cached_sec_ = sec;
+        }
+        out.append(prefix_, prefix_len_);
+
+        int digits = 0;
+        uint64_t frac = wall_ns % 1000000000ull;
+        switch (precision_) {
+            case TimestampPrecision::Seconds: return;
+            case TimestampPrecision::Millis: digits = 3; frac /= 1000000; break;
+            case TimestampPrecision::Micros: digits = 6; frac /= 1000; break;
+            case TimestampPrecision::Nanos: digits = 9; break;
+        }
+        char buf[10];
+        buf[0] = '.';
+        for (int i = digits; i > 0; --i) {
+            buf[i] = static_cast<char>('0' + frac % 10);
+            frac /= 10;
+        }
+        out.append(buf, static_cast<size_t>(digits) + 1);
+    }
+
+private:
+    TimestampPrecision precision_;
+    int64_t cached_sec_ = -1;
+    char prefix_[32] = {};
+    size_t prefix_len_ = 0;
+};
@@ -0,0 +1,207 @@
+#include "AdaptiveCompression.h"
+#include "CompressionPool.h"
+#include "DiskQuotaManager.h"
+#include "SegmentManifest.h"
+#include "TierMigrator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+// 各编解码器在 Store / Fast / High 档的级别；Balanced 用配置值
+int tierLevel(CompressionCodec codec, AdaptiveCompressionStrategy::Tier tier, int configured) {
+    using Tier = AdaptiveCompressionStrategy::Tier;
+    switch (tier) {
+        case Tier::Store:
+            return codec == CompressionCodec::Zstd ? -5 : codec == CompressionCodec::Lz4 ? -8 : -1;
+        case Tier::Fast:
+            return codec == CompressionCodec::Lz4 ? 0 : 1;
+        case Tier::Balanced:
+            return configured;
+        case Tier::High:
+            return codec == CompressionCodec::Zstd ? 19 : codec == CompressionCodec::Lz4 ? 12 : 9;
+    }
+    return configured;
+}
+
+size_t index(AdaptiveCompressionStrategy::Tier tier) {
+    return static_cast<size_t>(tier);
+}
+}  // namespace
+
+AdaptiveCompressionStrategy::AdaptiveCompressionStrategy(CompressionCodec codec, int level,
+                                                         int workers)
+    : AdaptiveCompressionStrategy(codec, level, workers, Options{}) {}
+
+AdaptiveCompressionStrategy::AdaptiveCompressionStrategy(CompressionCodec codec, int level,
+                                                         int workers, Options options)
+    : options_(std::move(options)) {
+    for (size_t i = 0; i < kTiers; ++i) {
+        tiers_[i] = makeCompressionStrategy(codec, tierLevel(codec, static_cast<Tier>(i), level),
+                                            workers);
+    }
+    if (!options_.load_probe) {
+        options_.load_probe = &AdaptiveCompressionStrategy::systemLoad;
+    }
+}
+
+std::string AdaptiveCompressionStrategy::compressedExtension() const {
+    return tiers_[0]->compressedExtension();
+}
+
+double AdaptiveCompressionStrategy::systemLoad() {
+    double avg[1] = {0};
+    if (::getloadavg(avg, 1) != 1) return 0;
+    return avg[0] / std::max(1u, std::thread::hardware_concurrency());
+}
+
+size_t AdaptiveCompressionStrategy::backlog() const {
+    size_t pending = CompressionPool::instance().pending();
+    return pending > 0 ? pending - 1 : 0;
+}
+
+AdaptiveCompressionStrategy::Tier AdaptiveCompressionStrategy::chooseTier(size_t backlog,
+                                                                          double load) const {
+    size_t busy = std::max<size_t>(1, CompressionPool::instance().threads() * options_.backlog_per_thread);
+    if (backlog >= 2 * busy || load >= 2 * options_.busy_load) return Tier::Store;
+    if (backlog >= busy || load >= options_.busy_load) return Tier::Fast;
+
+    // 按实测吞吐估算各档在 CPU 预算内的处理能力，跟不上到达速度就降档
+    double cores = CompressionPool::instance().cpuBudget();
+    if (cores <= 0) cores = static_cast<double>(CompressionPool::instance().threads());
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto keepsUp = [&](Tier tier) {
+        double throughput = stats_[index(tier)].throughput();
+        return throughput <= 0 || arrival_rate_ <= 0 || throughput * cores >= arrival_rate_;
+    };
+    if (!keepsUp(Tier::Balanced)) return Tier::Fast;
+    if (backlog == 0 && load < options_.idle_load && keepsUp(Tier::High)) return Tier::High;
+    return Tier::Balanced;
+}
+
+AdaptiveCompressionStrategy::TierStats AdaptiveCompressionStrategy::stats(Tier tier) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_[index(tier)];
+}
+
+size_t AdaptiveCompressionStrategy::pendingRecompress() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return lowered_.size();
+}
+
+bool AdaptiveCompressionStrategy::compressAt(Tier tier, const std::filesystem::path& src,
+                                             const std::filesystem::path& dst) {
+    std::error_code ec;
+    auto raw = std::filesystem::file_size(src, ec);
+    if (ec) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!tiers_[index(tier)]->compressTo(src, dst)) return false;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto packed = std::filesystem::file_size(dst, ec);
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto& s = stats_[index(tier)];
+    ++s.segments;
+    s.raw_bytes += raw;
+    s.packed_bytes += ec ? 0 : packed;
+    s.seconds += elapsed.count();
+    return true;
+}
+
+bool AdaptiveCompressionStrategy::compress(const std::filesystem::path& src) {
+    if (isCompressedExtension(src.extension())) {
+        bool ok = recompress(src);
+        maybeRecompressWhenIdle();
+        return ok;
+    }
+
+    std::error_code ec;
+    auto raw = std::filesystem::file_size(src, ec);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto now = std::chrono::steady_clock::now();
+        if (!ec && last_arrival_ != std::chrono::steady_clock::time_point{}) {
+            std::chrono::duration<double> gap = now - last_arrival_;
+            double rate = raw / std::max(gap.count(), 1e-3);
+            arrival_rate_ = arrival_rate_ > 0 ? 0.7 * arrival_rate_ + 0.3 * rate : rate;
+        }
+        last_arrival_ = now;
+    }
+
+    Tier tier = chooseTier(backlog(), options_.load_probe());
+    std::filesystem::path dst = src.string() + compressedExtension();
+    bool ok = compressAt(tier, src, dst);
+    if (ok && (tier == Tier::Store || tier == Tier::Fast)) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        lowered_.push_back(dst);
+    }
+    maybeRecompressWhenIdle();
+    return ok;
+}
+
+bool AdaptiveCompressionStrategy::recompress(const std::filesystem::path& packed) {
+    std::error_code ec;
+    if (!std::filesystem::exists(packed, ec)) {
+        return true;   // 已被保留数量或磁盘回收删除，或已迁往冷层
+    }
+    // 本任务已登记在压缩线程池，迁移线程不会再接手它；已在迁移的段放回队尾稍后再试
+    if (TierMigrator::instance().inFlight(packed)) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        lowered_.push_back(packed);
+        return true;
+    }
+    if (auto manifest = DiskQuotaManager::instance().manifestFor(packed.parent_path())) {
+        SegmentManifest::Segment seg;
+        if (!manifest->find(packed.stem().string(), seg) || seg.tier != 0) {
+            return true;
+        }
+    }
+
+    // 先解压到临时文件（启动时由 RollingFileManager 清理），再以高档压缩并原子覆盖原文件
+    std::string data;
+    if (!readSegmentFile(packed, data)) return false;
+    auto plain = compressionTempPath(packed.parent_path() / packed.stem());
+    {
+        std::ofstream out(plain, std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            out.close();
+            std::filesystem::remove(plain, ec);
+            return false;
+        }
+    }
+    if (!compressAt(Tier::High, plain, packed)) {
+        std::filesystem::remove(plain, ec);
+        return false;
+    }
+    return true;
+}
+
+void AdaptiveCompressionStrategy::maybeRecompressWhenIdle() {
+    if (backlog() != 0 || options_.load_probe() >= options_.idle_load) return;
+
+    std::filesystem::path next;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (lowered_.empty()) return;
+        next = lowered_.front();
+        lowered_.pop_front();
+    }
+    // 每次只排一个重新压缩任务，之后到达的新段最多在它后面等一个段；
+    // 完成后在段目录中记下新的大小，磁盘配额按它统计
+    if (auto self = weak_from_this().lock()) {
+        CompressionPool::instance().submit(next, self, [](const std::filesystem::path& packed, bool ok) {
+            auto manifest = DiskQuotaManager::instance().manifestFor(packed.parent_path());
+            std::error_code ec;
+            auto size = std::filesystem::file_size(packed, ec);
+            if (!ok || !manifest || ec) return;
+            manifest->update(packed.stem().string(), [&](SegmentManifest::Segment& seg) {
+                if (seg.tier == 0 && seg.codec == packed.extension().string()) {
+                    seg.bytes = size;
+                }
+            });
+        });
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "CompressionStrategies.h"
+#include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief 按积压与系统负载自动选择压缩级别的策略
+ *
+ * 每个段压缩前按压缩线程池的积压段数、系统负载和各档实测吞吐选一档：
+ *   Store    积压严重或负载极高：只存储（zstd/LZ4 为最快的负级别）
+ *   Fast     积压或负载偏高，或实测吞吐在 CPU 预算内跟不上段的到达速度
+ *   Balanced 配置的级别
+ *   High     空闲：高压缩率
+ * 以 Store/Fast 压缩的段记下来，空闲时（无积压且负载低）逐个以 High 重新压缩。
+ * CPU 总量由 CompressionPool 的预算约束，这里只决定把预算花在哪一档上。
+ */
+class AdaptiveCompressionStrategy : public ICompressionStrategy,
+                                    public std::enable_shared_from_this<AdaptiveCompressionStrategy> {
+public:
+    enum class Tier { Store, Fast, Balanced, High };
+    static constexpr size_t kTiers = 4;
+
+    struct Options {
+        size_t backlog_per_thread = 2;   // 积压段数超过 线程数 × 该值 视为繁忙，超过两倍只存储
+        double busy_load = 0.9;          // 每核负载（1 分钟 loadavg / 核数）高于此值视为繁忙
+        double idle_load = 0.3;          // 低于此值且无积压视为空闲
+        // 每核负载的采样方式（测试可替换）
+        std::function<double()> load_probe;
+    };
+
+    // 各档累计统计
+    struct TierStats {
+        size_t segments = 0;
+        uint64_t raw_bytes = 0;
+        uint64_t packed_bytes = 0;
+        double seconds = 0;
+        double ratio() const { return raw_bytes ? static_cast<double>(packed_bytes) / raw_bytes : 0; }
+        double throughput() const { return seconds > 0 ? raw_bytes / seconds : 0; }   // 字节/秒
+    };
+
+    AdaptiveCompressionStrategy(CompressionCodec codec, int level, int workers);
+    AdaptiveCompressionStrategy(CompressionCodec codec, int level, int workers, Options options);
+
+    // 已压缩的段（扩展名为本编解码器）会以 High 档重新压缩
+    bool compress(const std::filesystem::path& src) override;
+    std::string compressedExtension() const override;
+
+    Tier chooseTier(size_t backlog, double load) const;
+    TierStats stats(Tier tier) const;
+    // 等待空闲时重新压缩的段数
+    size_t pendingRecompress() const;
+
+    static double systemLoad();
+
+private:
+    bool recompress(const std::filesystem::path& packed);
+    bool compressAt(Tier tier, const std::filesystem::path& src, const std::filesystem::path& dst);
+    // 本任务之外的积压段数
+    size_t backlog() const;
+    void maybeRecompressWhenIdle();
+
+    std::array<std::shared_ptr<CodecCompressionStrategy>, kTiers> tiers_;
+    Options options_;
+
+    mutable std::mutex mtx_;
+    std::array<TierStats, kTiers> stats_{};
+    std::deque<std::filesystem::path> lowered_;     // 以低档压缩、待重新压缩的段
+    double arrival_rate_ = 0;                       // 新段到达速率（字节/秒，指数平均）
+    std::chrono::steady_clock::time_point last_arrival_{};
+};
@@ -0,0 +1,181 @@
+#include "CompressionPool.h"
+#include "RollingFileManager.h"
+#include <algorithm>
+#include <iostream>
+#include <ctime>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+double threadCpuSeconds() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+}  // namespace
+
+CompressionPool& CompressionPool::instance() {
+    static CompressionPool inst;
+    return inst;
+}
+
+CompressionPool::~CompressionPool() {
+    stopWorkers();
+}
+
+void CompressionPool::configure(size_t threads, int nice) {
+    threads = std::max<size_t>(1, threads);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (threads == threads_ && nice == nice_) return;
+    }
+    // 等正在压缩的文件完成后按新设置重建线程，排队的任务保留
+    stopWorkers();
+    std::lock_guard<std::mutex> lock(mtx_);
+    threads_ = threads;
+    nice_ = nice;
+    stop_ = false;
+    if (!queue_.empty()) {
+        startLocked();
+    }
+}
+
+void CompressionPool::submit(const std::filesystem::path& src,
+                             std::shared_ptr<ICompressionStrategy> strategy,
+                             Callback on_done) {
+    auto key = src.lexically_normal();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!in_flight_.insert(key).second) {
+            return;
+        }
+        queue_.push_back(Job{key, std::move(strategy), std::move(on_done)});
+        if (workers_.empty() && !stop_) {
+            startLocked();
+        }
+    }
+    cv_.notify_one();
+}
+
+size_t CompressionPool::threads() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return threads_;
+}
+
+void CompressionPool::setCpuBudget(double cores) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    cpu_budget_ = std::max(0.0, cores);
+    cpu_debt_ = 0;
+    refilled_at_ = std::chrono::steady_clock::now();
+}
+
+double CompressionPool::cpuBudget() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return cpu_budget_;
+}
+
+void CompressionPool::chargeCpu(double seconds) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    throttleLocked();
+    cpu_debt_ += seconds;
+}
+
+std::chrono::duration<double> CompressionPool::throttleLocked() {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - refilled_at_;
+    refilled_at_ = now;
+    if (cpu_budget_ <= 0) {
+        cpu_debt_ = 0;
+        return std::chrono::duration<double>::zero();
+    }
+    // 额度最多攒 1 秒，空闲很久之后的突发仍受预算约束
+    cpu_debt_ = std::max(-cpu_budget_, cpu_debt_ - elapsed.count() * cpu_budget_);
+    return std::chrono::duration<double>(std::max(0.0, cpu_debt_ / cpu_budget_));
+}
+
+bool CompressionPool::inFlight(const std::filesystem::path& path) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return in_flight_.count(path.lexically_normal()) > 0;
+}
+
+size_t CompressionPool::pending() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return in_flight_.size();
+}
+
+void CompressionPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this] { return in_flight_.empty() || workers_.empty(); });
+}
+
+void CompressionPool::startLocked() {
+    for (size_t i = 0; i < threads_; ++i) {
+        workers_.emplace_back(&CompressionPool::run, this);
+    }
+}
+
+void CompressionPool::stopWorkers() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+        workers.swap(workers_);
+    }
+    cv_.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+    idle_cv_.notify_all();
+}
+
+void CompressionPool::run() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        // Linux 上 nice 值按线程生效，只降低压缩线程自身的优先级
+        if (nice_ != 0 &&
+            ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), nice_) != 0) {
+            std::cerr << "[CompressionPool] Failed to set thread nice value\n";
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_) break;
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        bool ok = false;
+        double cpu_start = threadCpuSeconds();
+        try {
+            ok = job.strategy && job.strategy->compress(job.src);
+        } catch (const std::exception& e) {
+            std::cerr << "[CompressionPool] Compression of " << job.src
+                      << " failed: " << e.what() << "\n";
+        }
+        if (!ok) {
+            std::cerr << "[CompressionPool] Failed to compress " << job.src << "\n";
+        }
+        if (job.on_done) {
+            job.on_done(job.src, ok);
+        }
+
+        double cpu_used = threadCpuSeconds() - cpu_start;
+
+        lock.lock();
+        in_flight_.erase(job.src);
+        if (in_flight_.empty()) {
+            idle_cv_.notify_all();
+        }
+        throttleLocked();
+        cpu_debt_ += cpu_used;
+        // 超出 CPU 预算：等额度补回后再取下一个任务
+        auto wait = throttleLocked();
+        if (wait.count() > 0) {
+            cv_.wait_for(lock, wait, [this] { return stop_; });
+        }
+    }
+}
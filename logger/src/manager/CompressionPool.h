@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+class ICompressionStrategy;
+
+/**
+ * @brief 进程级后台压缩线程池
+ *
+ * 轮转只把已关闭的段交给线程池即返回，压缩不再占用 Sink 的锁。
+ * 并发数有上限，工作线程以较低优先级（nice）运行。
+ * 排队与正在压缩的源文件可通过 inFlight() 查询，保留数量与磁盘回收据此跳过它们。
+ *
+ * 进程退出时只等待正在压缩的文件，排队中的文件留在磁盘上，
+ * 由下次启动时的 RollingFileManager 重新入队。
+ *
+ * CPU 预算：压缩消耗的线程 CPU 时间按令牌桶记账（最多攒 1 秒的额度），
+ * 超支时工作线程在取下一个任务前等待，长期平均不超过预算的核数。
+ */
+class CompressionPool {
+public:
+    using Callback = std::function<void(const std::filesystem::path& src, bool ok)>;
+
+    static CompressionPool& instance();
+
+    // 设置并发上限与线程 nice 值；已启动的线程按新设置重建
+    void configure(size_t threads, int nice);
+
+    // 提交一个压缩任务；同一文件已在队列中时忽略。on_done 在工作线程上调用
+    void submit(const std::filesystem::path& src,
+                std::shared_ptr<ICompressionStrategy> strategy,
+                Callback on_done = {});
+
+    size_t threads() const;
+    
+    // 压缩可用的 CPU 核数（如 0.5 表示半个核）；0 表示不限
+    void setCpuBudget(double cores);
+    double cpuBudget() const;
+    // 记入一段压缩 CPU 时间；工作线程自动记账，压缩策略自建的辅助线程须自行调用
+    void chargeCpu(double seconds);
+    
+    // 文件是否排队或正在压缩
+    bool inFlight(const std::filesystem::path& path) const;
+    size_t pending() const;
+    // 等待队列清空且没有正在压缩的文件
+    void waitIdle();
+
+    ~CompressionPool();
+
+private:
+    struct Job {
+        std::filesystem::path src;
+        std::shared_ptr<ICompressionStrategy> strategy;
+        Callback on_done;
+    };
+
+    CompressionPool() = default;
+    void run();
+    void startLocked();
+    void stopWorkers();
+    // 按预算补充额度，返回当前超支需等待的时长
+    std::chrono::duration<double> throttleLocked();
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+    std::deque<Job> queue_;
+    std::set<std::filesystem::path> in_flight_;   // 排队中 + 正在压缩
+    std::vector<std::thread> workers_;
+    size_t threads_ = 1;
+    int nice_ = 10;
+    bool stop_ = false;
+    double cpu_budget_ = 0;          // 核数，0 为不限
+    double cpu_debt_ = 0;            // 超支的 CPU 秒数（负数为攒下的额度）
+    std::chrono::steady_clock::time_point refilled_at_ = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,608 @@
+#include "CompressionStrategies.h"
+#include "CompressionPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef LOGGER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef LOGGER_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace {
+constexpr size_t kChunk = 1 << 16;
+
+bool syncFile(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = ::fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// 带所有权的 FILE*，保证每条退出路径都关闭
+struct FileCloser {
+    void operator()(std::FILE* f) const { std::fclose(f); }
+};
+using FilePtr = std::unique_ptr<std::FILE, FileCloser>;
+}  // namespace
+
+bool compressToFile(const std::filesystem::path& src, const std::filesystem::path& dst,
+                    const std::function<bool(std::ifstream&, const std::filesystem::path&)>& encode) {
+    std::ifstream in(src, std::ios::binary);
+    if (!in) return false;
+
+    auto tmp = compressionTempPath(dst);
+    bool ok = encode(in, tmp);
+    in.close();
+
+    std::error_code ec;
+    if (!ok || !syncFile(tmp)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    std::filesystem::rename(tmp, dst, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    std::filesystem::remove(src, ec);
+    return !ec;
+}
+
+// ============================================
+// 边写边压缩的帧编码器
+// ============================================
+namespace {
+class GzipFrameEncoder : public IFrameEncoder {
+public:
+    GzipFrameEncoder(int level, size_t frame_bytes) : level_(level), frame_bytes_(frame_bytes) {}
+
+    // 每帧是一个完整的 gzip 成员；多成员文件可被 gzip / gzread 直接顺序解压
+    bool encode(const char* data, size_t n, std::string& out) override {
+        z_stream zs{};
+        int level = level_ > 0 ? std::min(level_, 9)
+                  : level_ < 0 ? Z_NO_COMPRESSION : Z_DEFAULT_COMPRESSION;
+        if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        size_t old = out.size();
+        out.resize(old + deflateBound(&zs, static_cast<uLong>(n)));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs.avail_in = static_cast<uInt>(n);
+        zs.next_out = reinterpret_cast<Bytef*>(&out[old]);
+        zs.avail_out = static_cast<uInt>(out.size() - old);
+        int rc = deflate(&zs, Z_FINISH);
+        out.resize(old + zs.total_out);
+        deflateEnd(&zs);
+        return rc == Z_STREAM_END;
+    }
+    IndexFormat indexFormat() const override { return IndexFormat::GzipMember; }
+    size_t frameBytes() const override { return frame_bytes_; }
+
+private:
+    int level_;
+    size_t frame_bytes_;
+};
+
+#ifdef LOGGER_HAVE_ZSTD
+class ZstdFrameEncoder : public IFrameEncoder {
+public:
+    ZstdFrameEncoder(int level, int workers, size_t frame_bytes)
+        : cctx_(ZSTD_createCCtx(), ZSTD_freeCCtx), frame_bytes_(frame_bytes) {
+        ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_compressionLevel, level);
+        ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_checksumFlag, 1);
+        if (workers > 0) {
+            ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_nbWorkers, workers);
+        }
+    }
+
+    // 上下文跨帧复用，每帧仍是带内容大小的独立 zstd 帧
+    bool encode(const char* data, size_t n, std::string& out) override {
+        if (!cctx_) return false;
+        size_t old = out.size();
+        out.resize(old + ZSTD_compressBound(n));
+        size_t r = ZSTD_compress2(cctx_.get(), &out[old], out.size() - old, data, n);
+        if (ZSTD_isError(r)) {
+            out.resize(old);
+            return false;
+        }
+        out.resize(old + r);
+        return true;
+    }
+    IndexFormat indexFormat() const override { return IndexFormat::SkippableFrame; }
+    size_t frameBytes() const override { return frame_bytes_; }
+
+private:
+    std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx_;
+    size_t frame_bytes_;
+};
+#endif
+
+#ifdef LOGGER_HAVE_LZ4
+class Lz4FrameEncoder : public IFrameEncoder {
+public:
+    Lz4FrameEncoder(int level, size_t frame_bytes) : frame_bytes_(frame_bytes) {
+        prefs_.compressionLevel = level;
+        prefs_.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+        prefs_.frameInfo.blockSizeID = LZ4F_max4MB;
+    }
+
+    bool encode(const char* data, size_t n, std::string& out) override {
+        LZ4F_preferences_t prefs = prefs_;
+        prefs.frameInfo.contentSize = n;
+        size_t old = out.size();
+        out.resize(old + LZ4F_compressFrameBound(n, &prefs));
+        size_t r = LZ4F_compressFrame(&out[old], out.size() - old, data, n, &prefs);
+        if (LZ4F_isError(r)) {
+            out.resize(old);
+            return false;
+        }
+        out.resize(old + r);
+        return true;
+    }
+    IndexFormat indexFormat() const override { return IndexFormat::SkippableFrame; }
+    size_t frameBytes() const override { return frame_bytes_; }
+
+private:
+    LZ4F_preferences_t prefs_{};
+    size_t frame_bytes_;
+};
+#endif
+}  // namespace
+
+namespace {
+constexpr size_t kParallelBlockBytes = 4 * 1024 * 1024;
+
+/**
+ * 大段按块并行压缩（pigz 式）：每块编码为一个独立的 gzip 成员 / LZ4 帧，按原顺序拼接，
+ * 结果仍是标准工具可读的多成员文件。每轮读入 workers * 2 块，内存占用有上限。
+ * 新线程继承调用线程（压缩线程池）的 nice 值。
+ */
+bool encodeBlocksParallel(std::ifstream& in, std::FILE* out, int workers,
+                          const std::function<std::unique_ptr<IFrameEncoder>()>& make_encoder) {
+    const size_t window = static_cast<size_t>(workers) * 2;
+    std::vector<std::string> raw(window), packed(window);
+    std::vector<std::unique_ptr<IFrameEncoder>> encoders;
+    for (int i = 0; i < workers; ++i) {
+        encoders.push_back(make_encoder());
+    }
+
+    while (true) {
+        size_t blocks = 0;
+        while (blocks < window && in) {
+            raw[blocks].resize(kParallelBlockBytes);
+            in.read(&raw[blocks][0], static_cast<std::streamsize>(kParallelBlockBytes));
+            raw[blocks].resize(static_cast<size_t>(in.gcount()));
+            if (raw[blocks].empty()) break;
+            ++blocks;
+        }
+        if (blocks == 0) break;
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool> ok{true};
+        auto work = [&](IFrameEncoder* encoder) {
+            for (size_t i = next.fetch_add(1); i < blocks; i = next.fetch_add(1)) {
+                packed[i].clear();
+                if (!encoder->encode(raw[i].data(), raw[i].size(), packed[i])) {
+                    ok = false;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < encoders.size() && t < blocks; ++t) {
+            threads.emplace_back([&work, encoder = encoders[t].get()] {
+                timespec start{}, end{};
+                ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+                work(encoder);
+                ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+                // 辅助线程的 CPU 时间也计入压缩预算
+                CompressionPool::instance().chargeCpu(
+                    static_cast<double>(end.tv_sec - start.tv_sec) +
+                    static_cast<double>(end.tv_nsec - start.tv_nsec) * 1e-9);
+            });
+        }
+        work(encoders[0].get());
+        for (auto& t : threads) {
+            t.join();
+        }
+        if (!ok) return false;
+
+        for (size_t i = 0; i < blocks; ++i) {
+            if (std::fwrite(packed[i].data(), 1, packed[i].size(), out) != packed[i].size()) {
+                return false;
+            }
+        }
+    }
+    return std::fflush(out) == 0;
+}
+
+// 多于一块且配置了多个线程时才值得并行
+bool useParallelBlocks(const std::filesystem::path& src, int workers) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(src, ec);
+    return workers > 1 && !ec && size > kParallelBlockBytes;
+}
+}  // namespace
+
+// ============================================
+// gzip
+// ============================================
+bool GzipCompressionStrategy::compressTo(const std::filesystem::path& src,
+                                         const std::filesystem::path& dst) {
+    if (useParallelBlocks(src, workers_)) {
+        return compressToFile(src, dst,
+            [this](std::ifstream& in, const std::filesystem::path& tmp) {
+                FilePtr out(std::fopen(tmp.c_str(), "wb"));
+                return out && encodeBlocksParallel(in, out.get(), workers_, [this] {
+                    return std::make_unique<GzipFrameEncoder>(level_, kParallelBlockBytes);
+                });
+            });
+    }
+    return compressToFile(src, dst,
+        [this](std::ifstream& in, const std::filesystem::path& tmp) {
+            std::string mode = "wb";
+            if (level_ > 0) mode += std::to_string(std::min(level_, 9));
+            if (level_ < 0) mode += "0";   // 只存储
+            gzFile out = gzopen(tmp.c_str(), mode.c_str());
+            if (!out) return false;
+
+            char buffer[kChunk];
+            bool ok = true;
+            while (in && ok) {
+                in.read(buffer, sizeof(buffer));
+                auto n = in.gcount();
+                if (n > 0) {
+                    ok = gzwrite(out, buffer, static_cast<unsigned int>(n)) == n;
+                }
+            }
+            return gzclose(out) == Z_OK && ok;
+        });
+}
+
+// ============================================
+// zstd
+// ============================================
+bool ZstdCompressionStrategy::compressTo(const std::filesystem::path& src,
+                                         const std::filesystem::path& dst) {
+#ifdef LOGGER_HAVE_ZSTD
+    // 大段按块并行，输出为多个拼接的 zstd 帧。不用 ZSTD_c_nbWorkers：libzstd 内部线程的
+    // CPU 时间无法计入压缩线程池的预算，按块并行的辅助线程则各自计入
+    if (useParallelBlocks(src, workers_)) {
+        return compressToFile(src, dst,
+            [this](std::ifstream& in, const std::filesystem::path& tmp) {
+                FilePtr out(std::fopen(tmp.c_str(), "wb"));
+                return out && encodeBlocksParallel(in, out.get(), workers_, [this] {
+                    return std::make_unique<ZstdFrameEncoder>(level_, 0, kParallelBlockBytes);
+                });
+            });
+    }
+    return compressToFile(src, dst,
+        [this](std::ifstream& in, const std::filesystem::path& tmp) {
+            FilePtr out(std::fopen(tmp.c_str(), "wb"));
+            if (!out) return false;
+            std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+            if (!cctx) return false;
+
+            ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, level_);
+            ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_checksumFlag, 1);
+
+            std::vector<char> in_buf(ZSTD_CStreamInSize());
+            std::vector<char> out_buf(ZSTD_CStreamOutSize());
+            bool last = false;
+            while (!last) {
+                in.read(in_buf.data(), static_cast<std::streamsize>(in_buf.size()));
+                size_t n = static_cast<size_t>(in.gcount());
+                last = !in;
+                ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+                ZSTD_inBuffer input{in_buf.data(), n, 0};
+                // e_end 时直到返回 0 才算帧写完
+                bool finished = false;
+                while (!finished) {
+                    ZSTD_outBuffer output{out_buf.data(), out_buf.size(), 0};
+                    size_t remaining = ZSTD_compressStream2(cctx.get(), &output, &input, mode);
+                    if (ZSTD_isError(remaining)) {
+                        std::cerr << "[Compression] zstd: " << ZSTD_getErrorName(remaining) << "\n";
+                        return false;
+                    }
+                    if (std::fwrite(out_buf.data(), 1, output.pos, out.get()) != output.pos) {
+                        return false;
+                    }
+                    finished = last ? remaining == 0 : input.pos == input.size;
+                }
+            }
+            return std::fflush(out.get()) == 0;
+        });
+#else
+    return GzipCompressionStrategy(level_, workers_).compressTo(src, dst);
+#endif
+}
+
+// ============================================
+// LZ4 frame
+// ============================================
+bool Lz4CompressionStrategy::compressTo(const std::filesystem::path& src,
+                                        const std::filesystem::path& dst) {
+#ifdef LOGGER_HAVE_LZ4
+    if (useParallelBlocks(src, workers_)) {
+        return compressToFile(src, dst,
+            [this](std::ifstream& in, const std::filesystem::path& tmp) {
+                FilePtr out(std::fopen(tmp.c_str(), "wb"));
+                return out && encodeBlocksParallel(in, out.get(), workers_, [this] {
+                    return std::make_unique<Lz4FrameEncoder>(level_, kParallelBlockBytes);
+                });
+            });
+    }
+    return compressToFile(src, dst,
+        [this](std::ifstream& in, const std::filesystem::path& tmp) {
+            FilePtr out(std::fopen(tmp.c_str(), "wb"));
+            if (!out) return false;
+            LZ4F_cctx* raw = nullptr;
+            if (LZ4F_isError(LZ4F_createCompressionContext(&raw, LZ4F_VERSION))) return false;
+            std::unique_ptr<LZ4F_cctx, LZ4F_errorCode_t (*)(LZ4F_cctx*)> cctx(
+                raw, LZ4F_freeCompressionContext);
+
+            LZ4F_preferences_t prefs{};
+            prefs.compressionLevel = level_;
+            prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+            prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+
+            std::vector<char> in_buf(kChunk);
+            std::vector<char> out_buf(LZ4F_compressBound(kChunk, &prefs));
+            auto emit = [&](size_t n) {
+                return !LZ4F_isError(n) && std::fwrite(out_buf.data(), 1, n, out.get()) == n;
+            };
+
+            if (!emit(LZ4F_compressBegin(cctx.get(), out_buf.data(), out_buf.size(), &prefs))) {
+                return false;
+            }
+            while (in) {
+                in.read(in_buf.data(), static_cast<std::streamsize>(in_buf.size()));
+                size_t n = static_cast<size_t>(in.gcount());
+                if (n == 0) break;
+                if (!emit(LZ4F_compressUpdate(cctx.get(), out_buf.data(), out_buf.size(),
+                                              in_buf.data(), n, nullptr))) {
+                    return false;
+                }
+            }
+            if (!emit(LZ4F_compressEnd(cctx.get(), out_buf.data(), out_buf.size(), nullptr))) {
+                return false;
+            }
+            return std::fflush(out.get()) == 0;
+        });
+#else
+    return GzipCompressionStrategy(level_, workers_).compressTo(src, dst);
+#endif
+}
+
+std::unique_ptr<IFrameEncoder> GzipCompressionStrategy::makeFrameEncoder() const {
+    if (frame_bytes_ == 0) return nullptr;
+    return std::make_unique<GzipFrameEncoder>(level_, frame_bytes_);
+}
+
+std::unique_ptr<IFrameEncoder> ZstdCompressionStrategy::makeFrameEncoder() const {
+    if (frame_bytes_ == 0) return nullptr;
+#ifdef LOGGER_HAVE_ZSTD
+    return std::make_unique<ZstdFrameEncoder>(level_, workers_, frame_bytes_);
+#else
+    return std::make_unique<GzipFrameEncoder>(level_, frame_bytes_);
+#endif
+}
+
+std::unique_ptr<IFrameEncoder> Lz4CompressionStrategy::makeFrameEncoder() const {
+    if (frame_bytes_ == 0) return nullptr;
+#ifdef LOGGER_HAVE_LZ4
+    return std::make_unique<Lz4FrameEncoder>(level_, frame_bytes_);
+#else
+    return std::make_unique<GzipFrameEncoder>(level_, frame_bytes_);
+#endif
+}
+
+// ============================================
+// 工厂与扩展名
+// ============================================
+std::shared_ptr<CodecCompressionStrategy> makeCompressionStrategy(CompressionCodec codec,
+                                                                  int level, int workers,
+                                                                  size_t stream_frame_bytes) {
+    switch (codec) {
+        case CompressionCodec::Zstd:
+#ifdef LOGGER_HAVE_ZSTD
+            return std::make_shared<ZstdCompressionStrategy>(level, workers, stream_frame_bytes);
+#else
+            break;
+#endif
+        case CompressionCodec::Lz4:
+#ifdef LOGGER_HAVE_LZ4
+            return std::make_shared<Lz4CompressionStrategy>(level, workers, stream_frame_bytes);
+#else
+            break;
+#endif
+        case CompressionCodec::Gzip:
+            return std::make_shared<GzipCompressionStrategy>(level, workers, stream_frame_bytes);
+    }
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) {
+        std::cerr << "[Compression] Codec not available in this build, falling back to gzip\n";
+    }
+    return std::make_shared<GzipCompressionStrategy>(level, workers, stream_frame_bytes);
+}
+
+const std::vector<std::string>& compressedExtensions() {
+    static const std::vector<std::string> kExtensions{".gz", ".zst", ".lz4"};
+    return kExtensions;
+}
+
+bool isCompressedExtension(const std::filesystem::path& ext) {
+    const auto& all = compressedExtensions();
+    return std::find(all.begin(), all.end(), ext.string()) != all.end();
+}
+
+bool readSegmentFile(const std::filesystem::path& path, std::string& out) {
+    const auto ext = path.extension();
+#ifdef LOGGER_HAVE_ZSTD
+    if (ext == ".zst") {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+        std::vector<char> in_buf(ZSTD_DStreamInSize());
+        std::vector<char> out_buf(ZSTD_DStreamOutSize());
+        size_t pending = 0;   // 非 0 表示最后一帧尚未结束
+        bool first = true;
+        while (in) {
+            in.read(in_buf.data(), static_cast<std::streamsize>(in_buf.size()));
+            ZSTD_inBuffer input{in_buf.data(), static_cast<size_t>(in.gcount()), 0};
+            // 帧头记录了压缩时使用的字典，解压前加载同一份
+            if (first && input.size > 0) {
+                first = false;
+                if (uint32_t id = ZSTD_getDictID_fromFrame(in_buf.data(), input.size)) {
+                    std::ifstream dict_in(zstdDictionaryPath(path, id), std::ios::binary);
+                    std::string dict((std::istreambuf_iterator<char>(dict_in)),
+                                     std::istreambuf_iterator<char>());
+                    if (dict.empty() ||
+                        ZSTD_isError(ZSTD_DCtx_loadDictionary(dctx.get(), dict.data(), dict.size()))) {
+                        return false;
+                    }
+                }
+            }
+            while (input.pos < input.size) {
+                ZSTD_outBuffer output{out_buf.data(), out_buf.size(), 0};
+                pending = ZSTD_decompressStream(dctx.get(), &output, &input);
+                if (ZSTD_isError(pending)) return false;
+                out.append(out_buf.data(), output.pos);
+            }
+        }
+        return pending == 0;
+    }
+#endif
+#ifdef LOGGER_HAVE_LZ4
+    if (ext == ".lz4") {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        LZ4F_dctx* raw = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&raw, LZ4F_VERSION))) return false;
+        std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)> dctx(
+            raw, LZ4F_freeDecompressionContext);
+        std::vector<char> in_buf(kChunk);
+        std::vector<char> out_buf(kChunk * 4);
+        size_t hint = 1;      // 为 0 表示帧已完整解出
+        while (in) {
+            in.read(in_buf.data(), static_cast<std::streamsize>(in_buf.size()));
+            size_t avail = static_cast<size_t>(in.gcount());
+            const char* p = in_buf.data();
+            // 输出缓冲写满时解码器可能还留有数据，继续以空输入取出
+            bool more = avail > 0;
+            while (more) {
+                size_t out_size = out_buf.size();
+                size_t consumed = avail;
+                hint = LZ4F_decompress(dctx.get(), out_buf.data(), &out_size, p, &consumed, nullptr);
+                if (LZ4F_isError(hint)) return false;
+                out.append(out_buf.data(), out_size);
+                p += consumed;
+                avail -= consumed;
+                more = avail > 0 || (hint != 0 && out_size == out_buf.size());
+            }
+        }
+        return hint == 0;
+    }
+#endif
+    (void)ext;
+    // gzread 对未压缩文件透明直读
+    gzFile in = gzopen(path.c_str(), "rb");
+    if (!in) return false;
+    char buf[kChunk];
+    int n;
+    while ((n = gzread(in, buf, sizeof(buf))) > 0) {
+        out.append(buf, static_cast<size_t>(n));
+    }
+    gzclose(in);
+    return n == 0;
+}
+
+std::filesystem::path zstdDictionaryPath(const std::filesystem::path& segment, uint32_t dict_id) {
+    return segment.parent_path() / ".dict" / (std::to_string(dict_id) + ".zdict");
+}
+
+uint32_t zstdDictionaryId(const std::filesystem::path& segment) {
+#ifdef LOGGER_HAVE_ZSTD
+    char header[18];   // zstd 帧头最大长度
+    std::ifstream in(segment, std::ios::binary);
+    in.read(header, sizeof(header));
+    return ZSTD_getDictID_fromFrame(header, static_cast<size_t>(in.gcount()));
+#else
+    (void)segment;
+    return 0;
+#endif
+}
+
+bool decompressBuffer(const std::filesystem::path& ext, const char* data, size_t n,
+                      std::string& out) {
+#ifdef LOGGER_HAVE_ZSTD
+    if (ext == ".zst") {
+        std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+        std::vector<char> buf(ZSTD_DStreamOutSize());
+        ZSTD_inBuffer input{data, n, 0};
+        size_t pending = 0;
+        while (input.pos < input.size) {
+            ZSTD_outBuffer output{buf.data(), buf.size(), 0};
+            pending = ZSTD_decompressStream(dctx.get(), &output, &input);
+            if (ZSTD_isError(pending)) return false;
+            out.append(buf.data(), output.pos);
+        }
+        return pending == 0;
+    }
+#endif
+#ifdef LOGGER_HAVE_LZ4
+    if (ext == ".lz4") {
+        LZ4F_dctx* raw = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&raw, LZ4F_VERSION))) return false;
+        std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)> dctx(
+            raw, LZ4F_freeDecompressionContext);
+        std::vector<char> buf(kChunk * 4);
+        size_t hint = 1;
+        bool more = n > 0;
+        while (more) {
+            size_t out_size = buf.size();
+            size_t consumed = n;
+            hint = LZ4F_decompress(dctx.get(), buf.data(), &out_size, data, &consumed, nullptr);
+            if (LZ4F_isError(hint)) return false;
+            out.append(buf.data(), out_size);
+            data += consumed;
+            n -= consumed;
+            more = n > 0 || (hint != 0 && out_size == buf.size());
+        }
+        return hint == 0;
+    }
+#endif
+    (void)ext;
+    // 自动识别 gzip / zlib 头，逐个成员解压
+    z_stream zs{};
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) return false;
+    char buf[kChunk];
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(n);
+    int rc = Z_OK;
+    while (zs.avail_in > 0 || rc == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) break;
+        out.append(buf, sizeof(buf) - zs.avail_out);
+        if (rc == Z_STREAM_END) {
+            if (zs.avail_in == 0) break;
+            inflateReset(&zs);
+            rc = Z_OK;
+        }
+    }
+    inflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
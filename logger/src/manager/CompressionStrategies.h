@@ -0,0 +1,106 @@
+#pragma once
+#include "RollingFileManager.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// LOGGER_HAVE_ZSTD / LOGGER_HAVE_LZ4 由 Makefile 在头文件与库都可用时定义；
+// 未定义时对应编解码器退回 gzip
+
+// ============================================
+// 压缩策略实现
+// 均先写临时文件，落盘后原子 rename 再删除源段
+// ============================================
+
+/**
+ * 把 src 压缩为 dst：encode 把输入流编码写入临时文件，
+ * 成功后落盘、原子 rename（覆盖已有的 dst）、删除源文件；中途失败或崩溃只会留下可丢弃的 .tmp
+ */
+bool compressToFile(const std::filesystem::path& src, const std::filesystem::path& dst,
+                    const std::function<bool(std::ifstream&, const std::filesystem::path&)>& encode);
+
+// 具体编解码器的公共基类：可压缩到任意目标路径（重新压缩时覆盖已有的压缩段）
+class CodecCompressionStrategy : public ICompressionStrategy {
+public:
+    bool compress(const std::filesystem::path& src) override {
+        return compressTo(src, src.string() + compressedExtension());
+    }
+    // 成功后删除 src
+    virtual bool compressTo(const std::filesystem::path& src, const std::filesystem::path& dst) = 0;
+};
+
+// gzip（zlib deflate）；level 为 0 时取 zlib 默认级别，为负时只存储不压缩
+// workers > 1 时大段按 4 MiB 分块并行压缩为多成员 gzip；
+// frame_bytes > 0 时改为边写边压缩：段由独立的 gzip 成员组成，末尾带帧索引
+class GzipCompressionStrategy : public CodecCompressionStrategy {
+public:
+    explicit GzipCompressionStrategy(int level = 0, int workers = 0, size_t frame_bytes = 0)
+        : level_(level), workers_(workers), frame_bytes_(frame_bytes) {}
+    bool compressTo(const std::filesystem::path& src, const std::filesystem::path& dst) override;
+    std::string compressedExtension() const override { return ".gz"; }
+    std::unique_ptr<IFrameEncoder> makeFrameEncoder() const override;
+
+private:
+    int level_;
+    int workers_;
+    size_t frame_bytes_;
+};
+
+// zstd 流式压缩；workers > 1 时大段按块并行压缩为多个拼接的 zstd 帧；负级别为快速模式
+class ZstdCompressionStrategy : public CodecCompressionStrategy {
+public:
+    explicit ZstdCompressionStrategy(int level = 0, int workers = 0, size_t frame_bytes = 0)
+        : level_(level), workers_(workers), frame_bytes_(frame_bytes) {}
+    bool compressTo(const std::filesystem::path& src, const std::filesystem::path& dst) override;
+    std::string compressedExtension() const override { return ".zst"; }
+    std::unique_ptr<IFrameEncoder> makeFrameEncoder() const override;
+
+private:
+    int level_;
+    int workers_;
+    size_t frame_bytes_;
+};
+
+// LZ4 frame 格式（带内容校验）；level 0 为快速模式，>= 3 为 HC，为负时加速
+// workers > 1 时大段按块并行压缩为多个拼接的 LZ4 帧
+class Lz4CompressionStrategy : public CodecCompressionStrategy {
+public:
+    explicit Lz4CompressionStrategy(int level = 0, int workers = 0, size_t frame_bytes = 0)
+        : level_(level), workers_(workers), frame_bytes_(frame_bytes) {}
+    bool compressTo(const std::filesystem::path& src, const std::filesystem::path& dst) override;
+    std::string compressedExtension() const override { return ".lz4"; }
+    std::unique_ptr<IFrameEncoder> makeFrameEncoder() const override;
+
+private:
+    int level_;
+    int workers_;
+    size_t frame_bytes_;
+};
+
+// 按模块配置创建压缩策略；编解码器未编译进来时退回 gzip
+// stream_frame_bytes > 0 时段在写入时按该帧大小压缩
+std::shared_ptr<CodecCompressionStrategy> makeCompressionStrategy(CompressionCodec codec,
+                                                                  int level = 0,
+                                                                  int workers = 0,
+                                                                  size_t stream_frame_bytes = 0);
+
+// 所有压缩产物的扩展名（回收、续写、命名查重时统一识别）
+const std::vector<std::string>& compressedExtensions();
+bool isCompressedExtension(const std::filesystem::path& ext);
+
+// 读取一个段文件的原始内容：按扩展名解压 .zst / .lz4，其余经 gzread（未压缩文件直读）
+// 用字典压缩的 .zst 段按帧头中的字典 ID 自动加载同目录下的字典
+bool readSegmentFile(const std::filesystem::path& path, std::string& out);
+
+// zstd 字典存放位置：<段所在目录>/.dict/<字典 ID>.zdict
+std::filesystem::path zstdDictionaryPath(const std::filesystem::path& segment, uint32_t dict_id);
+// .zst 段首帧引用的字典 ID；未使用字典或无法读取时为 0
+uint32_t zstdDictionaryId(const std::filesystem::path& segment);
+
+// 按扩展名解压内存中的一个或多个完整帧，追加到 out
+bool decompressBuffer(const std::filesystem::path& ext, const char* data, size_t n,
+                      std::string& out);
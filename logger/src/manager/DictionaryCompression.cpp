@@ -0,0 +1,260 @@
+#include "DictionaryCompression.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef LOGGER_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t kFirstDictId = 32768;      // 0 ~ 32767 为 zstd 保留的注册 ID
+constexpr uint32_t kDictMagic = 0xEC30A437;   // zstd 字典格式魔数，其后 4 字节为字典 ID
+constexpr size_t kSampleBytes = 4096;         // 单个样本的大小
+constexpr size_t kSamplesPerDictByte = 100;   // 样本总量 / 字典大小
+
+// 解析 <ID>.zdict
+bool parseDictionaryName(const fs::path& p, uint32_t& id) {
+    if (p.extension() != ".zdict") return false;
+    const auto stem = p.stem().string();
+    if (stem.empty() || !std::all_of(stem.begin(), stem.end(), ::isdigit)) return false;
+    id = static_cast<uint32_t>(std::strtoul(stem.c_str(), nullptr, 10));
+    return id >= kFirstDictId;
+}
+
+// 写临时文件、落盘后原子 rename：段引用的字典必须先于段本身持久化
+bool writeDurably(const fs::path& path, const std::string& data) {
+    auto tmp = path;
+    tmp += ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    bool ok = done == data.size() && ::fdatasync(fd) == 0;
+    ::close(fd);
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmp, path, ec);
+        ok = !ec;
+    }
+    if (!ok) fs::remove(tmp, ec);
+    return ok;
+}
+}  // namespace
+
+#ifdef LOGGER_HAVE_ZSTD
+struct ZstdDictionaryStrategy::Dictionary {
+    uint32_t id;
+    std::unique_ptr<ZSTD_CDict, size_t (*)(ZSTD_CDict*)> cdict;
+};
+#else
+struct ZstdDictionaryStrategy::Dictionary {
+    uint32_t id;
+};
+#endif
+
+ZstdDictionaryStrategy::ZstdDictionaryStrategy(int level, size_t dict_bytes, size_t retrain_segments)
+    : level_(level)
+    , dict_bytes_(std::max<size_t>(dict_bytes, 1024))
+    , retrain_segments_(std::max<size_t>(retrain_segments, 1))
+    , sample_budget_(dict_bytes_ * kSamplesPerDictByte) {}
+
+ZstdDictionaryStrategy::~ZstdDictionaryStrategy() = default;
+
+uint32_t ZstdDictionaryStrategy::dictionaryId() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return current_ ? current_->id : 0;
+}
+
+bool ZstdDictionaryStrategy::compressTo(const fs::path& src, const fs::path& dst) {
+#ifdef LOGGER_HAVE_ZSTD
+    // 本段引用的字典在压缩产物落盘（rename）之前登记为占用，修剪时不会删除
+    uint32_t held = 0;
+    bool ok = compressToFile(src, dst, [&](std::ifstream& in, const fs::path& tmp) {
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (in.bad()) return false;
+
+        std::shared_ptr<const Dictionary> dict;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (dir_ != src.parent_path()) {
+                dir_ = src.parent_path();
+                loadLatestLocked(src);
+            }
+            collectSamples(data);
+            ++since_train_;
+            // 第一版在样本够用时立即训练，之后按段数定期重训
+            bool due = sample_total_ >= sample_budget_ / 8 &&
+                       (since_train_ >= retrain_segments_ || (!current_ && !tried_));
+            if (due) {
+                trainLocked(src);
+            }
+            dict = current_;
+            if (dict) {
+                held = dict->id;
+                ++in_use_[held];
+            }
+        }
+
+        std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        if (!cctx) return false;
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, level_);
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_checksumFlag, 1);
+        if (dict && ZSTD_isError(ZSTD_CCtx_refCDict(cctx.get(), dict->cdict.get()))) {
+            return false;
+        }
+
+        std::string packed(ZSTD_compressBound(data.size()), '\0');
+        size_t n = ZSTD_compress2(cctx.get(), &packed[0], packed.size(), data.data(), data.size());
+        if (ZSTD_isError(n)) {
+            std::cerr << "[Compression] zstd: " << ZSTD_getErrorName(n) << "\n";
+            return false;
+        }
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(out.write(packed.data(), static_cast<std::streamsize>(n)).flush());
+    });
+    if (held) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--in_use_[held] == 0) {
+            in_use_.erase(held);
+        }
+    }
+    return ok;
+#else
+    return ZstdCompressionStrategy(level_).compressTo(src, dst);
+#endif
+}
+
+void ZstdDictionaryStrategy::collectSamples(const std::string& data) {
+    if (data.empty()) return;
+
+    // 每段最多贡献 1/8 的样本预算，均匀分布在段内，保证样本覆盖多个段
+    size_t count = std::max<size_t>(1, std::min(data.size() / kSampleBytes,
+                                                sample_budget_ / 8 / kSampleBytes));
+    size_t stride = data.size() / count;
+    for (size_t i = 0; i < count; ++i) {
+        samples_.push_back(data.substr(i * stride, kSampleBytes));
+        sample_total_ += samples_.back().size();
+    }
+    while (sample_total_ > sample_budget_ && samples_.size() > 1) {
+        sample_total_ -= samples_.front().size();
+        samples_.pop_front();
+    }
+}
+
+void ZstdDictionaryStrategy::trainLocked(const fs::path& segment) {
+#ifdef LOGGER_HAVE_ZSTD
+    tried_ = true;
+    since_train_ = 0;
+
+    std::string all;
+    std::vector<size_t> sizes;
+    all.reserve(sample_total_);
+    for (const auto& s : samples_) {
+        all += s;
+        sizes.push_back(s.size());
+    }
+    std::string dict(dict_bytes_, '\0');
+    size_t n = ZDICT_trainFromBuffer(&dict[0], dict.size(), all.data(), sizes.data(),
+                                     static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(n)) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            std::cerr << "[Compression] zstd dictionary training failed: "
+                      << ZDICT_getErrorName(n) << "\n";
+        }
+        return;
+    }
+    dict.resize(n);
+
+    // 字典 ID 取目录中已有版本的下一个，写进字典头（训练时生成的是随机 ID）
+    const auto dict_dir = zstdDictionaryPath(segment, 0).parent_path();
+    std::error_code ec;
+    fs::create_directories(dict_dir, ec);
+    uint32_t id = kFirstDictId;
+    for (const auto& e : fs::directory_iterator(dict_dir, ec)) {
+        uint32_t existing = 0;
+        if (parseDictionaryName(e.path(), existing)) id = std::max(id, existing);
+    }
+    ++id;
+    uint32_t magic = 0;
+    std::memcpy(&magic, dict.data(), sizeof(magic));
+    if (magic != kDictMagic) return;
+    std::memcpy(&dict[4], &id, sizeof(id));
+
+    std::unique_ptr<ZSTD_CDict, size_t (*)(ZSTD_CDict*)> cdict(
+        ZSTD_createCDict(dict.data(), dict.size(), level_), ZSTD_freeCDict);
+    if (!cdict || !writeDurably(zstdDictionaryPath(segment, id), dict)) return;
+
+    previous_id_ = current_ ? current_->id : 0;
+    current_ = std::make_shared<const Dictionary>(Dictionary{id, std::move(cdict)});
+    pruneLocked(segment);
+#else
+    (void)segment;
+#endif
+}
+
+void ZstdDictionaryStrategy::loadLatestLocked(const fs::path& segment) {
+#ifdef LOGGER_HAVE_ZSTD
+    current_.reset();
+    previous_id_ = 0;
+    since_train_ = 0;
+    tried_ = false;
+
+    std::error_code ec;
+    uint32_t latest = 0;
+    for (const auto& e : fs::directory_iterator(zstdDictionaryPath(segment, 0).parent_path(), ec)) {
+        uint32_t id = 0;
+        if (parseDictionaryName(e.path(), id)) latest = std::max(latest, id);
+    }
+    if (latest == 0) return;
+
+    std::ifstream in(zstdDictionaryPath(segment, latest), std::ios::binary);
+    std::string dict((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::unique_ptr<ZSTD_CDict, size_t (*)(ZSTD_CDict*)> cdict(
+        ZSTD_createCDict(dict.data(), dict.size(), level_), ZSTD_freeCDict);
+    if (!dict.empty() && cdict) {
+        current_ = std::make_shared<const Dictionary>(Dictionary{latest, std::move(cdict)});
+        tried_ = true;
+    }
+#else
+    (void)segment;
+#endif
+}
+
+void ZstdDictionaryStrategy::pruneLocked(const fs::path& segment) {
+    std::set<uint32_t> referenced{previous_id_};
+    if (current_) referenced.insert(current_->id);
+    for (const auto& kv : in_use_) {
+        referenced.insert(kv.first);
+    }
+
+    std::error_code ec;
+    for (const auto& e : fs::directory_iterator(segment.parent_path(), ec)) {
+        if (e.is_regular_file() && e.path().extension() == ".zst") {
+            referenced.insert(zstdDictionaryId(e.path()));
+        }
+    }
+    for (const auto& e : fs::directory_iterator(zstdDictionaryPath(segment, 0).parent_path(), ec)) {
+        uint32_t id = 0;
+        if (parseDictionaryName(e.path(), id) && !referenced.count(id)) {
+            std::error_code rm_ec;
+            fs::remove(e.path(), rm_ec);
+        }
+    }
+}
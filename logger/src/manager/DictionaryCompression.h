@@ -0,0 +1,57 @@
+#pragma once
+#include "CompressionStrategies.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief 使用训练字典的 zstd 压缩策略
+ *
+ * 小段（1 MB 左右）里重复的行前缀（级别、文件名、函数名）在单文件压缩时来不及被建模，
+ * 用从最近的段里训练出的字典可以在段开头就命中这些重复内容。
+ *   - 每个段压缩前从中均匀截取样本，样本总量约为字典大小的 100 倍；
+ *   - 样本够用后训练第一版字典，此后每 retrain_segments 个段用最近的样本重新训练；
+ *   - 字典按版本存放在 <段目录>/.dict/<字典 ID>.zdict（ID = 32768 + 版本号），
+ *     ID 写在每个段的 zstd 帧头里，readSegmentFile 按 ID 自动加载；
+ *   - 训练新版本时删除已没有段引用的旧字典（保留当前与上一版本，以及正在压缩的段所用的版本）。
+ * 整段读入内存后一次压缩，适合段较小的模块；字典训练前的段不带字典。
+ */
+class ZstdDictionaryStrategy : public CodecCompressionStrategy {
+public:
+    ZstdDictionaryStrategy(int level, size_t dict_bytes, size_t retrain_segments);
+    ~ZstdDictionaryStrategy() override;
+
+    bool compressTo(const std::filesystem::path& src, const std::filesystem::path& dst) override;
+    std::string compressedExtension() const override { return ".zst"; }
+
+    // 当前使用的字典 ID；尚未训练时为 0
+    uint32_t dictionaryId() const;
+
+private:
+    struct Dictionary;
+
+    void collectSamples(const std::string& data);
+    // 以当前样本训练新版本并写入 dir/.dict，失败时保持原字典
+    void trainLocked(const std::filesystem::path& dir);
+    // 启动时沿用目录中最新的字典
+    void loadLatestLocked(const std::filesystem::path& dir);
+    void pruneLocked(const std::filesystem::path& dir);
+
+    int level_;
+    size_t dict_bytes_;
+    size_t retrain_segments_;
+    size_t sample_budget_;
+
+    mutable std::mutex mtx_;
+    std::filesystem::path dir_;                  // 已加载字典的段目录
+    std::shared_ptr<const Dictionary> current_;
+    uint32_t previous_id_ = 0;
+    std::map<uint32_t, size_t> in_use_;         // 正在压缩的段所用字典 ID → 段数
+    std::deque<std::string> samples_;
+    size_t sample_total_ = 0;
+    size_t since_train_ = 0;                    // 上次训练以来压缩的段数
+    bool tried_ = false;                        // 已尝试过训练（失败后等下一个重训周期）
+};
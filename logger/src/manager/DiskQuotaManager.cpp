@@ -0,0 +1,237 @@
+#include "DiskQuotaManager.h"
+#include "CompressionPool.h"
+#include "SegmentManifest.h"
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <sys/stat.h>
+
+namespace {
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool deviceOf(const std::filesystem::path& dir, dev_t& dev) {
+    struct stat st{};
+    if (::stat(dir.c_str(), &st) != 0) return false;
+    dev = st.st_dev;
+    return true;
+}
+
+// 写入中、正在压缩与正在迁移的段不能删除
+bool removable(const SegmentManifest& manifest, const SegmentManifest::Segment& seg) {
+    return seg.state != SegmentManifest::State::Active &&
+           !CompressionPool::instance().inFlight(manifest.path(seg)) &&
+           !TierMigrator::instance().inFlight(manifest.dir() / seg.fileName());
+}
+}  // namespace
+
+DiskQuotaManager& DiskQuotaManager::instance() {
+    static DiskQuotaManager inst;
+    return inst;
+}
+
+// ============================================
+// 配置
+// ============================================
+void DiskQuotaManager::configure(uint64_t total_bytes, DiskPolicy free_space,
+                                 std::map<std::string, ModuleDiskQuota> quotas) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    total_budget_ = total_bytes;
+    if (free_space.isValid()) {
+        free_space_ = free_space;
+    }
+    quotas_ = std::move(quotas);
+}
+
+void DiskQuotaManager::setQuota(const std::string& module, ModuleDiskQuota quota) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    quotas_[module] = quota;
+}
+
+ModuleDiskQuota DiskQuotaManager::quota(const std::string& module) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = quotas_.find(module);
+    return it != quotas_.end() ? it->second : ModuleDiskQuota{};
+}
+
+DiskPolicy DiskQuotaManager::freeSpacePolicy() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return free_space_;
+}
+
+uint64_t DiskQuotaManager::totalBudget() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return total_budget_;
+}
+
+void DiskQuotaManager::track(const std::string& module, std::shared_ptr<SegmentManifest> manifest) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(),
+        [](const Tracked& t) { return t.manifest.expired(); }), tracked_.end());
+    tracked_.push_back({module, std::move(manifest)});
+}
+
+std::shared_ptr<SegmentManifest> DiskQuotaManager::manifestFor(const std::filesystem::path& dir) const {
+    const auto key = dir.lexically_normal();
+    for (auto& m : live()) {
+        if (m.manifest->dir().lexically_normal() == key) {
+            return std::move(m.manifest);
+        }
+    }
+    return nullptr;
+}
+
+std::vector<DiskQuotaManager::Live> DiskQuotaManager::live() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<Live> out;
+    tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(),
+        [&out](const Tracked& t) {
+            auto m = t.manifest.lock();
+            if (!m) return true;
+            out.push_back({t.module, std::move(m)});
+            return false;
+        }), tracked_.end());
+    return out;
+}
+
+// ============================================
+// 保留与回收
+// ============================================
+size_t DiskQuotaManager::enforce(const std::string& module,
+                                 const std::shared_ptr<SegmentManifest>& manifest) {
+    size_t removed = enforceModule(module, manifest);
+    return removed + enforceBudget();
+}
+
+size_t DiskQuotaManager::enforceAll() {
+    size_t removed = 0;
+    for (const auto& m : live()) {
+        removed += enforceModule(m.module, m.manifest);
+    }
+    return removed + enforceBudget();
+}
+
+void DiskQuotaManager::enforceIfDue() {
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (now - last_sweep_ < kSweepInterval) return;
+        last_sweep_ = now;
+    }
+    enforceAll();
+}
+
+size_t DiskQuotaManager::enforceModule(const std::string& module,
+                                       const std::shared_ptr<SegmentManifest>& manifest) {
+    const auto q = quota(module);
+    size_t removed = 0;
+    if (manifest && (q.max_bytes > 0 || q.max_age.count() > 0)) {
+        const int64_t cutoff = q.max_age.count() > 0
+            ? nowMicros() - std::chrono::duration_cast<std::chrono::microseconds>(q.max_age).count()
+            : std::numeric_limits<int64_t>::min();
+        // 写入中段尚未计入目录，按写入方的内存计数算进热层
+        uint64_t bytes = manifest->hotBytes();
+        // 段目录按序号从旧到新：最旧的段既最先过期，也最先因超出（热层）字节上限被删除
+        for (const auto& seg : manifest->segments()) {
+            bool expired = seg.last_us < cutoff;
+            bool over = seg.tier == 0 && q.max_bytes > 0 && bytes > q.max_bytes;
+            if (!expired && !over) continue;
+            if (!removable(*manifest, seg)) continue;
+            if (manifest->remove(seg)) {
+                if (seg.tier == 0) bytes -= std::min(bytes, seg.bytes);
+                ++removed;
+            }
+        }
+    }
+    return removed;
+}
+
+size_t DiskQuotaManager::enforceBudget() {
+    const uint64_t budget = totalBudget();
+    if (budget == 0) return 0;
+    return reclaim([budget](uint64_t total) { return total <= budget; });
+}
+
+size_t DiskQuotaManager::reclaim(const std::function<bool(uint64_t total_bytes)>& done,
+                                 const ReclaimScope& scope) {
+    std::lock_guard<std::mutex> reclaim_lock(reclaim_mtx_);
+    auto modules = live();
+    dev_t device = 0;
+    if (!scope.same_fs.empty() && !deviceOf(scope.same_fs, device)) return 0;
+
+    struct Candidate {
+        size_t module;
+        SegmentManifest::Segment seg;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<uint64_t> bytes(modules.size());
+    std::vector<ModuleDiskQuota> quotas(modules.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < modules.size(); ++i) {
+        bytes[i] = modules[i].manifest->hotBytes();
+        quotas[i] = quota(modules[i].module);
+        total += bytes[i];
+    }
+    if (done(total)) return 0;
+
+    std::vector<size_t> sealed(modules.size(), 0);   // 热层已封口的段数
+    for (size_t i = 0; i < modules.size(); ++i) {
+        dev_t dev = 0;
+        if (!scope.same_fs.empty() && (!deviceOf(modules[i].manifest->dir(), dev) || dev != device)) {
+            continue;
+        }
+        for (auto& seg : modules[i].manifest->segments()) {
+            if (seg.tier != 0 || seg.state == SegmentManifest::State::Active) continue;
+            ++sealed[i];
+            if (removable(*modules[i].manifest, seg)) {
+                candidates.push_back({i, std::move(seg)});
+            }
+        }
+    }
+    // 已压缩在前；同类按模块权重从小到大；同权重按最后写入时间从旧到新
+    std::sort(candidates.begin(), candidates.end(), [&](const Candidate& a, const Candidate& b) {
+        return std::make_tuple(a.seg.codec.empty(), quotas[a.module].weight, a.seg.last_us, a.seg.seq) <
+               std::make_tuple(b.seg.codec.empty(), quotas[b.module].weight, b.seg.last_us, b.seg.seq);
+    });
+
+    size_t removed = 0;
+    for (const auto& c : candidates) {
+        if (done(total)) break;
+        auto& module_bytes = bytes[c.module];
+        if (module_bytes < quotas[c.module].min_bytes + c.seg.bytes) continue;   // 最小保证
+        if (sealed[c.module] <= scope.min_keep_segments) continue;
+        if (modules[c.module].manifest->remove(c.seg)) {
+            module_bytes -= c.seg.bytes;
+            --sealed[c.module];
+            total -= std::min(total, c.seg.bytes);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+std::vector<DiskQuotaManager::ModuleUsage> DiskQuotaManager::usage() const {
+    std::map<std::string, ModuleUsage> merged;
+    for (const auto& m : live()) {
+        auto& u = merged[m.module];
+        u.module = m.module;
+        u.bytes += m.manifest->hotBytes();
+        u.cold_bytes += m.manifest->totalBytes() - m.manifest->tierBytes(0);
+        u.segments += m.manifest->size();
+    }
+    std::vector<ModuleUsage> out;
+    for (auto& kv : merged) {
+        out.push_back(std::move(kv.second));
+    }
+    return out;
+}
+
+uint64_t DiskQuotaManager::totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& m : live()) {
+        total += m.manifest->hotBytes();
+    }
+    return total;
+}
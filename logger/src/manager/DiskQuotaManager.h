@@ -0,0 +1,112 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DiskSpaceGuard.h"
+#include "TierMigrator.h"
+
+class SegmentManifest;
+
+// 单个模块的磁盘配额与保留规则（按模块名配置，所有进程目录共用）
+struct ModuleDiskQuota {
+    uint64_t max_bytes = 0;            // 模块段文件总字节上限，0 为不限
+    uint64_t min_bytes = 0;            // 全局回收时至少为模块保留的字节
+    double weight = 1.0;               // 全局回收优先级：越小越先被回收
+    std::chrono::minutes max_age{0};   // 最后写入早于此时长的段被删除（所有层），0 为不限
+    // 冷存储层，从近到远；dir 为冷层根目录，RollingFileManager 在其下按 <module>/<进程名> 建目录
+    std::vector<TierMigrator::Tier> cold_tiers;
+};
+
+// 回收范围：可用空间不足时只有同一文件系统上的段能腾出空间
+struct ReclaimScope {
+    std::filesystem::path same_fs;   // 非空时只回收与该目录在同一文件系统上的段目录
+    size_t min_keep_segments = 0;    // 每个段目录热层至少保留的已封口段数
+};
+
+/**
+ * @brief 进程级磁盘配额管理：所有模块共享一个磁盘预算
+ *
+ * 各 RollingFileManager 把自己的段目录登记进来（弱引用，管理器释放后自动注销）。
+ * 轮转后、以及空间采样线程每 kSweepInterval 一次，先按模块自身的字节上限与时间保留删除最旧段，
+ * 再检查所有模块的总字节（写入中的段按内存中的字节数计入）；
+ * 超出总预算、或文件系统可用空间低于软限制时，按全局优先级跨模块回收：
+ *   已压缩的段优先于未压缩的，同类中权重小的模块优先，同模块内最旧的优先，
+ * 删除后会使模块低于最小保证的段跳过。可用空间不足引起的回收只涉及同一文件系统上的段目录，
+ * 且每个目录至少保留 DiskPolicy::min_keep_files 个段。
+ * 候选与字节数都来自段目录，回收过程不扫描目录。写入中、正在压缩与正在迁移的段不参与回收。
+ *
+ * 分层存储时，字节上限、最小保证、总预算与跨模块回收都只针对热层（冷层由 TierMigrator
+ * 按各层上限回收），时间保留对所有层生效。
+ */
+class DiskQuotaManager {
+public:
+    struct ModuleUsage {
+        std::string module;
+        uint64_t bytes = 0;         // 热层
+        uint64_t cold_bytes = 0;    // 所有冷层
+        size_t segments = 0;
+    };
+
+    static DiskQuotaManager& instance();
+
+    // 设置总预算（0 为不限）、可用空间阈值与各模块配额；未列出的模块按默认配额
+    void configure(uint64_t total_bytes, DiskPolicy free_space,
+                   std::map<std::string, ModuleDiskQuota> quotas);
+    void setQuota(const std::string& module, ModuleDiskQuota quota);
+    ModuleDiskQuota quota(const std::string& module) const;
+    DiskPolicy freeSpacePolicy() const;
+    uint64_t totalBudget() const;
+
+    // 登记模块的段目录
+    void track(const std::string& module, std::shared_ptr<SegmentManifest> manifest);
+    // 热层目录为 dir 的段目录；未登记时返回空
+    std::shared_ptr<SegmentManifest> manifestFor(const std::filesystem::path& dir) const;
+
+    // 轮转后调用：执行模块的字节与时间保留，再执行全局总预算；返回删除的段数
+    size_t enforce(const std::string& module, const std::shared_ptr<SegmentManifest>& manifest);
+    // 对所有登记的目录执行保留与总预算
+    size_t enforceAll();
+    // 距上次周期检查超过 kSweepInterval 时执行 enforceAll（由空间采样线程调用，
+    // 不再写入的模块也能按时间保留删段）
+    void enforceIfDue();
+    static constexpr std::chrono::seconds kSweepInterval{10};
+    // 按全局优先级逐段回收，直到 done(剩余总字节) 为真或没有可回收的段；返回删除的段数
+    size_t reclaim(const std::function<bool(uint64_t total_bytes)>& done,
+                   const ReclaimScope& scope = {});
+
+    // 各模块当前占用（同名模块的多个目录合并）
+    std::vector<ModuleUsage> usage() const;
+    // 所有模块热层的总字节
+    uint64_t totalBytes() const;
+
+private:
+    struct Tracked {
+        std::string module;
+        std::weak_ptr<SegmentManifest> manifest;
+    };
+    struct Live {
+        std::string module;
+        std::shared_ptr<SegmentManifest> manifest;
+    };
+
+    DiskQuotaManager() = default;
+    std::vector<Live> live() const;
+    size_t enforceModule(const std::string& module, const std::shared_ptr<SegmentManifest>& manifest);
+    size_t enforceBudget();
+
+    mutable std::mutex mtx_;
+    uint64_t total_budget_ = 0;
+    DiskPolicy free_space_ = DiskPolicy::fromMB(100, 50, 2);
+    std::map<std::string, ModuleDiskQuota> quotas_;
+    mutable std::vector<Tracked> tracked_;
+    std::chrono::steady_clock::time_point last_sweep_ = std::chrono::steady_clock::now();
+
+    // 同一时刻只有一个回收者，避免多个模块线程重复挑选同一批段
+    std::mutex reclaim_mtx_;
+};
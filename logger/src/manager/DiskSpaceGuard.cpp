@@ -1,4 +1,8 @@
 #include "DiskSpaceGuard.h"
+#include "CompressionPool.h"
+#include "CompressionStrategies.h"
+#include "DiskQuotaManager.h"
+#include "SegmentManifest.h"
 #include <filesystem>
 #include <algorithm>
 #include <iostream>
@@ -12,6 +16,85 @@ static uint64_t freeBytes(const fs::path& p) {
     return (uint64_t)space.available;
 }
 
+// ============================================
+// 空间预算与后台采样
+// ============================================
+DiskBudget::DiskBudget(fs::path dir) : dir_(std::move(dir)) {
+    refresh();
+}
+
+void DiskBudget::refresh() {
+    available_.store(static_cast<int64_t>(freeBytes(dir_)), std::memory_order_relaxed);
+}
+
+DiskBudgetSampler& DiskBudgetSampler::instance() {
+    static DiskBudgetSampler inst;
+    return inst;
+}
+
+DiskBudgetSampler::~DiskBudgetSampler() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::shared_ptr<DiskBudget> DiskBudgetSampler::track(const fs::path& dir) {
+    auto budget = std::make_shared<DiskBudget>(dir);
+    std::lock_guard<std::mutex> lock(mtx_);
+    budgets_.push_back(budget);
+    if (!thread_.joinable() && !stop_) {
+        // 采样线程会调用配额管理器：先构造它，保证它晚于采样线程析构
+        DiskQuotaManager::instance();
+        thread_ = std::thread(&DiskBudgetSampler::run, this);
+    }
+    return budget;
+}
+
+void DiskBudgetSampler::setInterval(std::chrono::milliseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        interval_ = interval;
+    }
+    cv_.notify_all();
+}
+
+std::chrono::milliseconds DiskBudgetSampler::interval() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return interval_;
+}
+
+void DiskBudgetSampler::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_) {
+        cv_.wait_for(lock, interval_, [this] { return stop_; });
+        if (stop_) break;
+        
+        // 顺带清理已释放的预算
+        std::vector<std::shared_ptr<DiskBudget>> live;
+        budgets_.erase(std::remove_if(budgets_.begin(), budgets_.end(),
+            [&live](const std::weak_ptr<DiskBudget>& w) {
+                auto b = w.lock();
+                if (!b) return true;
+                live.push_back(std::move(b));
+                return false;
+            }), budgets_.end());
+        
+        // statfs 与周期保留都不持锁执行，避免阻塞 track()
+        lock.unlock();
+        for (auto& b : live) {
+            b->refresh();
+        }
+        live.clear();
+        DiskQuotaManager::instance().enforceIfDue();
+        lock.lock();
+    }
+}
+
 // ============================================
 // 默认回收策略实现
 // ============================================
@@ -23,16 +106,8 @@ std::vector<std::filesystem::path> DefaultReclaimStrategy::selectFilesToRemove(
         return {};
     }
     
-    // 复制候选列表并按时间排序（最旧的优先）
-    auto sorted = candidates;
-    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
-        std::error_code e1, e2;
-        return fs::last_write_time(a, e1) < fs::last_write_time(b, e2);
-    });
-    
-    // 返回前 max_to_remove 个文件
-    size_t count = std::min(max_to_remove, sorted.size());
-    return std::vector<fs::path>(sorted.begin(), sorted.begin() + count);
+    size_t count = std::min(max_to_remove, candidates.size());
+    return std::vector<fs::path>(candidates.begin(), candidates.begin() + count);
 }
 
 // ============================================
@@ -43,7 +118,8 @@ DiskSpaceGuard::DiskSpaceGuard(const fs::path dir,
                                std::string ext, 
                                DiskPolicy policy)
     : dir_(dir), prefix_(std::move(prefix)), ext_(std::move(ext)), 
-      policy_(policy), reclaim_strategy_(std::make_shared<DefaultReclaimStrategy>()) {}
+      policy_(policy), reclaim_strategy_(std::make_shared<DefaultReclaimStrategy>()),
+      budget_(DiskBudgetSampler::instance().track(dir_)) {}
 
 DiskSpaceGuard::DiskSpaceGuard(fs::path dir, 
                                std::string prefix, 
@@ -51,22 +127,36 @@ DiskSpaceGuard::DiskSpaceGuard(fs::path dir,
                                DiskPolicy policy,
                                std::shared_ptr<IReclaimStrategy> strategy)
     : dir_(std::move(dir)), prefix_(std::move(prefix)), ext_(std::move(ext)), 
-      policy_(policy), reclaim_strategy_(std::move(strategy)) {
+      policy_(policy), reclaim_strategy_(std::move(strategy)),
+      budget_(DiskBudgetSampler::instance().track(dir_)) {
     if (!reclaim_strategy_) {
         reclaim_strategy_ = std::make_shared<DefaultReclaimStrategy>();
     }
 }
 
 bool DiskSpaceGuard::ensureSoft() {
-    if (freeBytes(dir_) >= policy_.soft_min_free_bytes) {
+    if (budget_->available() >= static_cast<int64_t>(policy_.soft_min_free_bytes)) {
         return true;
     }
-    reclaimUtilSoft();
-    return freeBytes(dir_) >= policy_.soft_min_free_bytes;
+    // 空间持续不足（如被其他进程占满、无可回收的段）时不在每次写入都 statfs 与回收：
+    // 两次慢路径之间只看采样线程刷新的预算
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_slow_path_) {
+        return false;
+    }
+    next_slow_path_ = now + DiskBudgetSampler::instance().interval();
+    
+    // 慢路径：先以实测值确认，再回收
+    budget_->refresh();
+    if (budget_->available() < static_cast<int64_t>(policy_.soft_min_free_bytes)) {
+        reclaimUtilSoft();
+        budget_->refresh();
+    }
+    return budget_->available() >= static_cast<int64_t>(policy_.soft_min_free_bytes);
 }
 
 bool DiskSpaceGuard::hardPressure() const {
-    return freeBytes(dir_) < policy_.hard_min_free_bytes;
+    return budget_->available() < static_cast<int64_t>(policy_.hard_min_free_bytes);
 }
 
 void DiskSpaceGuard::setPolicy(const DiskPolicy& p) {
@@ -75,6 +165,7 @@ void DiskSpaceGuard::setPolicy(const DiskPolicy& p) {
 
 void DiskSpaceGuard::setDir(const fs::path& dir) {
     dir_ = dir;
+    budget_ = DiskBudgetSampler::instance().track(dir_);
 }
 
 void DiskSpaceGuard::setReclaimStrategy(std::shared_ptr<IReclaimStrategy> strategy) {
@@ -83,6 +174,10 @@ void DiskSpaceGuard::setReclaimStrategy(std::shared_ptr<IReclaimStrategy> strate
     }
 }
 
+void DiskSpaceGuard::setManifest(std::shared_ptr<SegmentManifest> manifest) {
+    manifest_ = std::move(manifest);
+}
+
 void DiskSpaceGuard::setOnReclaimCallback(OnReclaimCallback callback) {
     on_reclaim_ = std::move(callback);
 }
@@ -105,8 +200,22 @@ void DiskSpaceGuard::collectCandidates(std::vector<fs::path>& gz,
                                        std::vector<fs::path>& txt) const {
     gz.clear();
     txt.clear();
-    std::error_code ec;
     
+    if (manifest_) {
+        // 段目录已按序号从旧到新排列；写入中的段不参与回收
+        for (const auto& seg : manifest_->segments()) {
+            // 冷层的段不占本目录所在文件系统的空间
+            if (seg.state == SegmentManifest::State::Active || seg.tier != 0) continue;
+            if (!prefix_.empty() && !hasPrefix(seg.name, prefix_)) continue;
+            auto p = manifest_->path(seg);
+            if (CompressionPool::instance().inFlight(p)) continue;
+            (seg.codec.empty() ? txt : gz).push_back(std::move(p));
+        }
+        return;
+    }
+    
+    std::vector<std::pair<fs::file_time_type, fs::path>> packed, plain;
+    std::error_code ec;
     for (const auto& e : fs::directory_iterator(dir_, ec)) {
         if (ec) break;
         if (!e.is_regular_file()) continue;
@@ -115,28 +224,34 @@ void DiskSpaceGuard::collectCandidates(std::vector<fs::path>& gz,
         const auto fname = p.filename().string();
         
         if (!prefix_.empty() && !hasPrefix(fname, prefix_)) continue;
+        // 排队或正在压缩的段不参与回收，压缩完成后以压缩文件形式重新成为候选
+        if (CompressionPool::instance().inFlight(p)) continue;
         
-        if (p.extension() == ".gz") {
+        std::error_code t_ec;
+        if (isCompressedExtension(p.extension())) {
             if (p.stem().extension().string() == ext_) {
-                gz.push_back(p);
+                packed.emplace_back(e.last_write_time(t_ec), p);
             }
         } else if (p.extension() == ext_) {
-            txt.push_back(p);
+            plain.emplace_back(e.last_write_time(t_ec), p);
         }
     }
     
-    auto by_time_asc = [](const fs::path& a, const fs::path& b) {
-        std::error_code e1, e2;
-        return fs::last_write_time(a, e1) < fs::last_write_time(b, e2);
-    };
-    
-    std::sort(gz.begin(), gz.end(), by_time_asc);
-    std::sort(txt.begin(), txt.end(), by_time_asc);
+    // 每个文件只取一次修改时间再排序，比较器里不做 stat
+    auto by_time_asc = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std::sort(packed.begin(), packed.end(), by_time_asc);
+    std::sort(plain.begin(), plain.end(), by_time_asc);
+    for (auto& f : packed) gz.push_back(std::move(f.second));
+    for (auto& f : plain) txt.push_back(std::move(f.second));
 }
 
 bool DiskSpaceGuard::tryRemoveFile(const fs::path& path) {
     std::error_code ec;
     fs::remove(path, ec);
+    // 文件已不存在（外部删除）时 remove 不报错，同样移出段目录
+    if (manifest_ && !ec) {
+        manifest_->forget(path);
+    }
     
     if (!ec) {
         if (on_reclaim_) {
@@ -151,6 +266,15 @@ bool DiskSpaceGuard::tryRemoveFile(const fs::path& path) {
 }
 
 void DiskSpaceGuard::reclaimUtilSoft() {
+    if (manifest_) {
+        // 有段目录时跨模块按全局优先级回收；只有同一文件系统上的段能腾出空间，
+        // 每个目录仍保留 min_keep_files 个段
+        const uint64_t soft = policy_.soft_min_free_bytes;
+        DiskQuotaManager::instance().reclaim([this, soft](uint64_t) { return freeBytes(dir_) >= soft; },
+                                             {dir_, policy_.min_keep_files});
+        return;
+    }
+    
     std::vector<fs::path> gz, txt;
     collectCandidates(gz, txt);
     
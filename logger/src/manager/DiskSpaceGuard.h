@@ -4,6 +4,15 @@
 #include <vector>
 #include <cstdint>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class SegmentManifest;
+
 struct DiskPolicy {
     uint64_t soft_min_free_bytes;  // 软限制：清理到这个值
     uint64_t hard_min_free_bytes;  // 硬限制：低于此值暂停写入
@@ -22,18 +31,65 @@ struct DiskPolicy {
     }
 };
 
+/**
+ * @brief 某目录所在文件系统的可用空间预算
+ *
+ * 后台采样线程定期用 statfs 刷新；写入路径只做原子减法，不进内核。
+ * 两次采样之间的误差由下一次采样纠正。
+ */
+class DiskBudget {
+public:
+    explicit DiskBudget(std::filesystem::path dir);
+    
+    int64_t available() const { return available_.load(std::memory_order_relaxed); }
+    void consume(size_t bytes) {
+        available_.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+    // 立即重新采样（采样线程与回收路径调用）
+    void refresh();
+    const std::filesystem::path& dir() const { return dir_; }
+    
+private:
+    std::filesystem::path dir_;
+    std::atomic<int64_t> available_{0};
+};
+
+// 进程级的空间采样线程：持有各预算的弱引用，按固定间隔刷新
+class DiskBudgetSampler {
+public:
+    static DiskBudgetSampler& instance();
+    
+    // 登记目录并立即采样一次；首次调用时启动采样线程
+    std::shared_ptr<DiskBudget> track(const std::filesystem::path& dir);
+    void setInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds interval();
+    
+    ~DiskBudgetSampler();
+    
+private:
+    DiskBudgetSampler() = default;
+    void run();
+    
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<std::weak_ptr<DiskBudget>> budgets_;
+    std::chrono::milliseconds interval_{1000};
+    std::thread thread_;
+    bool stop_ = false;
+};
+
 // 文件回收策略接口（多态扩展点）
 class IReclaimStrategy {
 public:
     virtual ~IReclaimStrategy() = default;
     
-    // 返回应该删除的文件列表（已排序）
+    // candidates 已按从旧到新排序；返回应该删除的文件列表
     virtual std::vector<std::filesystem::path> selectFilesToRemove(
         const std::vector<std::filesystem::path>& candidates,
         size_t max_to_remove) const = 0;
 };
 
-// 默认策略：优先删除 .gz，然后按时间排序
+// 默认策略：按候选顺序删除最旧的（DiskSpaceGuard 先删已压缩的段，再删未压缩的）
 class DefaultReclaimStrategy : public IReclaimStrategy {
 public:
     std::vector<std::filesystem::path> selectFilesToRemove(
@@ -56,18 +112,25 @@ public:
                    std::string ext, 
                    DiskPolicy policy,
                    std::shared_ptr<IReclaimStrategy> strategy);
-    // 确保软限制（清理旧文件）
+    // 确保软限制（预算充足时不触发系统调用；不足时清理旧文件并重新采样，
+    // 慢路径每个采样间隔最多一次，其间直接返回缓存预算的结论）
     bool ensureSoft();
     
-    // 检查是否触发硬限制
+    // 检查是否触发硬限制（只读缓存的预算）
     bool hardPressure() const;
     
+    // 记录已写入的字节，从缓存的预算中扣除
+    void consume(size_t bytes) { budget_->consume(bytes); }
+    
     // 更新策略
     void setPolicy(const DiskPolicy& p);
     
     // 更新目录
     void setDir(const std::filesystem::path& dir);
     void setReclaimStrategy(std::shared_ptr<IReclaimStrategy> strategy);
+    // 由段目录提供候选（不扫描目录）；设置后空间不足时交给 DiskQuotaManager 跨模块回收，
+    // 为空时扫描 dir、只回收本目录
+    void setManifest(std::shared_ptr<SegmentManifest> manifest);
     using OnReclaimCallback = std::function<void(const std::filesystem::path&)>;
     void setOnReclaimCallback(OnReclaimCallback callback);
     
@@ -89,4 +152,7 @@ private:
     bool tryRemoveFile(const std::filesystem::path& path);
     std::shared_ptr<IReclaimStrategy> reclaim_strategy_;
     OnReclaimCallback on_reclaim_;
+    std::shared_ptr<DiskBudget> budget_;
+    std::shared_ptr<SegmentManifest> manifest_;
+    std::chrono::steady_clock::time_point next_slow_path_{};   // 慢路径最早的下次执行时间
 };
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "FramedSegment.h"
+#include "CompressionStrategies.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+constexpr uint32_t kIndexMagic = 0x4946474C;       // "LGFI"
+constexpr uint32_t kSkippableMagic = 0x184D2A5E;   // zstd 与 LZ4 解码器都会跳过的帧
+constexpr size_t kEntryBytes = 24;
+constexpr size_t kTrailerBytes = 8;                // u32 N + u32 magic
+// 空 gzip 成员的数据部分：空的最终 deflate 块 + CRC32(0) + ISIZE(0)
+constexpr unsigned char kEmptyDeflateTail[10] = {0x03, 0x00, 0, 0, 0, 0, 0, 0, 0, 0};
+// FEXTRA 总长度上限 65535，扣除子字段头与尾部后能容纳的帧数
+constexpr size_t kMaxGzipIndexFrames = (65535 - 4 - kTrailerBytes) / kEntryBytes;
+// 按策略刷新时，暂存超过这个时长的数据才提前结束成帧（其余只把已写出的帧交给内核）
+constexpr int64_t kFlushFrameSpanUs = 1000000;
+
+template <typename T>
+void putLe(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <typename T>
+T getLe(const char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 相邻的帧两两合并为一项（连续的 gzip 成员 / zstd 帧本身就能连续解压），直到不超过 max 项；
+// 索引变粗但仍可定位
+std::vector<FrameIndexEntry> coalesceIndex(std::vector<FrameIndexEntry> index, size_t max) {
+    while (index.size() > max) {
+        std::vector<FrameIndexEntry> merged;
+        merged.reserve((index.size() + 1) / 2);
+        for (size_t i = 0; i < index.size(); i += 2) {
+            FrameIndexEntry e = index[i];
+            if (i + 1 < index.size()) {
+                const auto& next = index[i + 1];
+                e.compressed_size += next.compressed_size;
+                e.raw_size += next.raw_size;
+                e.first_time_us = std::min(e.first_time_us, next.first_time_us);
+                e.last_time_us = std::max(e.last_time_us, next.last_time_us);
+            }
+            merged.push_back(e);
+        }
+        index = std::move(merged);
+    }
+    return index;
+}
+
+bool appendFrameIndex(const std::vector<FrameIndexEntry>& index,
+                      IFrameEncoder::IndexFormat format, std::string& out) {
+    std::string body;
+    for (const auto& e : index) {
+        putLe(body, e.compressed_size);
+        putLe(body, e.raw_size);
+        putLe(body, e.first_time_us);
+        putLe(body, e.last_time_us);
+    }
+    putLe(body, static_cast<uint32_t>(index.size()));
+    putLe(body, kIndexMagic);
+
+    if (format == IFrameEncoder::IndexFormat::SkippableFrame) {
+        putLe(out, kSkippableMagic);
+        putLe(out, static_cast<uint32_t>(body.size()));
+        out += body;
+        return true;
+    }
+
+    if (index.size() > kMaxGzipIndexFrames) {
+        return false;
+    }
+    // 10 字节 gzip 头：FLG = FEXTRA，OS = 255（未知）
+    const unsigned char header[10] = {0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff};
+    out.append(reinterpret_cast<const char*>(header), sizeof(header));
+    putLe(out, static_cast<uint16_t>(body.size() + 4));
+    out += "LX";
+    putLe(out, static_cast<uint16_t>(body.size()));
+    out += body;
+    out.append(reinterpret_cast<const char*>(kEmptyDeflateTail), sizeof(kEmptyDeflateTail));
+    return true;
+}
+}  // namespace
+
+// ============================================
+// FramedSegmentWriter
+// ============================================
+FramedSegmentWriter::FramedSegmentWriter(std::unique_ptr<ISegmentWriter> inner,
+                                         std::unique_ptr<IFrameEncoder> encoder)
+    : inner_(std::move(inner)), encoder_(std::move(encoder)) {
+    pending_.reserve(encoder_->frameBytes());
+}
+
+FramedSegmentWriter::~FramedSegmentWriter() {
+    close();
+}
+
+bool FramedSegmentWriter::open(const std::filesystem::path& path) {
+    close();
+    pending_.clear();
+    index_.clear();
+    file_offset_ = 0;
+    failed_ = false;
+    return inner_->open(path);
+}
+
+void FramedSegmentWriter::close() {
+    if (!inner_->isOpen()) return;
+    emitFrame();
+    writeIndex();
+    inner_->close();
+}
+
+void FramedSegmentWriter::closeAsync() {
+    if (!inner_->isOpen()) return;
+    emitFrame();
+    writeIndex();
+    inner_->closeAsync();
+}
+
+void FramedSegmentWriter::stage(const char* data, size_t n) {
+    pending_last_us_ = nowMicros();
+    if (pending_.empty()) {
+        pending_since_us_ = pending_last_us_;
+    }
+    pending_.append(data, n);
+}
+
+bool FramedSegmentWriter::write(GatherBuffer& buf, bool flush_now) {
+    for (const auto& v : buf.iov()) {
+        stage(static_cast<const char*>(v.iov_base), v.iov_len);
+    }
+    // 一批记录整体落在同一帧内，帧边界总在记录边界上；按策略刷新不结束当前帧
+    // （每批一帧会使帧过小），只有暂存过久时才提前成帧
+    if ((pending_.size() >= encoder_->frameBytes() ||
+         (flush_now && !pending_.empty() && pending_last_us_ - pending_since_us_ >= kFlushFrameSpanUs)) &&
+        !emitFrame()) {
+        return false;
+    }
+    return flush_now ? inner_->flush() && good() : good();
+}
+
+bool FramedSegmentWriter::write(const char* data, size_t n) {
+    stage(data, n);
+    if (pending_.size() >= encoder_->frameBytes()) {
+        return emitFrame();
+    }
+    return good();
+}
+
+bool FramedSegmentWriter::flush() {
+    if (!emitFrame()) return false;
+    return inner_->flush();
+}
+
+bool FramedSegmentWriter::emitFrame() {
+    if (pending_.empty()) return good();
+
+    frame_.clear();
+    if (!encoder_->encode(pending_.data(), pending_.size(), frame_) ||
+        !inner_->write(frame_.data(), frame_.size())) {
+        failed_ = true;
+        pending_.clear();
+        return false;
+    }
+    index_.push_back(FrameIndexEntry{file_offset_, static_cast<uint32_t>(frame_.size()),
+                                     static_cast<uint32_t>(pending_.size()), pending_since_us_,
+                                     pending_last_us_});
+    file_offset_ += frame_.size();
+    pending_.clear();
+    return true;
+}
+
+bool FramedSegmentWriter::writeIndex() {
+    if (index_.empty() || failed_) return false;
+
+    frame_.clear();
+    const bool gzip = encoder_->indexFormat() == IFrameEncoder::IndexFormat::GzipMember;
+    if (gzip && index_.size() > kMaxGzipIndexFrames) {
+        // gzip 脚注放不下全部帧：合并相邻帧的索引项，保留可定位的脚注
+        appendFrameIndex(coalesceIndex(index_, kMaxGzipIndexFrames), encoder_->indexFormat(), frame_);
+    } else {
+        appendFrameIndex(index_, encoder_->indexFormat(), frame_);
+    }
+    return inner_->write(frame_.data(), frame_.size());
+}
+
+// ============================================
+// FramedSegmentReader
+// ============================================
+bool FramedSegmentReader::open(const std::filesystem::path& path) {
+    path_ = path;
+    frames_.clear();
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    const uint64_t size = static_cast<uint64_t>(in.tellg());
+
+    auto readAt = [&](uint64_t offset, char* dst, size_t n) {
+        in.seekg(static_cast<std::streamoff>(offset));
+        return static_cast<bool>(in.read(dst, static_cast<std::streamsize>(n)));
+    };
+
+    // 两种封装下索引主体都以 [u32 N][u32 magic] 结尾，gzip 封装后面多 10 字节
+    char trailer[kTrailerBytes];
+    uint64_t body_end = 0;
+    bool gzip = false;
+    if (size >= kTrailerBytes && readAt(size - kTrailerBytes, trailer, sizeof(trailer)) &&
+        getLe<uint32_t>(trailer + 4) == kIndexMagic) {
+        body_end = size;
+    } else if (size >= kTrailerBytes + sizeof(kEmptyDeflateTail) &&
+               readAt(size - sizeof(kEmptyDeflateTail) - kTrailerBytes, trailer, sizeof(trailer)) &&
+               getLe<uint32_t>(trailer + 4) == kIndexMagic) {
+        body_end = size - sizeof(kEmptyDeflateTail);
+        gzip = true;
+    } else {
+        return false;
+    }
+
+    const uint64_t count = getLe<uint32_t>(trailer);
+    const uint64_t body = count * kEntryBytes + kTrailerBytes;
+    const uint64_t wrapper = gzip ? 16 : 8;   // gzip 头 + XLEN + 子字段头 / 可跳过帧头
+    if (body + wrapper > body_end) return false;
+
+    std::string table(static_cast<size_t>(count * kEntryBytes), '\0');
+    if (count > 0 && !readAt(body_end - body, &table[0], table.size())) return false;
+
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const char* p = table.data() + i * kEntryBytes;
+        FrameIndexEntry e{offset, getLe<uint32_t>(p), getLe<uint32_t>(p + 4),
+                          getLe<int64_t>(p + 8), getLe<int64_t>(p + 16)};
+        offset += e.compressed_size;
+        frames_.push_back(e);
+    }
+    // 帧总长必须正好接上脚注
+    if (offset != body_end - body - wrapper) {
+        frames_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool FramedSegmentReader::readFrame(size_t i, std::string& out) const {
+    if (i >= frames_.size()) return false;
+    const auto& e = frames_[i];
+
+    std::ifstream in(path_, std::ios::binary);
+    std::string packed(e.compressed_size, '\0');
+    in.seekg(static_cast<std::streamoff>(e.offset));
+    if (!in.read(&packed[0], static_cast<std::streamsize>(packed.size()))) return false;
+
+    size_t before = out.size();
+    if (!decompressBuffer(path_.extension(), packed.data(), packed.size(), out)) return false;
+    return out.size() - before == e.raw_size;
+}
+
+bool FramedSegmentReader::readRange(std::chrono::system_clock::time_point from,
+                                    std::chrono::system_clock::time_point to,
+                                    std::string& out) const {
+    const int64_t from_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        from.time_since_epoch()).count();
+    const int64_t to_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        to.time_since_epoch()).count();
+
+    bool ok = true;
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        if (frames_[i].first_time_us <= to_us && frames_[i].last_time_us >= from_us) {
+            ok = readFrame(i, out) && ok;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "SegmentWriter.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 帧编码器：把一段原始字节压缩为一个可独立解码的帧
+ *
+ * 由压缩策略创建（见 ICompressionStrategy::makeFrameEncoder），
+ * 帧之间互不依赖，读者可以只解压其中任意一帧。
+ */
+class IFrameEncoder {
+public:
+    // 帧索引的封装方式：zstd / LZ4 放在可跳过帧里，gzip 放在末尾空成员的 FEXTRA 里，
+    // 两种方式对标准解压工具都是透明的
+    enum class IndexFormat { SkippableFrame, GzipMember };
+
+    virtual ~IFrameEncoder() = default;
+    virtual bool encode(const char* data, size_t n, std::string& out) = 0;
+    virtual IndexFormat indexFormat() const = 0;
+    // 目标帧大小（未压缩字节）
+    virtual size_t frameBytes() const = 0;
+};
+
+// 帧索引项：offset 为帧在文件中的偏移，first/last_time_us 为帧内首次与末次写入的系统时间（微秒）
+struct FrameIndexEntry {
+    uint64_t offset;
+    uint32_t compressed_size;
+    uint32_t raw_size;
+    int64_t first_time_us;
+    int64_t last_time_us;
+};
+
+/**
+ * @brief 边写边压缩的段写出后端（包装任意 ISegmentWriter）
+ *
+ * 写入先累积在内存中，达到帧大小后在记录边界处压缩成一帧交给内层后端。
+ * 按刷新策略的刷新（write 的 flush_now）只把已写出的帧交给内核，暂存超过 1 秒才提前成帧；
+ * 显式 flush() 与关闭结束当前帧。尚未成帧的数据在崩溃时丢失。
+ * gzip 脚注容纳不下全部帧时合并相邻帧的索引项（索引变粗，仍可定位）。
+ * 关闭时写出帧索引脚注，轮转后不再需要二次压缩。
+ *
+ * 脚注格式（小端）：
+ *   [FrameIndexEntry 去掉 offset 后的 24 字节项 × N][u32 N][u32 "LGFI"]
+ * SkippableFrame 在其前加 8 字节可跳过帧头；GzipMember 把它作为空 gzip 成员的
+ * FEXTRA 子字段 "LX"，其后固定为 10 字节的空 deflate 块 + CRC + ISIZE。
+ * 段中途崩溃时没有脚注，已写出的完整帧仍可顺序解压。
+ */
+class FramedSegmentWriter : public ISegmentWriter {
+public:
+    FramedSegmentWriter(std::unique_ptr<ISegmentWriter> inner,
+                        std::unique_ptr<IFrameEncoder> encoder);
+    ~FramedSegmentWriter() override;
+
+    bool open(const std::filesystem::path& path) override;
+    void close() override;
+    void closeAsync() override;
+    bool isOpen() const override { return inner_->isOpen(); }
+    bool good() const override { return inner_->good() && !failed_; }
+
+    bool write(GatherBuffer& buf, bool flush_now) override;
+    bool write(const char* data, size_t n) override;
+    bool flush() override;
+    void setBufferSize(size_t bytes) override { inner_->setBufferSize(bytes); }
+    void setDurable(bool durable) override { inner_->setDurable(durable); }
+
+private:
+    void stage(const char* data, size_t n);
+    // 把暂存数据压缩为一帧写给内层后端
+    bool emitFrame();
+    bool writeIndex();
+
+    std::unique_ptr<ISegmentWriter> inner_;
+    std::unique_ptr<IFrameEncoder> encoder_;
+    std::string pending_;
+    std::string frame_;
+    int64_t pending_since_us_ = 0;
+    int64_t pending_last_us_ = 0;
+    uint64_t file_offset_ = 0;
+    std::vector<FrameIndexEntry> index_;
+    bool failed_ = false;
+};
+
+/**
+ * @brief 带帧索引的压缩段读取
+ *
+ * 只读脚注与所需的帧：按时间窗读取时不必从头解压整个段。
+ */
+class FramedSegmentReader {
+public:
+    // 读取帧索引；文件没有脚注（非流式压缩或写入中途崩溃）时返回 false
+    bool open(const std::filesystem::path& path);
+
+    const std::vector<FrameIndexEntry>& frames() const { return frames_; }
+    bool readFrame(size_t i, std::string& out) const;
+    // 只解压写入时间与 [from, to] 重叠的帧
+    bool readRange(std::chrono::system_clock::time_point from,
+                   std::chrono::system_clock::time_point to,
+                   std::string& out) const;
+
+private:
+    std::filesystem::path path_;
+    std::vector<FrameIndexEntry> frames_;
+};
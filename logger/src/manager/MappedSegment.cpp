@@ -0,0 +1,194 @@
+#include "MappedSegment.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char kMagic[4] = {'L', 'G', 'M', 'S'};
+}  // namespace
+
+MappedSegment::~MappedSegment() {
+    seal();
+    close();
+}
+
+bool MappedSegment::open(const std::filesystem::path& path, size_t capacity) {
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[MappedSegment] Failed to open " << path << ": "
+                  << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    size_t existing = static_cast<size_t>(st.st_size);
+
+    // 已有内容必须是本格式且能放进容量，否则交给调用方换新段
+    if (existing > 0) {
+        char head[kFileHeaderBytes] = {};
+        bool valid = existing >= kFileHeaderBytes && existing % 8 == 0 && existing < capacity &&
+                     ::pread(fd_, head, sizeof(head), 0) == static_cast<ssize_t>(sizeof(head)) &&
+                     std::memcmp(head, kMagic, sizeof(kMagic)) == 0;
+        if (!valid) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    }
+
+    // 预分配整段：映射区写入不会因缺页分配块而触发 SIGBUS；
+    // 文件系统不支持时退回稀疏扩展
+    if (::fallocate(fd_, 0, 0, static_cast<off_t>(capacity)) != 0 &&
+        ::ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+        std::cerr << "[MappedSegment] Failed to preallocate " << path << ": "
+                  << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void* p = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "[MappedSegment] mmap failed for " << path << ": "
+                  << std::strerror(errno) << "\n";
+        ::ftruncate(fd_, static_cast<off_t>(existing));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(p);
+    capacity_ = capacity;
+
+    if (existing == 0) {
+        uint32_t version = kVersion;
+        std::memcpy(base_, kMagic, sizeof(kMagic));
+        std::memcpy(base_ + sizeof(kMagic), &version, sizeof(version));
+        existing = kFileHeaderBytes;
+    }
+
+    tail_.store(existing, std::memory_order_relaxed);
+    overflow_at_.store(UINT64_MAX, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+    open_.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void MappedSegment::seal() {
+    // 与 reserve 中的 writers_ 递增 / open_ 读取构成 Dekker 式配对，须 seq_cst
+    open_.store(false, std::memory_order_seq_cst);
+    while (writers_.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void MappedSegment::close() {
+    if (fd_ < 0) return;
+
+    uint64_t used = std::min<uint64_t>(tail_.load(std::memory_order_acquire),
+                                       overflow_at_.load(std::memory_order_acquire));
+    used = std::min<uint64_t>(used, capacity_);
+
+    ::munmap(base_, capacity_);
+    if (::ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+        std::cerr << "[MappedSegment] Failed to truncate segment: "
+                  << std::strerror(errno) << "\n";
+    }
+    ::close(fd_);
+    fd_ = -1;
+    base_ = nullptr;
+    capacity_ = 0;
+}
+
+uint64_t MappedSegment::committedRecords() const {
+    if (!base_) return 0;
+    uint64_t used = std::min<uint64_t>(tail_.load(std::memory_order_acquire),
+                                       overflow_at_.load(std::memory_order_acquire));
+    used = std::min<uint64_t>(used, capacity_);
+    uint64_t records = 0;
+    for (uint64_t pos = kFileHeaderBytes; pos + sizeof(MappedRecordHeader) <= used;) {
+        const auto* header = reinterpret_cast<const MappedRecordHeader*>(base_ + pos);
+        if (header->length == 0) break;
+        if (header->commit == kMappedCommitMarker) ++records;
+        pos += frameBytes(header->length);
+    }
+    return records;
+}
+
+MappedSegment::Reservation MappedSegment::reserve(size_t len) {
+    Reservation r;
+    writers_.fetch_add(1, std::memory_order_seq_cst);
+    if (!open_.load(std::memory_order_seq_cst)) {
+        writers_.fetch_sub(1, std::memory_order_release);
+        return r;
+    }
+
+    size_t frame = frameBytes(len);
+    uint64_t offset = tail_.fetch_add(frame, std::memory_order_relaxed);
+    if (offset + frame > capacity_) {
+        // 记下最早的越界点，关闭时据此截断
+        uint64_t seen = overflow_at_.load(std::memory_order_relaxed);
+        while (offset < seen &&
+               !overflow_at_.compare_exchange_weak(seen, offset, std::memory_order_acq_rel)) {
+        }
+        writers_.fetch_sub(1, std::memory_order_release);
+        r.status = ReserveStatus::Full;
+        return r;
+    }
+
+    auto* header = reinterpret_cast<MappedRecordHeader*>(base_ + offset);
+    __atomic_store_n(&header->length, static_cast<uint32_t>(len), __ATOMIC_RELAXED);
+    r.data = base_ + offset + sizeof(MappedRecordHeader);
+    r.status = ReserveStatus::Ok;
+    return r;
+}
+
+void MappedSegment::commit(const Reservation& r) {
+    auto* header = reinterpret_cast<MappedRecordHeader*>(r.data - sizeof(MappedRecordHeader));
+    __atomic_store_n(&header->commit, kMappedCommitMarker, __ATOMIC_RELEASE);
+    writers_.fetch_sub(1, std::memory_order_release);
+}
+
+bool MappedSegment::forEachRecord(const std::filesystem::path& path,
+                                  const std::function<void(const uint8_t*, size_t)>& fn,
+                                  size_t* skipped) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+    if (bytes.size() < kFileHeaderBytes ||
+        std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+
+    size_t pos = kFileHeaderBytes;
+    while (pos + sizeof(MappedRecordHeader) <= bytes.size()) {
+        MappedRecordHeader header;
+        std::memcpy(&header, bytes.data() + pos, sizeof(header));
+        if (header.length == 0) break;
+
+        size_t frame = frameBytes(header.length);
+        if (pos + frame > bytes.size()) break;
+        if (header.commit == kMappedCommitMarker) {
+            fn(bytes.data() + pos + sizeof(header), header.length);
+        } else if (skipped) {
+            ++*skipped;
+        }
+        pos += frame;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+// 段内每条记录的帧头：length 在预留时写入，commit 在负载拷贝完成后最后写入
+struct MappedRecordHeader {
+    uint32_t length;   // 负载字节数（不含帧头与对齐填充）
+    uint32_t commit;   // kMappedCommitMarker 表示记录完整
+};
+static_assert(sizeof(MappedRecordHeader) == 8, "mapped record header must stay 8 bytes");
+
+constexpr uint32_t kMappedCommitMarker = 0x54494D43;  // "CMIT"
+
+/**
+ * @brief 预分配 + mmap 的定长段，多生产者无锁追加
+ *
+ * 打开时 fallocate 到固定容量并整体映射。生产者一次 fetch_add 预留字节区间，
+ * 直接把记录拷进映射区，最后以 release 写入提交标记；读者跳过未提交的记录。
+ * 关闭时截断到实际使用的长度。
+ *
+ * 段格式：8 字节文件头（"LGMS" + u32 版本），之后为 8 字节对齐的
+ * [MappedRecordHeader | 负载 | 填充] 序列，length 为 0 处即有效数据末尾。
+ *
+ * open/seal/close 由轮转方串行调用（调用方加锁）；reserve/commit 可并发。
+ */
+class MappedSegment {
+public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kFileHeaderBytes = 8;
+
+    enum class ReserveStatus { Ok, Full, Closed };
+
+    struct Reservation {
+        uint8_t* data = nullptr;
+        ReserveStatus status = ReserveStatus::Closed;
+        explicit operator bool() const { return status == ReserveStatus::Ok; }
+    };
+
+    MappedSegment() = default;
+    ~MappedSegment();
+
+    MappedSegment(const MappedSegment&) = delete;
+    MappedSegment& operator=(const MappedSegment&) = delete;
+
+    // 映射 path（已有内容时从其末尾继续追加）；文件头不匹配时返回 false
+    bool open(const std::filesystem::path& path, size_t capacity);
+    // 阻止新的预留，并等待在途写入全部提交
+    void seal();
+    // 截断到已用长度并解除映射（须先 seal）
+    void close();
+    // 段内已提交的记录数：遍历映射区的帧头（须先 seal，供轮转时写入段目录）
+    uint64_t committedRecords() const;
+
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+    // 每次 open 加一，轮转方据此判断段是否已被其它线程换掉
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+    // 一条负载在段内实际占用的字节数（帧头 + 对齐）
+    static size_t frameBytes(size_t len) { return (sizeof(MappedRecordHeader) + len + 7) & ~size_t(7); }
+
+    // 预留 len 字节负载；成功后必须调用 commit
+    Reservation reserve(size_t len);
+    void commit(const Reservation& r);
+
+    /**
+     * @brief 顺序读取段文件中已提交的记录
+     *
+     * 未提交的记录按 length 跳过并计入 skipped；遇到 length 为 0
+     * （未写到的预分配区或崩溃时刚预留的记录）即停止。文件头不匹配时返回 false。
+     */
+    static bool forEachRecord(const std::filesystem::path& path,
+                              const std::function<void(const uint8_t*, size_t)>& fn,
+                              size_t* skipped = nullptr);
+
+private:
+    int fd_ = -1;
+    uint8_t* base_ = nullptr;
+    size_t capacity_ = 0;
+
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    // 第一条越界预留的起点：越界之后 tail_ 不再代表已用长度
+    std::atomic<uint64_t> overflow_at_{UINT64_MAX};
+    alignas(64) std::atomic<uint32_t> writers_{0};
+    std::atomic<bool> open_{false};
+    std::atomic<uint64_t> generation_{0};
+};
@@ -1,55 +1,41 @@
 #include "RollingFileManager.h"
-#include <zlib.h>
+#include "CompressionPool.h"
+#include "CompressionStrategies.h"
+#include "DiskQuotaManager.h"
+#include "TierMigrator.h"
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <fcntl.h>
 
-// ============================================
-// 默认压缩策略实现（使用 gzip）
-// ============================================
-class GzipCompressionStrategy : public ICompressionStrategy {
-public:
-    bool compress(const std::filesystem::path& src) override {
-        std::ifstream in(src, std::ios::binary);
-        if (!in) return false;
-        
-        auto gzPath = src.string() + ".gz";
-        gzFile out = gzopen(gzPath.c_str(), "wb");
-        if (!out) return false;
-        
-        char buffer[1 << 16];
-        while (in) {
-            in.read(buffer, sizeof(buffer));
-            auto n = in.gcount();
-            if (n > 0) {
-                gzwrite(out, buffer, static_cast<unsigned int>(n));
-            }
-        }
-        
-        gzclose(out);
-        in.close();
-        
-        std::error_code ec;
-        std::filesystem::remove(src, ec);
-        return !ec;
-    }
-    
-    std::string compressedExtension() const override {
-        return ".gz";
-    }
-};
+namespace {
+// 把已写完的文件移出页缓存：脏页须先落盘，DONTNEED 只丢弃干净页
+void dropPageCache(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+int64_t toMicros(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+}  // namespace
 
 // ============================================
 // RollingFileManager 实现
 // ============================================
 RollingFileManager::RollingFileManager(Config config)
     : base_dir_(ProcessUtils::getProcessLogDir(config.base_dir)),
+      module_(config.base_dir.filename().string()),
       pattern_(std::move(config.pattern)),
       max_bytes_(config.max_bytes),
       max_age_(config.max_age),
       reserve_n_(config.reserve_n),
       compress_(config.compress_old),
+      io_backend_(config.io_backend),
       rotation_policy_(config.rotation_policy ? 
                       config.rotation_policy : 
                       std::make_shared<HybridRotationPolicy>()),
@@ -58,10 +44,10 @@ RollingFileManager::RollingFileManager(Config config)
                            std::make_shared<GzipCompressionStrategy>()),
       file_created_time_(std::chrono::system_clock::now())
 {
-    // ✅ 在构造函数体内初始化 guard_
+    // ✅ 在构造函数体内初始化 guard_（可用空间阈值取全局配置）
     guard_ = std::make_unique<DiskSpaceGuard>(
         base_dir_, "", expectedExtension(),
-        DiskPolicy{100ULL * 1024 * 1024, 50ULL * 1024 * 1024, 2}
+        DiskQuotaManager::instance().freeSpacePolicy()
     );
     
     std::error_code ec;
@@ -70,17 +56,13 @@ RollingFileManager::RollingFileManager(Config config)
         std::cerr << "[RollingFileManager] Failed to create directory: " 
                   << base_dir_ << " - " << ec.message() << std::endl;
     }
+    manifest_ = std::make_shared<SegmentManifest>(base_dir_, expectedExtension());
+    guard_->setManifest(manifest_);
+    DiskQuotaManager::instance().track(module_, manifest_);
     
-    auto resume = findLatestAppendableFile();
-    if (!resume.empty()) {
-        current_path_ = resume;
-        ofs_.open(current_path_, std::ios::out | std::ios::app);
-        if (!ofs_.is_open()) {
-            rollToNewFile();
-        }
-    } else {
-        rollToNewFile();
-    }
+    openInitialSegment();
+    setColdTiers(DiskQuotaManager::instance().quota(module_).cold_tiers);
+    requeueLeftovers();
 }
 
 RollingFileManager::RollingFileManager(
@@ -89,21 +71,24 @@ RollingFileManager::RollingFileManager(
     size_t maxBytes,
     std::chrono::minutes maxAge,
     size_t reserveN,
-    bool compressOld)
+    bool compressOld,
+    std::shared_ptr<ICompressionStrategy> compression)
     : base_dir_(ProcessUtils::getProcessLogDir(baseDir)),
+      module_(baseDir.filename().string()),
       pattern_(std::move(pattern)),
       max_bytes_(maxBytes),
       max_age_(maxAge),
       reserve_n_(reserveN),
       compress_(compressOld),
       rotation_policy_(std::make_shared<HybridRotationPolicy>()),
-      compression_strategy_(std::make_shared<GzipCompressionStrategy>()),
+      compression_strategy_(compression ? std::move(compression)
+                                        : std::make_shared<GzipCompressionStrategy>()),
       file_created_time_(std::chrono::system_clock::now())
 {
-    // ✅ 在构造函数体内初始化 guard_
+    // ✅ 在构造函数体内初始化 guard_（可用空间阈值取全局配置）
     guard_ = std::make_unique<DiskSpaceGuard>(
         base_dir_, "", expectedExtension(),
-        DiskPolicy{100ULL * 1024 * 1024, 50ULL * 1024 * 1024, 2}
+        DiskQuotaManager::instance().freeSpacePolicy()
     );
     
     std::error_code ec;
@@ -112,27 +97,57 @@ RollingFileManager::RollingFileManager(
         std::cerr << "[RollingFileManager] Failed to create directory: " 
                   << base_dir_ << " - " << ec.message() << std::endl;
     }
+    manifest_ = std::make_shared<SegmentManifest>(base_dir_, expectedExtension());
+    guard_->setManifest(manifest_);
+    DiskQuotaManager::instance().track(module_, manifest_);
+    
+    openInitialSegment();
+    setColdTiers(DiskQuotaManager::instance().quota(module_).cold_tiers);
+    requeueLeftovers();
+}
+
+void RollingFileManager::openInitialSegment() {
+    stream_ = compress_ && compression_strategy_ && compression_strategy_->makeFrameEncoder();
+    writer_ = makeWriter(io_backend_);
+    drop_cache_ = io_backend_ == IoBackend::Direct;
     
-    auto resume = findLatestAppendableFile();
+    // 压缩段不能续写：边写边压缩时总是新建段，上次遗留的未压缩段交给 requeueLeftovers
+    auto resume = stream_ ? std::filesystem::path{} : findLatestAppendableFile();
     if (!resume.empty()) {
         current_path_ = resume;
-        ofs_.open(current_path_, std::ios::out | std::ios::app);
-        if (!ofs_.is_open()) {
+        openSegment();
+        if (io_backend_ != IoBackend::Mmap && !writer_->isOpen()) {
             rollToNewFile();
+        } else {
+            std::error_code size_ec;
+            auto sz = std::filesystem::file_size(current_path_, size_ec);
+            current_bytes_ = size_ec ? 0 : static_cast<size_t>(sz);
+            manifest_->setActiveBytes(current_bytes_);
+            current_name_ = current_path_.filename().string();
+            manifest_->update(current_name_, [this](SegmentManifest::Segment& seg) {
+                current_records_ = seg.records;
+                seg.state = SegmentManifest::State::Active;
+            });
         }
     } else {
         rollToNewFile();
     }
 }
 
-RollingFileManager::~RollingFileManager() {
-    if (ofs_.is_open()) {
-        ofs_.close();
+std::unique_ptr<ISegmentWriter> RollingFileManager::makeWriter(IoBackend backend) const {
+    auto writer = makeSegmentWriter(backend);
+    if (stream_) {
+        return std::make_unique<FramedSegmentWriter>(std::move(writer),
+                                                     compression_strategy_->makeFrameEncoder());
     }
+    return writer;
 }
 
-std::ofstream& RollingFileManager::stream() {
-    return ofs_;
+RollingFileManager::~RollingFileManager() {
+    if (writer_) {
+        writer_->close();
+        sealCurrent();
+    }
 }
 
 std::filesystem::path RollingFileManager::currentPath() const {
@@ -160,70 +175,319 @@ bool RollingFileManager::ensureWritable(size_t /*bytes_hint*/) {
     return true;
 }
 
+bool RollingFileManager::preallocate(size_t bytes) {
+    if (!ensureWritable(bytes)) {
+        return false;
+    }
+    guard_->consume(bytes);
+    // 映射段按容量预分配，封口前按整段计入热层占用
+    manifest_->setActiveBytes(current_bytes_ + bytes);
+    return true;
+}
+
 bool RollingFileManager::needRotate() {
-    if (!ofs_.is_open()) return true;
+    if (io_backend_ != IoBackend::Mmap && !writer_->isOpen()) return true;
     
-    try {
-        auto sz = std::filesystem::file_size(current_path_);
-        auto age = std::chrono::duration_cast<std::chrono::minutes>(
-            std::chrono::system_clock::now() - file_created_time_
-        );
-        
-        // 使用策略模式判断是否需要轮转
-        return rotation_policy_->shouldRotate(sz, age, max_bytes_, max_age_);
-    } catch (...) {
-        return true;
+    // system_clock::now 走 vDSO，段大小取内存计数，整个判断不进内核
+    auto age = std::chrono::duration_cast<std::chrono::minutes>(
+        std::chrono::system_clock::now() - file_created_time_
+    );
+    
+    // 使用策略模式判断是否需要轮转
+    return rotation_policy_->shouldRotate(current_bytes_, age, max_bytes_, max_age_);
+}
+
+size_t RollingFileManager::remainingBytes() const {
+    if (current_bytes_ >= max_bytes_) return 0;
+    return max_bytes_ - current_bytes_;
+}
+
+void RollingFileManager::noteWritten(size_t bytes) {
+    current_bytes_ += bytes;
+    unflushed_bytes_ += bytes;
+    guard_->consume(bytes);
+    manifest_->setActiveBytes(current_bytes_);
+}
+
+void RollingFileManager::openSegment() {
+    if (io_backend_ != IoBackend::Mmap) {
+        writer_->open(current_path_);
     }
+    unflushed_bytes_ = 0;
+    last_flush_ = std::chrono::steady_clock::now();
 }
 
-void RollingFileManager::rotate() {
-    if (ofs_.is_open()) {
-        ofs_.flush();
-        ofs_.close();
+void RollingFileManager::setIoBackend(IoBackend backend) {
+    writer_->close();
+    io_backend_ = backend;
+    writer_ = makeWriter(backend);
+    drop_cache_ = backend == IoBackend::Direct;
+    if (buffer_configured_) {
+        writer_->setBufferSize(flush_policy_.buffer_bytes);
     }
+    writer_->setDurable(flush_policy_.sync);
+    openSegment();
+}
+
+void RollingFileManager::setStreamCompression(bool enabled) {
+    enabled = enabled && compress_ && compression_strategy_ &&
+              compression_strategy_->makeFrameEncoder();
+    if (enabled == stream_) return;
     
-    if (compress_) {
-        try { 
-            compressFile(current_path_); 
-        } catch (...) {
-            std::cerr << "[RollingFileManager] Compression failed\n";
+    // 当前段的格式随之改变：关闭并换新段（尚未写入的空段直接删除）
+    writer_->close();
+    std::error_code ec;
+    if (current_bytes_ == 0) {
+        std::filesystem::remove(current_path_, ec);
+        manifest_->erase(current_name_);
+    } else {
+        sealCurrent();
+        if (!stream_) {
+            submitCompression(current_path_, drop_cache_);
+        }
+    }
+    stream_ = enabled;
+    writer_ = makeWriter(io_backend_);
+    if (buffer_configured_) {
+        writer_->setBufferSize(flush_policy_.buffer_bytes);
+    }
+    writer_->setDurable(flush_policy_.sync);
+    rollToNewFile();
+}
+
+bool RollingFileManager::append(const char* data, size_t n) {
+    if (!writer_->write(data, n)) return false;
+    noteWritten(n);
+    ++current_records_;
+    return true;
+}
+
+void RollingFileManager::setFlushPolicy(const FlushPolicy& policy) {
+    flush_policy_ = policy;
+    buffer_configured_ = true;
+    writer_->setBufferSize(policy.buffer_bytes);
+    writer_->setDurable(policy.sync);
+}
+
+bool RollingFileManager::flushDue(bool urgent, size_t pending) const {
+    switch (flush_policy_.mode) {
+        case FlushPolicy::Mode::Always:
+            return true;
+        case FlushPolicy::Mode::Never:
+            return urgent;
+        case FlushPolicy::Mode::Bytes:
+            return urgent || unflushed_bytes_ + pending >= flush_policy_.every_bytes;
+        case FlushPolicy::Mode::Interval:
+            return urgent || std::chrono::steady_clock::now() - last_flush_ >= flush_policy_.interval;
+    }
+    return true;
+}
+
+void RollingFileManager::markFlushed() {
+    unflushed_bytes_ = 0;
+    last_flush_ = std::chrono::steady_clock::now();
+}
+
+void RollingFileManager::flushIfDue() {
+    if (unflushed_bytes_ > 0 && flush_policy_.mode == FlushPolicy::Mode::Interval &&
+        std::chrono::steady_clock::now() - last_flush_ >= flush_policy_.interval) {
+        flush();
+    }
+}
+
+void RollingFileManager::flush() {
+    if (writer_->isOpen()) {
+        writer_->flush();
+    }
+    markFlushed();
+}
+
+void RollingFileManager::rotate() {
+    bool drop_cache = drop_cache_;
+    if (stream_) {
+        // 段已按帧压缩，关闭时写出帧索引即完成
+        writer_->close();
+        sealCurrent();
+        if (drop_cache) {
+            dropPageCache(current_path_);
+        }
+    } else if (compress_) {
+        // 压缩要读取完整文件，必须等写入落定；压缩本身交给后台线程池，不占用调用方的锁
+        writer_->close();
+        sealCurrent();
+        submitCompression(current_path_, drop_cache);
+    } else {
+        // 旧段的剩余写入可以异步完成
+        writer_->closeAsync();
+        sealCurrent();
+        if (drop_cache) {
+            dropPageCache(current_path_);
         }
     }
+    // 异步关闭的段要等剩余写入完成，下次轮转时再迁移
+    const std::string hold = stream_ || compress_ ? std::string{} : current_name_;
     
     enforceReserveN();
     rollToNewFile();
+    // 刚封口的段已不是写入中状态，可以参与按字节与时间的保留
+    DiskQuotaManager::instance().enforce(module_, manifest_);
+    scheduleMigration(hold);
+    if (on_segment_start_) {
+        on_segment_start_();
+    }
 }
 
-void RollingFileManager::enforceReserveN() {
-    std::vector<std::filesystem::directory_entry> entries;
+void RollingFileManager::sealCurrent() {
+    if (current_name_.empty()) return;
+    std::error_code ec;
+    auto size = std::filesystem::file_size(current_path_, ec);
+    // 边写边压缩时 current_bytes_ 是压缩前的字节数，段已同步关闭，只认磁盘大小；
+    // 其余后端异步关闭时文件可能尚未写完，取两者较大者
+    uint64_t bytes = current_bytes_;
+    if (!ec) {
+        bytes = stream_ ? size : std::max<uint64_t>(size, current_bytes_);
+    }
+    const int64_t now = toMicros(std::chrono::system_clock::now());
+    manifest_->update(current_name_, [&](SegmentManifest::Segment& seg) {
+        seg.bytes = bytes;
+        seg.last_us = now;
+        seg.records = current_records_;
+        seg.state = seg.codec.empty() ? SegmentManifest::State::Sealed
+                                      : SegmentManifest::State::Compressed;
+    });
+    manifest_->setActiveBytes(0);   // 已计入目录
+}
+
+void RollingFileManager::submitCompression(const std::filesystem::path& src, bool drop_cache) {
+    std::string packed_ext = compression_strategy_ ? compression_strategy_->compressedExtension() : "";
+    auto manifest = manifest_;
+    auto tiers = cold_tiers_;
+    CompressionPool::instance().submit(src, compression_strategy_,
+        [drop_cache, packed_ext, manifest, tiers](const std::filesystem::path& src, bool ok) {
+            const std::filesystem::path packed = src.string() + packed_ext;
+            std::error_code ec;
+            auto size = std::filesystem::file_size(packed, ec);
+            // 源段已不存在而压缩产物在：上次压缩完成后段目录没来得及记下
+            if (!ec && (ok || !std::filesystem::exists(src, ec))) {
+                bool recorded = manifest->update(src.filename().string(), [&](SegmentManifest::Segment& seg) {
+                    seg.codec = packed_ext;
+                    seg.bytes = size;
+                    seg.state = SegmentManifest::State::Compressed;
+                });
+                // 压缩完成即可迁往冷层
+                if (recorded && !tiers.empty()) {
+                    TierMigrator::instance().submit(manifest, src.filename().string(), tiers);
+                }
+            }
+            // 直写模式：压缩产物（以及压缩失败时留下的原段）不再留在页缓存
+            if (drop_cache) {
+                dropPageCache(ok ? packed : src);
+            }
+        });
+}
+
+void RollingFileManager::requeueLeftovers() {
     std::error_code ec;
+    const auto wantExt = expectedExtension();
     
-    for (auto& entry : std::filesystem::directory_iterator(base_dir_, ec)) {
+    for (auto& e : std::filesystem::directory_iterator(base_dir_, ec)) {
         if (ec) break;
-        if (entry.is_regular_file()) {
-            entries.push_back(entry);
+        if (!e.is_regular_file()) continue;
+        
+        // 任意编解码器的临时产物（xxx.log.zst.tmp 等），以及重新压缩时的解压临时文件（xxx.log.tmp）
+        const auto& p = e.path();
+        if (p.extension() == ".tmp" && (isCompressedExtension(p.stem().extension()) ||
+                                        (!wantExt.empty() && p.stem().extension() == wantExt))) {
+            if (!CompressionPool::instance().inFlight(p.parent_path() / p.stem().stem())) {
+                std::error_code rm_ec;
+                std::filesystem::remove(p, rm_ec);   // 上次压缩中途退出的残留
+            }
+            continue;
+        }
+        // 段目录不知道的段（外来文件或掉电丢失的日志尾部）补登记；
+        // 已迁到冷层、源文件没来得及删除的段删除残留
+        std::filesystem::path stale;
+        manifest_->adopt(e, 0, &stale);
+        if (!stale.empty()) {
+            std::error_code rm_ec;
+            std::filesystem::remove(stale, rm_ec);
         }
     }
     
-    std::sort(entries.begin(), entries.end(),
-        [](const auto& a, const auto& b) {
-            std::error_code e1, e2;
-            return a.last_write_time(e1) > b.last_write_time(e2);
-        });
+    // 段目录按序号从旧到新，未压缩的已封口段即上次没压缩完的
+    if (!compress_) return;
+    for (const auto& seg : manifest_->segments()) {
+        if (seg.state == SegmentManifest::State::Sealed && seg.codec.empty() &&
+            seg.name != current_name_) {
+            submitCompression(base_dir_ / seg.name, drop_cache_);
+        }
+    }
+}
+
+void RollingFileManager::setColdTiers(std::vector<TierMigrator::Tier> tiers) {
+    // 冷层目录与热层同构：<冷层根>/<module>/<进程名>
+    cold_tiers_.clear();
+    for (auto& tier : tiers) {
+        std::error_code ec;
+        auto dir = tier.dir / module_ / ProcessUtils::getProcessName();
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            std::cerr << "[RollingFileManager] Failed to create cold tier: " << dir
+                      << " - " << ec.message() << std::endl;
+            continue;
+        }
+        cold_tiers_.push_back({std::move(dir), tier.max_bytes});
+    }
     
-    for (size_t i = reserve_n_; i < entries.size(); ++i) {
-        std::error_code ec2;
-        std::filesystem::remove(entries[i].path(), ec2);
-        if (ec2) {
-            std::cerr << "[RollingFileManager] Failed to remove old file: "
-                      << entries[i].path() << " - " << ec2.message() << std::endl;
+    // 上次迁移中途退出：删除复制到一半的临时文件，登记已到位但没记下的段
+    for (uint32_t i = 0; i < cold_tiers_.size(); ++i) {
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator(cold_tiers_[i].dir, ec)) {
+            if (ec) break;
+            if (!e.is_regular_file()) continue;
+            const auto& p = e.path();
+            if (p.extension() == ".migrating") {
+                if (!TierMigrator::instance().inFlight(base_dir_ / p.stem().filename())) {
+                    std::error_code rm_ec;
+                    std::filesystem::remove(p, rm_ec);
+                }
+                continue;
+            }
+            std::filesystem::path stale;
+            manifest_->adopt(e, i + 1, &stale);
+            if (!stale.empty() && !TierMigrator::instance().inFlight(base_dir_ / stale.filename())) {
+                std::error_code rm_ec;
+                std::filesystem::remove(stale, rm_ec);
+            }
+        }
+    }
+    scheduleMigration({});
+}
+
+void RollingFileManager::scheduleMigration(const std::string& hold) {
+    if (cold_tiers_.empty()) return;
+    // 已压缩的段（不压缩时为已封口的段）迁往第一个冷层；压缩线程池手上的段等压缩完成回调
+    for (const auto& seg : manifest_->segments()) {
+        if (seg.tier != 0 || seg.name == current_name_ || seg.name == hold) continue;
+        bool ready = seg.state == SegmentManifest::State::Compressed ||
+                     (seg.state == SegmentManifest::State::Sealed && !compress_);
+        if (ready && !CompressionPool::instance().inFlight(manifest_->path(seg))) {
+            TierMigrator::instance().submit(manifest_, seg.name, cold_tiers_);
         }
     }
 }
 
-void RollingFileManager::compressFile(const std::filesystem::path& src) {
-    if (compression_strategy_) {
-        compression_strategy_->compress(src);
+void RollingFileManager::enforceReserveN() {
+    // 段目录按序号从旧到新，只删除超出保留数量的最旧段
+    auto segments = manifest_->segments();
+    if (segments.size() <= reserve_n_) return;
+    
+    for (size_t i = 0; i + reserve_n_ < segments.size(); ++i) {
+        const auto& seg = segments[i];
+        // 正在压缩、迁移的段由各自的线程负责，不在这里删除
+        if (seg.name == current_name_ || CompressionPool::instance().inFlight(manifest_->path(seg)) ||
+            TierMigrator::instance().inFlight(base_dir_ / seg.fileName())) continue;
+        manifest_->remove(seg);
     }
 }
 
@@ -256,23 +520,40 @@ std::string RollingFileManager::makeFilename(int seq) const {
 }
 
 void RollingFileManager::rollToNewFile() {
+    const std::string packed_ext = stream_ ? compression_strategy_->compressedExtension() : "";
     for (int i = 0; i < 1000; ++i) {
-        auto candidate = base_dir_ / makeFilename(i);
+        // 段目录里已有的名称（含已压缩的段）直接跳过，只对候选名 stat 一次防止覆盖外来文件
+        auto name = makeFilename(i);
+        if (manifest_->contains(name)) continue;
         std::error_code ec;
-        bool exists_txt = std::filesystem::exists(candidate, ec);
-        bool exists_gz = std::filesystem::exists(candidate.string() + ".gz");
+        if (std::filesystem::exists(base_dir_ / (name + packed_ext), ec)) continue;
         
-        if (!exists_txt && !exists_gz) {
-            current_path_ = candidate;
-            ofs_.open(current_path_, std::ios::out | std::ios::app);
-            file_created_time_ = std::chrono::system_clock::now();
-            return;
-        }
+        current_path_ = base_dir_ / (name + packed_ext);
+        current_name_ = name;
+        openSegment();
+        file_created_time_ = std::chrono::system_clock::now();
+        current_bytes_ = 0;
+        current_records_ = 0;
+        manifest_->begin(name, packed_ext, toMicros(file_created_time_));
+        manifest_->setActiveBytes(0);
+        return;
     }
     
-    current_path_ = base_dir_ / makeFilename(999);
-    ofs_.open(current_path_, std::ios::out | std::ios::app);
+    current_name_ = makeFilename(999);
+    current_path_ = base_dir_ / (current_name_ + packed_ext);
+    if (stream_) {
+        // 压缩段不能追加：同名压缩段已存在时覆盖
+        std::error_code rm_ec;
+        std::filesystem::remove(current_path_, rm_ec);
+    }
+    openSegment();
     file_created_time_ = std::chrono::system_clock::now();
+    std::error_code ec;
+    auto sz = std::filesystem::file_size(current_path_, ec);
+    current_bytes_ = ec ? 0 : static_cast<size_t>(sz);
+    current_records_ = 0;
+    manifest_->begin(current_name_, packed_ext, toMicros(file_created_time_));
+    manifest_->setActiveBytes(current_bytes_);
 }
 
 std::string RollingFileManager::expectedExtension() const {
@@ -282,29 +563,13 @@ std::string RollingFileManager::expectedExtension() const {
 }
 
 std::filesystem::path RollingFileManager::findLatestAppendableFile() const {
-    std::error_code ec;
-    std::vector<std::filesystem::directory_entry> files;
-    const auto wantExt = expectedExtension();
-    
-    for (auto& e : std::filesystem::directory_iterator(base_dir_, ec)) {
-        if (ec) break;
-        if (!e.is_regular_file()) continue;
-        
-        auto p = e.path();
-        if (p.extension() == ".gz") continue;
-        if (!wantExt.empty() && p.extension() != wantExt) continue;
-        
-        files.push_back(e);
-    }
-    
-    if (files.empty()) return {};
+    // 只看段目录中最新的段：已压缩或已迁到冷层的不能续写
+    SegmentManifest::Segment latest;
+    if (!manifest_->latest(latest) || !latest.codec.empty() || latest.tier != 0) return {};
     
-    std::sort(files.begin(), files.end(), [](auto& a, auto& b) {
-        std::error_code e1, e2;
-        return a.last_write_time(e1) > b.last_write_time(e2);
-    });
-    
-    auto candidate = files.front().path();
+    auto candidate = base_dir_ / latest.name;
+    const auto wantExt = expectedExtension();
+    if (!wantExt.empty() && candidate.extension() != wantExt) return {};
     
     try {
         auto sz = std::filesystem::file_size(candidate);
@@ -321,4 +586,4 @@ std::filesystem::path RollingFileManager::findLatestAppendableFile() const {
     } catch (...) {
         return {};
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,16 @@
 #pragma once
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <chrono>
 #include <string>
 #include <vector>
 #include "DiskSpaceGuard.h"
+#include "SegmentWriter.h"
+#include "FramedSegment.h"
+#include "SegmentManifest.h"
+#include "TierMigrator.h"
+#include "../../include/logger/LoggerConfig.h"
 #include <unistd.h>
 #include <limits.h>
 
@@ -53,8 +59,15 @@ public:
     virtual ~ICompressionStrategy() = default;
     virtual bool compress(const std::filesystem::path& src) = 0;
     virtual std::string compressedExtension() const = 0;
+    // 边写边压缩的帧编码器；返回空表示只在轮转后整段压缩
+    virtual std::unique_ptr<IFrameEncoder> makeFrameEncoder() const { return nullptr; }
 };
 
+// 压缩产物先写到该临时路径，完成后原子 rename；启动时残留的临时文件直接删除
+inline std::filesystem::path compressionTempPath(const std::filesystem::path& dst) {
+    return dst.string() + ".tmp";
+}
+
 
 
 class RollingFileManager {
@@ -72,18 +85,20 @@ public:
         // 新增：策略注入
         std::shared_ptr<IRotationPolicy> rotation_policy;
         std::shared_ptr<ICompressionStrategy> compression_strategy;
+        IoBackend io_backend = IoBackend::Stream;
     };
     
     // 构造函数：支持策略注入
     explicit RollingFileManager(Config config);
     
-    // 传统构造（向后兼容）
+    // 传统构造（向后兼容）；compression 为空时使用 gzip
     RollingFileManager(std::filesystem::path baseDir,
                       std::string pattern,
                       size_t maxBytes,
                       std::chrono::minutes maxAge,
                       size_t reserveN,
-                      bool compressOld);
+                      bool compressOld,
+                      std::shared_ptr<ICompressionStrategy> compression = nullptr);
     // 禁止拷贝
     RollingFileManager(const RollingFileManager&) = delete;
     RollingFileManager& operator=(const RollingFileManager&) = delete;
@@ -94,37 +109,160 @@ public:
     
     ~RollingFileManager();
 
-    std::ofstream& stream();
     std::filesystem::path currentPath() const;
+    // 本目录的段目录（与 DiskSpaceGuard 共享）
+    std::shared_ptr<SegmentManifest> manifest() const { return manifest_; }
+    
+    // 设置冷存储层（dir 为冷层根目录，其下建 <module>/<进程名>）；清理上次迁移的残留，
+    // 并把可迁移的段交给 TierMigrator。构造时按 DiskQuotaManager 中本模块的配置设置
+    void setColdTiers(std::vector<TierMigrator::Tier> tiers);
+    // 已解析到本进程目录的冷层
+    const std::vector<TierMigrator::Tier>& coldTiers() const { return cold_tiers_; }
+    bool good() const { return writer_->good(); }
+    
+    // 切换写出后端；以新后端追加打开当前段。Mmap 时段文件由调用方的映射段直接写入，
+    // 管理器不再打开自己的写出器，只负责命名、轮转、压缩与保留
+    void setIoBackend(IoBackend backend);
+    // 是否边写边压缩（压缩策略提供帧编码器时默认开启）；切换后换新段
+    void setStreamCompression(bool enabled);
+    bool streamCompression() const { return stream_; }
+    
+    // 直接追加一段已编码的字节（进入后端缓冲，不按策略刷新），并记账
+    bool append(const char* data, size_t n);
+    // 每次轮转换上新段后调用（含 writeBatch 中途的轮转），供带段头的格式写入段头
+    void setSegmentStart(std::function<void()> on_start) { on_segment_start_ = std::move(on_start); }
     
+    // 只比较内存中的段大小与段创建时间，不触发系统调用
     bool needRotate();
     void rotate();
+    // 只读缓存的磁盘预算；预算跌破软限制时才进入 statfs/回收慢路径
     bool ensureWritable(size_t bytes_hint);
+    // 映射段整段预分配：检查磁盘预算并一次性记账（段内写入不再逐条记账）
+    bool preallocate(size_t bytes);
+    
+    // 当前段距大小上限还剩多少字节（已满时为 0）
+    size_t remainingBytes() const;
+    // 当前段已写入的字节数（内存计数，打开段时以实际大小初始化）
+    size_t currentBytes() const { return current_bytes_; }
+    // 段由调用方直接写入时（映射段），封口前报告段内的记录数
+    void setCurrentRecords(uint64_t records) { current_records_ = records; }
+    // 设置刷新策略；缓冲大小变化时以新缓冲继续追加当前段（不丢数据）
+    void setFlushPolicy(const FlushPolicy& policy);
+    // Interval 策略下到期则刷新（供空闲时调用）
+    void flushIfDue();
+    void flush();
+    
+    /**
+     * @brief 批量写入：只在段边界处切分批次
+     *
+     * 每个分片做一次轮转/空间检查，把记录编码进 buf 后整体交给后端（fd 后端为一次 writev），
+     * 是否刷新由刷新策略决定；urgent 表示批内有需要立即落盘的记录。
+     * encode(record, buf) 把一条记录追加到 buf 末尾（负载可只引用不拷贝）。返回成功写入的记录数，
+     * 空间不足时剩余记录被丢弃。调用方负责加锁。
+     */
+    template <typename Record, typename Encode>
+    size_t writeBatch(const Record* records, size_t count, GatherBuffer& buf, Encode&& encode,
+                      bool urgent = false) {
+        size_t written = 0;
+        while (written < count) {
+            if (needRotate()) {
+                rotate();
+            }
+            
+            size_t budget = remainingBytes();
+            buf.clear();
+            size_t end = written;
+            encode(records[end++], buf);
+            if (buf.size() > budget && budget < max_bytes_) {
+                // 本段已有内容且放不下首条：先轮转，保证段不超限
+                rotate();
+                budget = remainingBytes();
+            }
+            // 至少放入一条；超出本段剩余容量的部分留到轮转后
+            while (end < count) {
+                auto before = buf.mark();
+                encode(records[end], buf);
+                if (buf.size() > budget) {
+                    buf.truncate(before);
+                    break;
+                }
+                ++end;
+            }
+            
+            if (!ensureWritable(buf.size()) || !writer_->good()) {
+                return written;
+            }
+            // 写入成功后才计入段大小与磁盘预算，失败的批次不会提前触发轮转
+            bool due = flushDue(urgent, buf.size());
+            if (!writer_->write(buf, due)) {
+                return written;
+            }
+            noteWritten(buf.size());
+            if (due) {
+                markFlushed();
+            }
+            current_records_ += end - written;
+            written = end;
+        }
+        return written;
+    }
     
 private:
     void rollToNewFile();
+    // 按后端创建写出器；边写边压缩时包一层帧压缩
+    std::unique_ptr<ISegmentWriter> makeWriter(IoBackend backend) const;
+    // 构造时：续写最近的未满段或新建段
+    void openInitialSegment();
+    // 以当前后端追加打开 current_path_，重置刷新计数
+    void openSegment();
+    void noteWritten(size_t bytes);
+    // pending 为即将写入、尚未计入的字节
+    bool flushDue(bool urgent, size_t pending = 0) const;
+    void markFlushed();
     void enforceReserveN();
-    void compressFile(const std::filesystem::path& src);
+    // 把当前段的最终大小、时间范围与记录数写入段目录
+    void sealCurrent();
+    // 交给压缩线程池；完成后在段目录中记下压缩产物
+    void submitCompression(const std::filesystem::path& src, bool drop_cache);
+    // 启动时清理压缩临时文件，并把上次未压缩完的段重新交给压缩线程池
+    void requeueLeftovers();
+    // 把热层中可迁移的段交给 TierMigrator；hold 为暂不迁移的段（异步关闭尚未完成）
+    void scheduleMigration(const std::string& hold);
     std::string nowStr(const char* fmt) const;
     std::string makeFilename(int seq) const;
     std::string expectedExtension() const;
     std::filesystem::path findLatestAppendableFile() const;
     
     std::filesystem::path base_dir_;
+    std::string module_;             // 模块名（<base>/<module>/<进程名> 中的 module），用于查找磁盘配额
     std::string pattern_;
     size_t max_bytes_;
     std::chrono::minutes max_age_;
     size_t reserve_n_;
     bool compress_;
+    bool stream_ = false;            // 边写边压缩：段本身即压缩文件，轮转后不再二次压缩
+    IoBackend io_backend_ = IoBackend::Stream;
     
     // 策略对象
     std::shared_ptr<IRotationPolicy> rotation_policy_;
     std::shared_ptr<ICompressionStrategy> compression_strategy_;
     
     // 运行时状态
+    std::shared_ptr<SegmentManifest> manifest_;
+    std::vector<TierMigrator::Tier> cold_tiers_;
     std::filesystem::path current_path_;
-    std::ofstream ofs_;
+    std::string current_name_;       // 当前段在段目录中的名称（不含压缩扩展名）
+    uint64_t current_records_ = 0;
+    std::unique_ptr<ISegmentWriter> writer_ = makeSegmentWriter(IoBackend::Stream);
+    bool drop_cache_ = false;        // 直写后端：轮转/压缩后的文件移出页缓存
     std::chrono::system_clock::time_point file_created_time_;
+    size_t current_bytes_ = 0;
+    std::function<void()> on_segment_start_;
+    
+    FlushPolicy flush_policy_;
+    bool buffer_configured_ = false; // 未设置刷新策略时沿用后端默认缓冲
+    size_t unflushed_bytes_ = 0;
+    std::chrono::steady_clock::time_point last_flush_;
     
     std::unique_ptr<DiskSpaceGuard> guard_;
     bool suspend_writes_ = false;
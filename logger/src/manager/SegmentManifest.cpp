@@ -0,0 +1,461 @@
+#include "SegmentManifest.h"
+#include "CompressionStrategies.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+// 日志行数超过 存活段数 × 4 + 1024 时重写为快照
+constexpr size_t kCompactSlack = 1024;
+
+const char* stateName(SegmentManifest::State s) {
+    switch (s) {
+        case SegmentManifest::State::Active: return "active";
+        case SegmentManifest::State::Sealed: return "sealed";
+        case SegmentManifest::State::Compressed: return "compressed";
+    }
+    return "sealed";
+}
+
+SegmentManifest::State parseState(const std::string& s) {
+    if (s == "active") return SegmentManifest::State::Active;
+    if (s == "compressed") return SegmentManifest::State::Compressed;
+    return SegmentManifest::State::Sealed;
+}
+
+std::string putLine(const SegmentManifest::Segment& seg) {
+    nlohmann::json j = {
+        {"op", "put"},
+        {"name", seg.name},
+        {"seq", seg.seq},
+        {"bytes", seg.bytes},
+        {"first_us", seg.first_us},
+        {"last_us", seg.last_us},
+        {"records", seg.records},
+        {"codec", seg.codec},
+        {"state", stateName(seg.state)}
+    };
+    if (seg.tier > 0) {
+        j["tier"] = seg.tier;
+        j["location"] = seg.location;
+    }
+    return j.dump() + "\n";
+}
+
+// 解析一行日志；返回 false 表示不完整的行。del 行只填 name
+bool parseLine(const std::string& line, bool& put, SegmentManifest::Segment& seg) {
+    auto j = nlohmann::json::parse(line, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    seg.name = j.value("name", std::string{});
+    if (seg.name.empty()) return false;
+    put = j.value("op", std::string{}) == "put";
+    if (!put) return true;
+
+    seg.seq = j.value("seq", uint64_t{0});
+    seg.bytes = j.value("bytes", uint64_t{0});
+    seg.first_us = j.value("first_us", int64_t{0});
+    seg.last_us = j.value("last_us", int64_t{0});
+    seg.records = j.value("records", uint64_t{0});
+    seg.codec = j.value("codec", std::string{});
+    seg.state = parseState(j.value("state", std::string{}));
+    seg.tier = j.value("tier", uint32_t{0});
+    seg.location = j.value("location", std::string{});
+    return true;
+}
+
+int64_t toMicros(fs::file_time_type t) {
+    // C++17 没有 clock_cast：以两个时钟的当前时刻对齐
+    auto sys = std::chrono::system_clock::now() +
+               std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                   t - fs::file_time_type::clock::now());
+    return std::chrono::duration_cast<std::chrono::microseconds>(sys.time_since_epoch()).count();
+}
+
+// 按文件名识别段文件（ext 为未压缩段的扩展名），取大小与修改时间
+bool describeFile(const fs::directory_entry& e, const std::string& ext,
+                  SegmentManifest::Segment& seg, fs::file_time_type& mtime) {
+    if (!e.is_regular_file()) return false;
+    const auto& p = e.path();
+    const auto fname = p.filename().string();
+    if (fname.empty() || fname[0] == '.' || p.extension() == ".tmp") return false;
+
+    if (isCompressedExtension(p.extension())) {
+        if (p.stem().extension() != ext) return false;
+        seg.name = p.stem().string();
+        seg.codec = p.extension().string();
+        seg.state = SegmentManifest::State::Compressed;
+    } else if (p.extension() == ext) {
+        seg.name = fname;
+        seg.state = SegmentManifest::State::Sealed;
+    } else {
+        return false;
+    }
+    std::error_code ec;
+    seg.bytes = e.file_size(ec);
+    mtime = e.last_write_time(ec);
+    seg.first_us = seg.last_us = ec ? 0 : toMicros(mtime);
+    return true;
+}
+}  // namespace
+
+SegmentManifest::SegmentManifest(fs::path dir, std::string ext)
+    : dir_(std::move(dir)), ext_(std::move(ext)) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!loadLocked()) {
+        rebuildLocked();
+    }
+    if (rebuilt_ || journal_lines_ > by_seq_.size() * 4 + kCompactSlack) {
+        compactLocked();
+    }
+    openJournalLocked();
+    reconcileLocked();
+}
+
+SegmentManifest::~SegmentManifest() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+// ============================================
+// 加载、重建与核对
+// ============================================
+bool SegmentManifest::loadLocked() {
+    std::ifstream in(dir_ / kJournalName);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        ++journal_lines_;
+        // 崩溃时可能留下写了一半的末行，解析失败的行直接跳过
+        Segment seg;
+        bool put = false;
+        if (!parseLine(line, put, seg)) continue;
+        dropLocked(seg.name);
+        if (!put) continue;
+        next_seq_ = std::max(next_seq_, seg.seq + 1);
+        storeLocked(seg);
+    }
+    return true;
+}
+
+void SegmentManifest::rebuildLocked() {
+    rebuilt_ = true;
+    std::vector<std::pair<fs::file_time_type, Segment>> found;
+    std::error_code ec;
+    for (const auto& e : fs::directory_iterator(dir_, ec)) {
+        if (ec) break;
+        Segment seg;
+        fs::file_time_type mtime;
+        if (describeFile(e, ext_, seg, mtime)) {
+            found.emplace_back(mtime, std::move(seg));
+        }
+    }
+
+    // 每个文件只 stat 一次，按修改时间分配序号
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& f : found) {
+        f.second.seq = next_seq_++;
+        storeLocked(f.second);
+    }
+}
+
+void SegmentManifest::reconcileLocked() {
+    // 上次退出时仍在写入的段：以磁盘实际状态为准
+    std::vector<Segment> active;
+    for (const auto& kv : by_seq_) {
+        if (kv.second.state == State::Active) active.push_back(kv.second);
+    }
+    for (auto& seg : active) {
+        std::error_code ec;
+        auto path = dir_ / seg.fileName();
+        if (!fs::exists(path, ec) && seg.codec.empty()) {
+            for (const auto& ext : compressedExtensions()) {
+                if (fs::exists(dir_ / (seg.name + ext), ec)) {
+                    seg.codec = ext;
+                    path = dir_ / seg.fileName();
+                    break;
+                }
+            }
+        }
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            dropLocked(seg.name);
+            appendLocked(nlohmann::json{{"op", "del"}, {"name", seg.name}}.dump() + "\n");
+            continue;
+        }
+        seg.bytes = size;
+        seg.state = seg.codec.empty() ? State::Sealed : State::Compressed;
+        auto mtime = fs::last_write_time(path, ec);
+        if (!ec) seg.last_us = toMicros(mtime);
+        putLocked(seg);
+    }
+}
+
+// ============================================
+// 日志
+// ============================================
+void SegmentManifest::openJournalLocked() {
+    fd_ = ::open((dir_ / kJournalName).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[SegmentManifest] Failed to open journal in " << dir_ << "\n";
+    }
+}
+
+void SegmentManifest::appendLocked(const std::string& line) {
+    ++journal_lines_;
+    // O_APPEND 的单次 write 不会与其他写者交错
+    if (fd_ >= 0 && ::write(fd_, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+        std::cerr << "[SegmentManifest] Failed to append journal in " << dir_ << "\n";
+    }
+    if (journal_lines_ > by_seq_.size() * 4 + kCompactSlack) {
+        compactLocked();
+    }
+}
+
+void SegmentManifest::compactLocked() {
+    auto path = dir_ / kJournalName;
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (const auto& kv : by_seq_) {
+            out << putLine(kv.second);
+        }
+        if (!out.flush()) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return;
+    }
+    journal_lines_ = by_seq_.size();
+    // 追加描述符仍指向被替换的旧文件，重新打开
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        openJournalLocked();
+    }
+}
+
+void SegmentManifest::storeLocked(const Segment& seg) {
+    dropLocked(seg.name);
+    by_name_[seg.name] = seg.seq;
+    by_seq_[seg.seq] = seg;
+    total_bytes_ += seg.bytes;
+    tier_bytes_[seg.tier] += seg.bytes;
+}
+
+void SegmentManifest::dropLocked(const std::string& name) {
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) return;
+    auto seg = by_seq_.find(it->second);
+    if (seg != by_seq_.end()) {
+        total_bytes_ -= seg->second.bytes;
+        tier_bytes_[seg->second.tier] -= seg->second.bytes;
+        by_seq_.erase(seg);
+    }
+    by_name_.erase(it);
+}
+
+void SegmentManifest::putLocked(const Segment& seg) {
+    storeLocked(seg);
+    appendLocked(putLine(seg));
+}
+
+// ============================================
+// 查询与修改
+// ============================================
+SegmentManifest::Segment SegmentManifest::begin(const std::string& name, const std::string& codec,
+                                                int64_t first_us) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Segment seg;
+    seg.name = name;
+    seg.seq = next_seq_++;
+    seg.first_us = seg.last_us = first_us;
+    seg.codec = codec;
+    seg.state = State::Active;
+    putLocked(seg);
+    return seg;
+}
+
+bool SegmentManifest::update(const std::string& name, const std::function<void(Segment&)>& fn) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) return false;
+    Segment seg = by_seq_[it->second];
+    fn(seg);
+    seg.name = name;
+    seg.seq = it->second;
+    putLocked(seg);
+    return true;
+}
+
+void SegmentManifest::erase(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!by_name_.count(name)) return;
+    dropLocked(name);
+    appendLocked(nlohmann::json{{"op", "del"}, {"name", name}}.dump() + "\n");
+}
+
+bool SegmentManifest::remove(const Segment& seg) {
+    const auto path = this->path(seg);
+    std::error_code ec;
+    bool removed = fs::remove(path, ec);
+    if (!removed && !ec && seg.codec.empty()) {
+        // 段目录落后于磁盘：段可能已被压缩
+        for (const auto& ext : compressedExtensions()) {
+            if (fs::remove(path.string() + ext, ec) || ec) break;
+        }
+    }
+    if (ec) {
+        std::cerr << "[SegmentManifest] Failed to remove " << path << ": " << ec.message() << "\n";
+        return false;
+    }
+    erase(seg.name);
+    return true;
+}
+
+void SegmentManifest::forget(const fs::path& file) {
+    auto name = file.filename().string();
+    if (isCompressedExtension(file.extension()) && !contains(name)) {
+        name = file.stem().string();
+    }
+    erase(name);
+}
+
+bool SegmentManifest::adopt(const fs::directory_entry& entry, uint32_t tier, fs::path* stale) {
+    {
+        // 已登记在本层的段不再 stat
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = by_name_.find(entry.path().filename().string());
+        if (it == by_name_.end()) it = by_name_.find(entry.path().stem().string());
+        if (it != by_name_.end() && (!stale || by_seq_.at(it->second).tier == tier)) return false;
+    }
+    Segment seg;
+    fs::file_time_type mtime;
+    if (!describeFile(entry, ext_, seg, mtime)) return false;
+    if (tier > 0) {
+        seg.tier = tier;
+        seg.location = entry.path().parent_path().string();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = by_name_.find(seg.name);
+    if (it == by_name_.end()) {
+        seg.seq = next_seq_++;
+        putLocked(seg);
+        return true;
+    }
+    const Segment known = by_seq_.at(it->second);
+    if (known.tier == tier || !stale) return false;
+    if (known.tier > tier) {
+        *stale = entry.path();
+        return false;
+    }
+    // 段已完整到达本层（临时文件 rename 之后才可见），只是日志没来得及记下
+    *stale = (known.location.empty() ? dir_ : fs::path(known.location)) / known.fileName();
+    seg.seq = known.seq;
+    seg.first_us = known.first_us;
+    seg.last_us = known.last_us;
+    seg.records = known.records;
+    putLocked(seg);
+    return true;
+}
+
+bool SegmentManifest::find(const std::string& name, Segment& out) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) return false;
+    out = by_seq_.at(it->second);
+    return true;
+}
+
+bool SegmentManifest::contains(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return by_name_.count(name) > 0;
+}
+
+bool SegmentManifest::latest(Segment& out) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (by_seq_.empty()) return false;
+    out = by_seq_.rbegin()->second;
+    return true;
+}
+
+std::vector<SegmentManifest::Segment> SegmentManifest::segments() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<Segment> out;
+    out.reserve(by_seq_.size());
+    for (const auto& kv : by_seq_) {
+        out.push_back(kv.second);
+    }
+    return out;
+}
+
+size_t SegmentManifest::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return by_seq_.size();
+}
+
+uint64_t SegmentManifest::totalBytes() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return total_bytes_;
+}
+
+uint64_t SegmentManifest::tierBytes(uint32_t tier) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = tier_bytes_.find(tier);
+    return it != tier_bytes_.end() ? it->second : 0;
+}
+
+fs::path SegmentManifest::path(const Segment& seg) const {
+    return (seg.location.empty() ? dir_ : fs::path(seg.location)) / seg.fileName();
+}
+
+std::vector<fs::path> SegmentManifest::paths() const {
+    std::vector<fs::path> out;
+    for (const auto& seg : segments()) {
+        out.push_back(path(seg));
+    }
+    return out;
+}
+
+std::vector<fs::path> SegmentManifest::timeline(const fs::path& dir) {
+    std::map<uint64_t, Segment> by_seq;
+    std::unordered_map<std::string, uint64_t> by_name;
+    std::ifstream in(dir / kJournalName);
+    std::string line;
+    while (std::getline(in, line)) {
+        Segment seg;
+        bool put = false;
+        if (!parseLine(line, put, seg)) continue;
+        auto old = by_name.find(seg.name);
+        if (old != by_name.end()) {
+            by_seq.erase(old->second);
+            by_name.erase(old);
+        }
+        if (!put) continue;
+        by_name[seg.name] = seg.seq;
+        by_seq[seg.seq] = std::move(seg);
+    }
+
+    std::vector<fs::path> out;
+    for (const auto& kv : by_seq) {
+        const auto& seg = kv.second;
+        out.push_back((seg.location.empty() ? dir : fs::path(seg.location)) / seg.fileName());
+    }
+    return out;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 一个模块目录的段目录（manifest）
+ *
+ * 内存中记录每个段的名称、序号、大小、时间范围、记录数、编解码器与状态，
+ * 轮转、保留数量、磁盘回收、续写与命名都只查询它，不再扫描目录或逐个 stat。
+ *
+ * 持久化为目录下的追加日志 .manifest，每行一个 JSON 对象：
+ *   {"op":"put", 段的完整字段}   新增或更新（按 name 覆盖）
+ *   {"op":"del","name":...}      删除
+ * 日志行数远多于存活段数时整体重写为快照（临时文件 + rename）。
+ * 日志只追加不逐条落盘：进程崩溃不丢记录，整机掉电丢失的尾部由启动时的核对修正
+ * （写入中的段重新 stat，已不存在的未压缩段改认其压缩产物）。
+ * 日志缺失时才冷扫描一次目录重建；启动时清理临时文件的那次目录遍历顺带 adopt 未登记的段。
+ * 分层存储时日志只在热层目录，冷层中的段记下所在层与目录，读者按序号得到跨层的时间线。
+ * 线程安全：压缩完成回调在线程池线程上更新。
+ */
+class SegmentManifest {
+public:
+    enum class State { Active, Sealed, Compressed };
+
+    struct Segment {
+        std::string name;       // 未压缩时的文件名（不含压缩扩展名）
+        uint64_t seq = 0;       // 创建顺序，单调递增
+        uint64_t bytes = 0;     // 磁盘上的大小（压缩后为压缩文件大小）
+        int64_t first_us = 0;   // 段的创建与最后写入时间（系统时间，微秒）
+        int64_t last_us = 0;
+        uint64_t records = 0;
+        std::string codec;      // 压缩扩展名（.gz / .zst / .lz4），未压缩为空
+        State state = State::Active;
+        uint32_t tier = 0;      // 存储层：0 为热层（段目录所在目录），1.. 为冷层
+        std::string location;   // 冷层中段所在的目录；热层为空
+
+        std::string fileName() const { return name + codec; }
+    };
+
+    static constexpr const char* kJournalName = ".manifest";
+
+    // 读取 dir 下的日志；没有日志时扫描 dir 中扩展名为 ext 的段（及其压缩产物）重建
+    SegmentManifest(std::filesystem::path dir, std::string ext);
+    ~SegmentManifest();
+
+    SegmentManifest(const SegmentManifest&) = delete;
+    SegmentManifest& operator=(const SegmentManifest&) = delete;
+
+    // 登记一个新建的写入中段（同名旧记录被替换），分配下一个序号
+    Segment begin(const std::string& name, const std::string& codec, int64_t first_us);
+    // 修改已登记的段；段不存在（已被删除）时返回 false，不会重新登记
+    bool update(const std::string& name, const std::function<void(Segment&)>& fn);
+    void erase(const std::string& name);
+    // 删除段文件（段目录落后于磁盘时连同压缩产物）并移出目录；删除失败时保留记录
+    bool remove(const Segment& seg);
+    // 按磁盘文件名删除记录（文件名可带压缩扩展名）
+    void forget(const std::filesystem::path& file);
+    // 登记 tier 层目录中存在但未登记的段文件（外来文件，或掉电丢失的日志尾部）；
+    // 不是段文件或已登记时返回 false。
+    // 已登记在其他层的段（迁移中途退出）：记录在较低层时改记到本层，stale 返回旧位置；
+    // 记录在较高层时 stale 返回本文件。两种情况都由调用方删除 stale
+    bool adopt(const std::filesystem::directory_entry& entry, uint32_t tier = 0,
+               std::filesystem::path* stale = nullptr);
+
+    bool find(const std::string& name, Segment& out) const;
+    bool contains(const std::string& name) const;
+    // 序号最大的段
+    bool latest(Segment& out) const;
+    // 按序号从旧到新
+    std::vector<Segment> segments() const;
+    size_t size() const;
+    // 所有段在磁盘上的总字节（增量维护，不 stat）
+    uint64_t totalBytes() const;
+    uint64_t tierBytes(uint32_t tier) const;
+    // 写入中段的内存字节数（段封口前目录里记为 0），由写入方在写路径上无锁更新
+    void setActiveBytes(uint64_t bytes) { active_bytes_.store(bytes, std::memory_order_relaxed); }
+    uint64_t activeBytes() const { return active_bytes_.load(std::memory_order_relaxed); }
+    // 热层实际占用：已登记的热层段 + 写入中段
+    uint64_t hotBytes() const { return tierBytes(0) + activeBytes(); }
+    // 段文件的完整路径（按所在层）
+    std::filesystem::path path(const Segment& seg) const;
+    // 跨层的逻辑时间线：所有段文件按序号从旧到新
+    std::vector<std::filesystem::path> paths() const;
+    // 只读地重放 dir 下的日志得到时间线（供离线读取工具，不打开追加、不重写）
+    static std::vector<std::filesystem::path> timeline(const std::filesystem::path& dir);
+
+    const std::filesystem::path& dir() const { return dir_; }
+    // 本次是否由冷扫描重建
+    bool rebuilt() const { return rebuilt_; }
+
+private:
+    bool loadLocked();
+    void rebuildLocked();
+    void reconcileLocked();
+    void openJournalLocked();
+    // 只改内存索引与总字节
+    void storeLocked(const Segment& seg);
+    void dropLocked(const std::string& name);
+    // 改索引并追加日志
+    void putLocked(const Segment& seg);
+    void appendLocked(const std::string& line);
+    void compactLocked();
+
+    std::filesystem::path dir_;
+    std::string ext_;
+
+    mutable std::mutex mtx_;
+    std::map<uint64_t, Segment> by_seq_;
+    std::unordered_map<std::string, uint64_t> by_name_;
+    uint64_t next_seq_ = 1;
+    uint64_t total_bytes_ = 0;
+    std::map<uint32_t, uint64_t> tier_bytes_;
+    std::atomic<uint64_t> active_bytes_{0};
+    size_t journal_lines_ = 0;
+    int fd_ = -1;
+    bool rebuilt_ = false;
+};
@@ -0,0 +1,380 @@
+#include "SegmentWriter.h"
+#include "UringSegmentWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================
+// StreamSegmentWriter
+// ============================================
+bool StreamSegmentWriter::open(const std::filesystem::path& path) {
+    path_ = path;
+    // pubsetbuf 只在打开文件前生效
+    if (!io_buf_.empty()) {
+        ofs_.rdbuf()->pubsetbuf(io_buf_.data(), static_cast<std::streamsize>(io_buf_.size()));
+    }
+    ofs_.clear();
+    ofs_.open(path_, std::ios::out | std::ios::app);
+    return ofs_.is_open();
+}
+
+void StreamSegmentWriter::close() {
+    if (ofs_.is_open()) {
+        ofs_.flush();
+        ofs_.close();
+    }
+}
+
+bool StreamSegmentWriter::write(GatherBuffer& buf, bool flush_now) {
+    for (const auto& v : buf.iov()) {
+        ofs_.write(static_cast<const char*>(v.iov_base), static_cast<std::streamsize>(v.iov_len));
+    }
+    if (flush_now) {
+        ofs_.flush();
+    }
+    return ofs_.good();
+}
+
+bool StreamSegmentWriter::write(const char* data, size_t n) {
+    ofs_.write(data, static_cast<std::streamsize>(n));
+    return ofs_.good();
+}
+
+bool StreamSegmentWriter::flush() {
+    if (ofs_.is_open()) {
+        ofs_.flush();
+    }
+    return ofs_.good();
+}
+
+void StreamSegmentWriter::setBufferSize(size_t bytes) {
+    if (bytes == io_buf_.size()) return;
+
+    bool reopen = ofs_.is_open();
+    close();
+    io_buf_.assign(bytes, '\0');
+    if (reopen) {
+        open(path_);
+    }
+}
+
+// ============================================
+// FdSegmentWriter
+// ============================================
+namespace {
+size_t pageSize() {
+    static const size_t kPage = [] {
+        long n = ::sysconf(_SC_PAGESIZE);
+        return n > 0 ? static_cast<size_t>(n) : size_t(4096);
+    }();
+    return kPage;
+}
+}  // namespace
+
+FdSegmentWriter::FdSegmentWriter() {
+    allocStaging(64 * 1024);
+}
+
+FdSegmentWriter::~FdSegmentWriter() {
+    close();
+    std::free(staging_);
+}
+
+void FdSegmentWriter::allocStaging(size_t bytes) {
+    size_t page = pageSize();
+    size_t cap = std::max(page, (bytes + page - 1) / page * page);
+    void* p = nullptr;
+    if (::posix_memalign(&p, page, cap) != 0) {
+        std::cerr << "[FdSegmentWriter] Failed to allocate staging buffer\n";
+        return;  // 保留原暂存区
+    }
+    std::free(staging_);
+    staging_ = static_cast<char*>(p);
+    capacity_ = cap;
+    used_ = 0;
+}
+
+bool FdSegmentWriter::open(const std::filesystem::path& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    failed_ = fd_ < 0;
+    used_ = 0;
+    if (fd_ < 0) {
+        std::cerr << "[FdSegmentWriter] Failed to open " << path << ": "
+                  << std::strerror(errno) << "\n";
+    }
+    return fd_ >= 0;
+}
+
+void FdSegmentWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool FdSegmentWriter::write(GatherBuffer& buf, bool flush_now) {
+    if (!good()) return false;
+
+    if (!flush_now && used_ + buf.size() <= capacity_) {
+        for (const auto& v : buf.iov()) {
+            std::memcpy(staging_ + used_, v.iov_base, v.iov_len);
+            used_ += v.iov_len;
+        }
+        return true;
+    }
+
+    // 暂存区余量 + 本批片段合成一次 writev
+    const auto& iov = buf.iov();
+    if (!writeOut(iov.data(), iov.size())) return false;
+    if (flush_now && durable_) {
+        ::fdatasync(fd_);
+    }
+    return true;
+}
+
+bool FdSegmentWriter::write(const char* data, size_t n) {
+    if (!good()) return false;
+
+    if (used_ + n <= capacity_) {
+        std::memcpy(staging_ + used_, data, n);
+        used_ += n;
+        return true;
+    }
+    iovec v{const_cast<char*>(data), n};
+    return writeOut(&v, 1);
+}
+
+bool FdSegmentWriter::flush() {
+    if (!good()) return false;
+    if (used_ > 0 && !writeOut(nullptr, 0)) return false;
+    if (durable_) {
+        ::fdatasync(fd_);
+    }
+    return true;
+}
+
+void FdSegmentWriter::setBufferSize(size_t bytes) {
+    size_t page = pageSize();
+    if (std::max(page, (bytes + page - 1) / page * page) == capacity_) return;
+    if (used_ > 0) flush();
+    allocStaging(bytes);
+}
+
+bool FdSegmentWriter::writeOut(const iovec* extra, size_t extra_count) {
+    iov_.clear();
+    if (used_ > 0) {
+        iov_.push_back(iovec{staging_, used_});
+    }
+    iov_.insert(iov_.end(), extra, extra + extra_count);
+
+    size_t first = 0;
+    while (first < iov_.size()) {
+        int n = static_cast<int>(std::min<size_t>(iov_.size() - first, IOV_MAX));
+        ssize_t written = ::writev(fd_, iov_.data() + first, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[FdSegmentWriter] writev failed: " << std::strerror(errno) << "\n";
+            failed_ = true;
+            used_ = 0;
+            return false;
+        }
+
+        // 部分写：跳过已写完的 iovec，调整下一条的起点
+        size_t left = static_cast<size_t>(written);
+        while (first < iov_.size() && left >= iov_[first].iov_len) {
+            left -= iov_[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            iov_[first].iov_base = static_cast<char*>(iov_[first].iov_base) + left;
+            iov_[first].iov_len -= left;
+        }
+    }
+    used_ = 0;
+    return true;
+}
+
+// ============================================
+// DirectSegmentWriter
+// ============================================
+DirectSegmentWriter::DirectSegmentWriter() {
+    allocStaging(kDefaultBufferBytes);
+}
+
+DirectSegmentWriter::~DirectSegmentWriter() {
+    close();
+    std::free(staging_);
+}
+
+void DirectSegmentWriter::allocStaging(size_t bytes) {
+    // 至少两块：flush 后留下的尾块之外还要能继续追加
+    size_t cap = std::max(kBlock * 2, (bytes + kBlock - 1) / kBlock * kBlock);
+    void* p = nullptr;
+    if (::posix_memalign(&p, kBlock, cap) != 0) {
+        std::cerr << "[DirectSegmentWriter] Failed to allocate staging buffer\n";
+        return;
+    }
+    if (used_ > 0) {
+        std::memcpy(p, staging_, used_);  // 调用方保证尾部放得下
+    }
+    std::free(staging_);
+    staging_ = static_cast<char*>(p);
+    capacity_ = cap;
+}
+
+bool DirectSegmentWriter::open(const std::filesystem::path& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+    if (fd_ < 0 && errno == EINVAL) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            std::cerr << "[DirectSegmentWriter] O_DIRECT unsupported on " << path.parent_path()
+                      << ", using buffered writes\n";
+        }
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+    failed_ = fd_ < 0;
+    used_ = 0;
+    block_offset_ = 0;
+    if (fd_ < 0) {
+        std::cerr << "[DirectSegmentWriter] Failed to open " << path << ": "
+                  << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // 续写已有文件：末尾不满一块的部分读回暂存区，下次写出时整块重写
+    struct stat st{};
+    if (::fstat(fd_, &st) == 0 && st.st_size > 0) {
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        block_offset_ = size / kBlock * kBlock;
+        size_t tail = static_cast<size_t>(size - block_offset_);
+        if (tail > 0 &&
+            ::pread(fd_, staging_, kBlock, static_cast<off_t>(block_offset_)) <
+                static_cast<ssize_t>(tail)) {
+            std::cerr << "[DirectSegmentWriter] Failed to read tail block of " << path << ": "
+                      << std::strerror(errno) << "\n";
+            failed_ = true;
+            return false;
+        }
+        used_ = tail;
+    }
+    return true;
+}
+
+void DirectSegmentWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+    used_ = 0;
+}
+
+bool DirectSegmentWriter::write(GatherBuffer& buf, bool flush_now) {
+    if (!good()) return false;
+    for (const auto& v : buf.iov()) {
+        if (!copyIn(static_cast<const char*>(v.iov_base), v.iov_len)) return false;
+    }
+    return flush_now && durable_ ? flush() : true;
+}
+
+bool DirectSegmentWriter::write(const char* data, size_t n) {
+    if (!good()) return false;
+    return copyIn(data, n);
+}
+
+bool DirectSegmentWriter::copyIn(const char* data, size_t n) {
+    while (n > 0) {
+        size_t take = std::min(n, capacity_ - used_);
+        std::memcpy(staging_ + used_, data, take);
+        used_ += take;
+        data += take;
+        n -= take;
+        if (used_ == capacity_) {
+            if (!writeBlocks(capacity_)) return false;
+            block_offset_ += capacity_;
+            used_ = 0;
+        }
+    }
+    return true;
+}
+
+bool DirectSegmentWriter::flush() {
+    if (!good()) return false;
+    if (used_ > 0) {
+        size_t whole = used_ / kBlock * kBlock;
+        size_t tail = used_ - whole;
+        size_t padded = whole + (tail > 0 ? kBlock : 0);
+        std::memset(staging_ + used_, 0, padded - used_);
+        if (!writeBlocks(padded)) return false;
+        // 补零的尾块截回逻辑长度
+        if (tail > 0 && ::ftruncate(fd_, static_cast<off_t>(block_offset_ + used_)) != 0) {
+            std::cerr << "[DirectSegmentWriter] ftruncate failed: " << std::strerror(errno) << "\n";
+            failed_ = true;
+            return false;
+        }
+        // 尾块留在暂存区，后续追加时整块重写
+        if (whole > 0) {
+            std::memmove(staging_, staging_ + whole, tail);
+            block_offset_ += whole;
+            used_ = tail;
+        }
+    }
+    if (durable_) {
+        ::fdatasync(fd_);
+    }
+    return true;
+}
+
+bool DirectSegmentWriter::writeBlocks(size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t written = ::pwrite(fd_, staging_ + done, n - done,
+                                   static_cast<off_t>(block_offset_ + done));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[DirectSegmentWriter] pwrite failed: " << std::strerror(errno) << "\n";
+            failed_ = true;
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void DirectSegmentWriter::setBufferSize(size_t bytes) {
+    size_t cap = std::max(kBlock * 2, (bytes + kBlock - 1) / kBlock * kBlock);
+    if (cap == capacity_) return;
+    // 先写出整块，只剩不足一块的尾部需要搬到新缓冲
+    if (fd_ >= 0 && used_ > 0 && !flush()) return;
+    allocStaging(bytes);
+}
+
+std::unique_ptr<ISegmentWriter> makeSegmentWriter(IoBackend backend) {
+    if (backend == IoBackend::Uring) {
+        auto uring = std::make_unique<UringSegmentWriter>();
+        if (uring->ok()) {
+            return uring;
+        }
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            std::cerr << "[SegmentWriter] io_uring unavailable, falling back to fd backend\n";
+        }
+        backend = IoBackend::Fd;
+    }
+    if (backend == IoBackend::Direct) {
+        return std::make_unique<DirectSegmentWriter>();
+    }
+    // 映射段由支持它的 Sink 自行管理，其余 Sink 按 fd 后端写出
+    if (backend == IoBackend::Fd || backend == IoBackend::Mmap) {
+        return std::make_unique<FdSegmentWriter>();
+    }
+    return std::make_unique<StreamSegmentWriter>();
+}
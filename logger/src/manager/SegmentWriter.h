@@ -0,0 +1,237 @@
+#pragma once
+#include "../../include/logger/LoggerConfig.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
+
+/**
+ * @brief 一次写出的聚集缓冲
+ *
+ * 定长记录头与小片段拷贝进连续暂存区；大片段只记录指针，
+ * 写出时以 iovec 直接引用（不拷贝），被引用的内存须在写出前保持有效。
+ */
+class GatherBuffer {
+public:
+    // 不超过该长度的片段直接拷贝，避免 iovec 数量膨胀
+    static constexpr size_t kCopyThreshold = 512;
+
+    struct Mark {
+        size_t pieces;
+        size_t last_len;
+        size_t staged;
+        size_t total;
+    };
+
+    void clear() {
+        staged_.clear();
+        pieces_.clear();
+        total_ = 0;
+    }
+
+    size_t size() const { return total_; }
+    bool empty() const { return total_ == 0; }
+
+    // 打包的定长头整体拷贝
+    template <typename T>
+    void appendPod(const T& value) {
+        appendCopy(&value, sizeof(value));
+    }
+
+    void push_back(char c) { appendCopy(&c, 1); }
+
+    void append(const void* data, size_t n) {
+        if (n <= kCopyThreshold) {
+            appendCopy(data, n);
+        } else {
+            pieces_.push_back(Piece{static_cast<const char*>(data), 0, n});
+            total_ += n;
+        }
+    }
+
+    void appendCopy(const void* data, size_t n) {
+        if (n == 0) return;
+        size_t offset = staged_.size();
+        staged_.insert(staged_.end(), static_cast<const char*>(data),
+                       static_cast<const char*>(data) + n);
+        // 与上一个暂存片段相邻时直接延长，保持 iovec 最少
+        if (!pieces_.empty() && !pieces_.back().ref &&
+            pieces_.back().offset + pieces_.back().len == offset) {
+            pieces_.back().len += n;
+        } else {
+            pieces_.push_back(Piece{nullptr, offset, n});
+        }
+        total_ += n;
+    }
+
+    // 回退到某个位置（批量写入在段边界处撤销最后一条记录）
+    Mark mark() const {
+        return Mark{pieces_.size(), pieces_.empty() ? 0 : pieces_.back().len,
+                    staged_.size(), total_};
+    }
+
+    void truncate(const Mark& m) {
+        pieces_.resize(m.pieces);
+        if (!pieces_.empty()) pieces_.back().len = m.last_len;
+        staged_.resize(m.staged);
+        total_ = m.total;
+    }
+
+    // 生成 iovec；暂存区可能扩容，只在写出前调用
+    const std::vector<iovec>& iov() {
+        iov_.clear();
+        for (const auto& p : pieces_) {
+            const char* base = p.ref ? p.ref : staged_.data() + p.offset;
+            iov_.push_back(iovec{const_cast<char*>(base), p.len});
+        }
+        return iov_;
+    }
+
+private:
+    struct Piece {
+        const char* ref;   // 为空表示位于暂存区 offset 处
+        size_t offset;
+        size_t len;
+    };
+
+    std::vector<char> staged_;
+    std::vector<Piece> pieces_;
+    std::vector<iovec> iov_;
+    size_t total_ = 0;
+};
+
+/**
+ * @brief 段文件写出后端（多态扩展点）
+ *
+ * write 只保证数据进入后端缓冲；flush_now 或 flush() 才交给内核。
+ */
+class ISegmentWriter {
+public:
+    virtual ~ISegmentWriter() = default;
+
+    virtual bool open(const std::filesystem::path& path) = 0;
+    // 写出全部数据后关闭
+    virtual void close() = 0;
+    // 轮转用：允许数据在关闭后继续异步落盘（默认同 close）
+    virtual void closeAsync() { close(); }
+    virtual bool isOpen() const = 0;
+    virtual bool good() const = 0;
+
+    virtual bool write(GatherBuffer& buf, bool flush_now) = 0;
+    virtual bool write(const char* data, size_t n) = 0;
+    virtual bool flush() = 0;
+
+    // 用户态缓冲大小；已打开的段会以新缓冲继续追加
+    virtual void setBufferSize(size_t bytes) = 0;
+    // 刷新时是否 fdatasync（流后端拿不到 fd，忽略）
+    virtual void setDurable(bool) {}
+};
+
+// std::ofstream 后端（默认）
+class StreamSegmentWriter : public ISegmentWriter {
+public:
+    bool open(const std::filesystem::path& path) override;
+    void close() override;
+    bool isOpen() const override { return ofs_.is_open(); }
+    bool good() const override { return ofs_.good(); }
+
+    bool write(GatherBuffer& buf, bool flush_now) override;
+    bool write(const char* data, size_t n) override;
+    bool flush() override;
+    void setBufferSize(size_t bytes) override;
+
+private:
+    std::filesystem::path path_;
+    std::ofstream ofs_;
+    std::vector<char> io_buf_;   // 为空时用标准库默认缓冲
+};
+
+/**
+ * @brief 裸 fd 后端：O_APPEND 打开，页对齐暂存区，一次 writev 写出
+ *
+ * 小批次先拷进暂存区；需要写出时把暂存区与本批的各片段（记录头、大负载）
+ * 合成一个 writev，绕过 iostream 的 sentry/locale 开销。
+ */
+class FdSegmentWriter : public ISegmentWriter {
+public:
+    FdSegmentWriter();
+    ~FdSegmentWriter() override;
+
+    FdSegmentWriter(const FdSegmentWriter&) = delete;
+    FdSegmentWriter& operator=(const FdSegmentWriter&) = delete;
+
+    bool open(const std::filesystem::path& path) override;
+    void close() override;
+    bool isOpen() const override { return fd_ >= 0; }
+    bool good() const override { return fd_ >= 0 && !failed_; }
+
+    bool write(GatherBuffer& buf, bool flush_now) override;
+    bool write(const char* data, size_t n) override;
+    bool flush() override;
+    void setBufferSize(size_t bytes) override;
+    void setDurable(bool durable) override { durable_ = durable; }
+
+private:
+    // 写出暂存区 + extra，处理部分写与 IOV_MAX
+    bool writeOut(const iovec* extra, size_t extra_count);
+    void allocStaging(size_t bytes);
+
+    int fd_ = -1;
+    bool failed_ = false;
+    bool durable_ = false;
+    char* staging_ = nullptr;    // 页对齐
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    std::vector<iovec> iov_;
+};
+
+/**
+ * @brief O_DIRECT 后端：绕过页缓存，以 4 KiB 对齐的整块写出
+ *
+ * 记录拷进页对齐暂存区，写满后按对齐偏移 pwrite 整个缓冲。末尾不足一块的数据
+ * 留在暂存区：flush/close 时补零写出整块再把文件截回逻辑长度，之后的写入会重写该块。
+ * 逐批的刷新请求只在持久化模式下生效，避免每批都触发一次同步设备写。
+ * 文件系统不支持 O_DIRECT 时退回普通缓冲写（逻辑不变）。
+ */
+class DirectSegmentWriter : public ISegmentWriter {
+public:
+    static constexpr size_t kBlock = 4096;
+    static constexpr size_t kDefaultBufferBytes = 1024 * 1024;
+
+    DirectSegmentWriter();
+    ~DirectSegmentWriter() override;
+
+    DirectSegmentWriter(const DirectSegmentWriter&) = delete;
+    DirectSegmentWriter& operator=(const DirectSegmentWriter&) = delete;
+
+    bool open(const std::filesystem::path& path) override;
+    void close() override;
+    bool isOpen() const override { return fd_ >= 0; }
+    bool good() const override { return fd_ >= 0 && !failed_; }
+
+    bool write(GatherBuffer& buf, bool flush_now) override;
+    bool write(const char* data, size_t n) override;
+    bool flush() override;
+    void setBufferSize(size_t bytes) override;
+    void setDurable(bool durable) override { durable_ = durable; }
+
+private:
+    bool copyIn(const char* data, size_t n);
+    // 在 block_offset_ 处写出暂存区前 n 字节（n 为整块倍数）
+    bool writeBlocks(size_t n);
+    void allocStaging(size_t bytes);
+
+    int fd_ = -1;
+    bool failed_ = false;
+    bool durable_ = false;
+    char* staging_ = nullptr;    // 按块对齐
+    size_t capacity_ = 0;        // 整块倍数
+    size_t used_ = 0;
+    uint64_t block_offset_ = 0;  // 暂存区起点对应的文件偏移（块对齐）
+};
+
+// Uring 不可用时自动退回 Fd；Mmap 在此按 Fd 处理（映射段见 MappedSegment）
+std::unique_ptr<ISegmentWriter> makeSegmentWriter(IoBackend backend);
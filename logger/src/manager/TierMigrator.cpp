@@ -0,0 +1,299 @@
+#include "TierMigrator.h"
+#include "CompressionPool.h"
+#include "CompressionStrategies.h"
+#include "DiskQuotaManager.h"
+#include "SegmentManifest.h"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr size_t kChunkBytes = 1 << 20;   // 每次复制并记账的块大小
+constexpr int kNice = 10;
+// ioprio_set(2)：glibc 没有封装
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassIdle = 3;
+constexpr int kIoprioClassShift = 13;
+
+bool sameFileSystem(const fs::path& file, const fs::path& dir) {
+    struct stat a{}, b{};
+    return ::stat(file.c_str(), &a) == 0 && ::stat(dir.c_str(), &b) == 0 && a.st_dev == b.st_dev;
+}
+}  // namespace
+
+TierMigrator& TierMigrator::instance() {
+    static TierMigrator inst;
+    return inst;
+}
+
+TierMigrator::~TierMigrator() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    idle_cv_.notify_all();
+}
+
+void TierMigrator::setRate(uint64_t bytes_per_sec) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    rate_ = bytes_per_sec;
+    debt_ = 0;
+    refilled_at_ = std::chrono::steady_clock::now();
+}
+
+uint64_t TierMigrator::rate() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return rate_;
+}
+
+void TierMigrator::submit(std::shared_ptr<SegmentManifest> manifest, const std::string& name,
+                          std::vector<Tier> tiers) {
+    if (!manifest || tiers.empty()) return;
+    auto key = (manifest->dir() / name).lexically_normal();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stop_ || !in_flight_.insert(key).second) {
+            return;
+        }
+        queue_.push_back(Job{key, std::move(manifest), name, std::move(tiers)});
+        if (!worker_.joinable()) {
+            worker_ = std::thread(&TierMigrator::run, this);
+        }
+    }
+    cv_.notify_one();
+}
+
+bool TierMigrator::inFlight(const fs::path& path) const {
+    auto key = path.lexically_normal();
+    // 压缩前后的文件名都对应同一个段
+    std::lock_guard<std::mutex> lock(mtx_);
+    return in_flight_.count(key) > 0 ||
+           (isCompressedExtension(key.extension()) &&
+            in_flight_.count(key.parent_path() / key.stem()) > 0);
+}
+
+size_t TierMigrator::pending() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return in_flight_.size();
+}
+
+void TierMigrator::waitIdle() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this] { return in_flight_.empty() || !worker_.joinable(); });
+}
+
+// ============================================
+// 工作线程
+// ============================================
+void TierMigrator::run() {
+    // nice 与 I/O 优先级都按线程生效：idle 类只在磁盘没有其他请求时才得到服务
+    const auto tid = static_cast<int>(::syscall(SYS_gettid));
+    if (::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), kNice) != 0 ||
+        ::syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, kIoprioClassIdle << kIoprioClassShift) != 0) {
+        std::cerr << "[TierMigrator] Failed to lower thread priority\n";
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_) break;
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        SegmentManifest::Segment seg;
+        if (job.manifest->find(job.name, seg) && seg.tier < job.tiers.size()) {
+            migrate(job, seg.tier + 1);
+        }
+
+        lock.lock();
+        in_flight_.erase(job.key);
+        if (in_flight_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+bool TierMigrator::migrate(const Job& job, uint32_t to_tier) {
+    SegmentManifest::Segment seg;
+    if (to_tier == 0 || to_tier > job.tiers.size() || !job.manifest->find(job.name, seg) ||
+        seg.tier >= to_tier || seg.state == SegmentManifest::State::Active) {
+        return false;
+    }
+    const auto& tier = job.tiers[to_tier - 1];
+    const auto src = job.manifest->path(seg);
+    const auto dst = tier.dir / seg.fileName();
+    // 正在被重新压缩（原地覆盖）的段留在原层，下次轮转时重新提交
+    if (CompressionPool::instance().inFlight(src)) return false;
+    std::error_code ec;
+    fs::create_directories(tier.dir, ec);
+
+    if (!makeRoom(job, to_tier, seg.bytes)) return false;   // 目标文件系统腾不出空间，留在原层
+
+    // 字典压缩的段：字典先于段到达目标层（目标层的字典不随热层修剪）
+    if (seg.codec == ".zst") {
+        if (uint32_t id = zstdDictionaryId(src)) {
+            const auto dict_dst = zstdDictionaryPath(dst, id);
+            if (!fs::exists(dict_dst, ec)) {
+                fs::create_directories(dict_dst.parent_path(), ec);
+                if (!copyFile(zstdDictionaryPath(src, id), dict_dst)) return false;
+            }
+        }
+    }
+
+    if (!moveFile(src, dst)) return false;
+    const auto location = tier.dir.string();
+    bool recorded = job.manifest->update(job.name, [&](SegmentManifest::Segment& s) {
+        s.tier = to_tier;
+        s.location = location;
+    });
+    // 迁移期间段被保留规则删除：丢弃副本；否则删除源文件（rename 时已不存在）
+    fs::remove(recorded ? src : dst, ec);
+    if (!recorded) {
+        fs::remove(src, ec);
+    }
+    return recorded;
+}
+
+bool TierMigrator::makeRoom(const Job& job, uint32_t tier, uint64_t need) {
+    const auto& t = job.tiers[tier - 1];
+    const uint64_t reserve = DiskQuotaManager::instance().freeSpacePolicy().hard_min_free_bytes;
+    auto short_of_space = [&] {
+        std::error_code ec;
+        auto space = fs::space(t.dir, ec);
+        return !ec && space.available < need + reserve;
+    };
+
+    while ((t.max_bytes > 0 && job.manifest->tierBytes(tier) + need > t.max_bytes) || short_of_space()) {
+        // 本层最旧的段：有下一层就继续下沉，否则删除
+        SegmentManifest::Segment oldest;
+        bool found = false;
+        for (const auto& seg : job.manifest->segments()) {
+            if (seg.tier == tier && seg.state != SegmentManifest::State::Active) {
+                oldest = seg;
+                found = true;
+                break;
+            }
+        }
+        if (!found) break;
+
+        bool freed;
+        if (tier < job.tiers.size()) {
+            Job next = job;
+            next.name = oldest.name;
+            freed = migrate(next, tier + 1);
+        } else {
+            freed = job.manifest->remove(oldest);
+        }
+        if (!freed) break;
+    }
+    return !short_of_space();
+}
+
+bool TierMigrator::moveFile(const fs::path& src, const fs::path& dst) {
+    if (sameFileSystem(src, dst.parent_path())) {
+        std::error_code ec;
+        fs::rename(src, dst, ec);
+        if (ec) {
+            std::cerr << "[TierMigrator] Failed to move " << src << ": " << ec.message() << "\n";
+        }
+        return !ec;
+    }
+    return copyFile(src, dst);
+}
+
+bool TierMigrator::copyFile(const fs::path& src, const fs::path& dst) {
+    auto tmp = dst;
+    tmp += ".migrating";
+    int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+    int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    // copy_file_range 不经过用户态；跨文件系统类型不支持时退回 read/write（两者共用文件偏移）
+    bool ok = true, fallback = false;
+    std::vector<char> buf;
+    off_t done = 0;
+    while (true) {
+        ssize_t n;
+        if (!fallback) {
+            n = ::copy_file_range(in, nullptr, out, nullptr, kChunkBytes, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                fallback = true;
+                buf.resize(kChunkBytes);
+                continue;
+            }
+        } else {
+            n = ::read(in, buf.data(), buf.size());
+            for (ssize_t w = 0; n > 0 && w < n;) {
+                ssize_t m = ::write(out, buf.data() + w, static_cast<size_t>(n - w));
+                if (m < 0 && errno == EINTR) continue;
+                if (m <= 0) {
+                    n = -1;
+                    break;
+                }
+                w += m;
+            }
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        // 读过的源页不再需要，别挤占实时写入的页缓存
+        ::posix_fadvise(in, done, n, POSIX_FADV_DONTNEED);
+        done += n;
+        if (!throttle(static_cast<uint64_t>(n))) {
+            ok = false;
+            break;
+        }
+    }
+    ok = ok && ::fdatasync(out) == 0;
+    if (ok) {
+        ::posix_fadvise(out, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    ::close(in);
+    ::close(out);
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmp, dst, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "[TierMigrator] Failed to copy " << src << " to " << dst.parent_path() << "\n";
+        fs::remove(tmp, ec);
+    }
+    return ok;
+}
+
+bool TierMigrator::throttle(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (stop_) return false;
+    if (rate_ == 0) return true;
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - refilled_at_;
+    refilled_at_ = now;
+    // 额度最多攒 1 秒
+    debt_ = std::max(-1.0, debt_ - elapsed.count()) + static_cast<double>(bytes) / static_cast<double>(rate_);
+    if (debt_ > 0) {
+        cv_.wait_for(lock, std::chrono::duration<double>(debt_), [this] { return stop_; });
+    }
+    // 进程退出时放弃复制，段留在原层
+    return !stop_;
+}
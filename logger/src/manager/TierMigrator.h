@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SegmentManifest;
+
+/**
+ * @brief 进程级分层存储迁移线程：把已封口的段从热层移到冷层
+ *
+ * 目标层与源段在同一文件系统时直接 rename；否则以 copy_file_range 分块复制到临时文件，
+ * 落盘后 rename 到位，段目录改记新位置后再删除源文件（任一步中断都不会丢段，
+ * 残留副本由下次启动时的目录遍历清理）。
+ *
+ * 迁移不与实时写入争抢：线程以最低的 I/O 优先级（idle 类）和较高的 nice 值运行，
+ * 复制按令牌桶限速，复制过的页立即移出页缓存。
+ *
+ * 每层可设字节上限：段迁入后本层超限时，最旧的段继续移往下一层，最后一层直接删除。
+ * 目标文件系统可用空间不足时先按同样规则腾出空间，仍不足则段留在原层，下次再试。
+ * 进程退出时只等待正在迁移的段，排队的段留在原层，由下次启动的 RollingFileManager 重新提交。
+ */
+class TierMigrator {
+public:
+    // 一个冷层：目录已解析到 <冷层根>/<module>/<进程名>
+    struct Tier {
+        std::filesystem::path dir;
+        uint64_t max_bytes = 0;   // 0 为不限
+    };
+
+    static TierMigrator& instance();
+
+    // 复制限速（字节/秒），0 为不限；同文件系统的 rename 不受限
+    void setRate(uint64_t bytes_per_sec);
+    uint64_t rate() const;
+
+    // 把段移到下一层（tiers[i] 为第 i + 1 层）；同一段已在队列中时忽略
+    void submit(std::shared_ptr<SegmentManifest> manifest, const std::string& name,
+                std::vector<Tier> tiers);
+
+    // 段是否排队或正在迁移；path 为段在热层的路径（段目录所在目录 / 文件名）
+    bool inFlight(const std::filesystem::path& path) const;
+    size_t pending() const;
+    // 等待队列清空且没有正在迁移的段
+    void waitIdle();
+
+    ~TierMigrator();
+
+private:
+    struct Job {
+        std::filesystem::path key;
+        std::shared_ptr<SegmentManifest> manifest;
+        std::string name;
+        std::vector<Tier> tiers;
+    };
+
+    TierMigrator() = default;
+    void run();
+    // 把段从当前层移到 to_tier 层；移动前先按目标层的上限与余量腾出空间
+    bool migrate(const Job& job, uint32_t to_tier);
+    // 本层超出上限或目标文件系统余量不足 need 字节时，把最旧的段移往下一层或删除；
+    // 返回目标文件系统是否放得下
+    bool makeRoom(const Job& job, uint32_t tier, uint64_t need);
+    bool moveFile(const std::filesystem::path& src, const std::filesystem::path& dst);
+    bool copyFile(const std::filesystem::path& src, const std::filesystem::path& dst);
+    // 按限速等待已复制的字节；进程退出时返回 false（放弃本次复制）
+    bool throttle(uint64_t bytes);
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+    std::deque<Job> queue_;
+    std::set<std::filesystem::path> in_flight_;   // 排队中 + 正在迁移
+    std::thread worker_;
+    bool stop_ = false;
+    uint64_t rate_ = 0;
+    double debt_ = 0;   // 超出限速的秒数（负数为攒下的额度）
+    std::chrono::steady_clock::time_point refilled_at_ = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,446 @@
+#include "UringSegmentWriter.h"
+
+#ifdef LOGGER_HAVE_IO_URING
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+// fdatasync 请求的 user_data：kSyncTag + 槽位（普通 fd 用 kFileSlots）
+constexpr uint64_t kSyncTag = 1ull << 32;
+constexpr unsigned kRingEntries = 32;
+
+int sysSetup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sysEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                                      flags, nullptr, 0));
+}
+
+int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+size_t pageAligned(size_t bytes) {
+    long n = ::sysconf(_SC_PAGESIZE);
+    size_t page = n > 0 ? static_cast<size_t>(n) : size_t(4096);
+    return (bytes + page - 1) / page * page;
+}
+}  // namespace
+
+UringSegmentWriter::UringSegmentWriter() {
+    if (!setupRing(kRingEntries)) return;
+    if (!allocBuffers(kMinBufferBytes)) {
+        teardownRing();
+    }
+}
+
+UringSegmentWriter::~UringSegmentWriter() {
+    if (!ok()) return;
+    close();
+    freeBuffers();
+    teardownRing();
+}
+
+// ============================================
+// ring 管理
+// ============================================
+bool UringSegmentWriter::setupRing(unsigned entries) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int fd = sysSetup(entries, &p);
+    if (fd < 0) return false;
+    ring_fd_ = fd;
+
+    sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        sq_ptr_ = nullptr;
+        teardownRing();
+        return false;
+    }
+    if (single) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            cq_ptr_ = nullptr;
+            teardownRing();
+            return false;
+        }
+    }
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ptr_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd_, IORING_OFF_SQES);
+    if (sqes_ptr_ == MAP_FAILED) {
+        sqes_ptr_ = nullptr;
+        teardownRing();
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    char* cq = static_cast<char*>(cq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = cq + p.cq_off.cqes;
+    sq_entries_ = p.sq_entries;
+    sq_tail_local_ = *sq_tail_;
+    return true;
+}
+
+void UringSegmentWriter::teardownRing() {
+    if (sqes_ptr_) ::munmap(sqes_ptr_, sqes_size_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_size_);
+    if (sq_ptr_) ::munmap(sq_ptr_, sq_size_);
+    sqes_ptr_ = cq_ptr_ = sq_ptr_ = nullptr;
+    if (ring_fd_ >= 0) ::close(ring_fd_);  // 同时释放注册的文件与缓冲
+    ring_fd_ = -1;
+}
+
+bool UringSegmentWriter::allocBuffers(size_t bytes) {
+    buffer_bytes_ = pageAligned(std::max(bytes, kMinBufferBytes));
+    buffers_.assign(kBuffers, Buffer{});
+    std::vector<iovec> iovs;
+    for (auto& b : buffers_) {
+        void* p = nullptr;
+        if (::posix_memalign(&p, pageAligned(1), buffer_bytes_) != 0) {
+            freeBuffers();
+            return false;
+        }
+        b.data = static_cast<char*>(p);
+        iovs.push_back(iovec{b.data, buffer_bytes_});
+    }
+    // 注册失败（如 RLIMIT_MEMLOCK 不足）时退回普通 WRITEV
+    buffers_registered_ = sysRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovs.data(),
+                                      static_cast<unsigned>(iovs.size())) == 0;
+    return true;
+}
+
+void UringSegmentWriter::freeBuffers() {
+    if (buffers_registered_) {
+        sysRegister(ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        buffers_registered_ = false;
+    }
+    for (auto& b : buffers_) {
+        std::free(b.data);
+    }
+    buffers_.clear();
+    current_ = -1;
+}
+
+void UringSegmentWriter::registerFile() {
+    file_fixed_ = false;
+    if (!files_registered_) {
+        int empty[kFileSlots];
+        std::fill(std::begin(empty), std::end(empty), -1);
+        files_registered_ = sysRegister(ring_fd_, IORING_REGISTER_FILES, empty, kFileSlots) == 0;
+        if (!files_registered_) return;  // 退回普通 fd
+    }
+    
+    // 固定文件在请求真正执行时才按槽位解析，不能覆盖仍有在途请求的槽位
+    int slot = -1;
+    while (slot < 0) {
+        for (unsigned i = 0; i < kFileSlots; ++i) {
+            unsigned s = (slot_ + 1 + i) % kFileSlots;
+            if (slot_in_flight_[s] == 0) {
+                slot = static_cast<int>(s);
+                break;
+            }
+        }
+        if (slot < 0 && !enter(1)) return;
+    }
+    
+    int fds[1] = {fd_};
+    io_uring_files_update up;
+    std::memset(&up, 0, sizeof(up));
+    up.offset = static_cast<uint32_t>(slot);
+    up.fds = reinterpret_cast<uint64_t>(fds);
+    file_fixed_ = sysRegister(ring_fd_, IORING_REGISTER_FILES_UPDATE, &up, 1) == 1;
+    slot_ = static_cast<unsigned>(slot);
+}
+
+// ============================================
+// 提交与完成
+// ============================================
+void* UringSegmentWriter::nextSqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sq_tail_local_ - head >= sq_entries_) {
+        enter(0);
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_tail_local_ - head >= sq_entries_) return nullptr;
+    }
+    unsigned idx = sq_tail_local_ & *sq_mask_;
+    auto* sqe = static_cast<io_uring_sqe*>(sqes_ptr_) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+    ++sq_tail_local_;
+    ++to_submit_;
+    return sqe;
+}
+
+bool UringSegmentWriter::enter(unsigned wait_nr) {
+    __atomic_store_n(sq_tail_, sq_tail_local_, __ATOMIC_RELEASE);
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (to_submit_ > 0 || wait_nr > 0) {
+        int ret = sysEnter(ring_fd_, to_submit_, wait_nr, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EBUSY) {
+                // 完成队列已满：先收割再重试
+                reap();
+                continue;
+            }
+            std::cerr << "[UringSegmentWriter] io_uring_enter failed: "
+                      << std::strerror(errno) << "\n";
+            failed_ = true;
+            return false;
+        }
+        to_submit_ -= std::min<unsigned>(to_submit_, static_cast<unsigned>(ret));
+        break;
+    }
+    reap();
+    return true;
+}
+
+void UringSegmentWriter::reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    auto* cqes = static_cast<io_uring_cqe*>(cqes_);
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes[head & *cq_mask_];
+        if (cqe.user_data >= kSyncTag) {
+            uint64_t slot = cqe.user_data - kSyncTag;
+            if (slot < kFileSlots) --slot_in_flight_[slot];
+            --syncs_in_flight_;
+            if (cqe.res < 0 && cqe.res != -ECANCELED) {
+                std::cerr << "[UringSegmentWriter] fdatasync failed: "
+                          << std::strerror(-cqe.res) << "\n";
+            }
+        } else if (cqe.user_data < buffers_.size()) {
+            Buffer& b = buffers_[cqe.user_data];
+            if (cqe.res < 0 || static_cast<size_t>(cqe.res) != b.submitted) {
+                std::cerr << "[UringSegmentWriter] write failed: "
+                          << (cqe.res < 0 ? std::strerror(-cqe.res) : "short write") << "\n";
+                failed_ = true;
+            }
+            // 完成即回收缓冲
+            if (b.slot >= 0) --slot_in_flight_[b.slot];
+            b.in_flight = false;
+            b.used = 0;
+            --in_flight_;
+        }
+        ++head;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+void UringSegmentWriter::waitAll() {
+    while (in_flight_ + syncs_in_flight_ > 0) {
+        if (!enter(1)) break;
+    }
+}
+
+bool UringSegmentWriter::acquireBuffer() {
+    while (true) {
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            if (!buffers_[i].in_flight) {
+                current_ = static_cast<int>(i);
+                buffers_[i].used = 0;
+                return true;
+            }
+        }
+        // 全部在途：等一个完成事件
+        if (!enter(1)) return false;
+    }
+}
+
+void UringSegmentWriter::submitCurrent(bool with_sync) {
+    bool has_data = current_ >= 0 && buffers_[current_].used > 0;
+    if (!has_data && !with_sync) return;
+
+    uint8_t fixed_flag = file_fixed_ ? IOSQE_FIXED_FILE : 0;
+    int target_fd = file_fixed_ ? static_cast<int>(slot_) : fd_;
+
+    if (has_data) {
+        auto* sqe = static_cast<io_uring_sqe*>(nextSqe());
+        if (!sqe) {
+            failed_ = true;
+            return;
+        }
+        Buffer& b = buffers_[current_];
+        if (buffers_registered_) {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(b.data);
+            sqe->len = static_cast<uint32_t>(b.used);
+            sqe->buf_index = static_cast<uint16_t>(current_);
+        } else {
+            b.iov = iovec{b.data, b.used};
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(&b.iov);
+            sqe->len = 1;
+        }
+        sqe->fd = target_fd;
+        sqe->flags = fixed_flag | (with_sync ? IOSQE_IO_LINK : 0);
+        sqe->off = offset_;
+        sqe->user_data = static_cast<uint64_t>(current_);
+        b.slot = file_fixed_ ? static_cast<int>(slot_) : -1;
+        if (file_fixed_) ++slot_in_flight_[slot_];
+
+        offset_ += b.used;
+        b.submitted = b.used;
+        b.in_flight = true;
+        ++in_flight_;
+        current_ = -1;
+    }
+
+    if (with_sync) {
+        auto* sqe = static_cast<io_uring_sqe*>(nextSqe());
+        if (sqe) {
+            // DRAIN：等之前提交的所有写入完成后再同步
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = target_fd;
+            sqe->flags = fixed_flag | IOSQE_IO_DRAIN;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sqe->user_data = kSyncTag + (file_fixed_ ? slot_ : kFileSlots);
+            if (file_fixed_) ++slot_in_flight_[slot_];
+            ++syncs_in_flight_;
+        }
+    }
+    enter(0);
+}
+
+bool UringSegmentWriter::copyIn(const char* data, size_t n) {
+    while (n > 0) {
+        if (current_ < 0 && !acquireBuffer()) return false;
+        Buffer& b = buffers_[current_];
+        size_t k = std::min(n, buffer_bytes_ - b.used);
+        std::memcpy(b.data + b.used, data, k);
+        b.used += k;
+        data += k;
+        n -= k;
+        if (b.used == buffer_bytes_) {
+            submitCurrent(false);
+        }
+    }
+    return !failed_;
+}
+
+// ============================================
+// ISegmentWriter
+// ============================================
+bool UringSegmentWriter::open(const std::filesystem::path& path) {
+    if (!ok()) return false;
+    close();
+    // 偏移显式给出，不用 O_APPEND（并发完成的请求在 O_APPEND 下可能乱序）
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[UringSegmentWriter] Failed to open " << path << ": "
+                  << std::strerror(errno) << "\n";
+        failed_ = true;
+        return false;
+    }
+    struct stat st;
+    offset_ = ::fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    failed_ = false;
+    registerFile();
+    return true;
+}
+
+void UringSegmentWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+    file_fixed_ = false;
+}
+
+void UringSegmentWriter::closeAsync() {
+    if (fd_ < 0) return;
+    // 普通 fd 在请求执行时才解析，关闭后可能被复用，只能同步关闭
+    if (!file_fixed_) {
+        close();
+        return;
+    }
+    // 剩余数据（及可选的 fdatasync）已进入 ring，注册表槽位持有文件引用直到被复用
+    submitCurrent(durable_);
+    ::close(fd_);
+    fd_ = -1;
+    file_fixed_ = false;
+}
+
+bool UringSegmentWriter::write(GatherBuffer& buf, bool flush_now) {
+    if (!good()) return false;
+    for (const auto& v : buf.iov()) {
+        if (!copyIn(static_cast<const char*>(v.iov_base), v.iov_len)) return false;
+    }
+    if (flush_now) {
+        submitCurrent(durable_);
+    }
+    return !failed_;
+}
+
+bool UringSegmentWriter::write(const char* data, size_t n) {
+    if (!good()) return false;
+    return copyIn(data, n);
+}
+
+bool UringSegmentWriter::flush() {
+    if (!ok()) return false;
+    if (fd_ >= 0) {
+        submitCurrent(durable_);
+    }
+    waitAll();
+    return !failed_;
+}
+
+void UringSegmentWriter::setBufferSize(size_t bytes) {
+    if (!ok() || pageAligned(std::max(bytes, kMinBufferBytes)) == buffer_bytes_) return;
+    if (fd_ >= 0) {
+        submitCurrent(false);
+    }
+    waitAll();
+    freeBuffers();
+    if (!allocBuffers(bytes)) {
+        std::cerr << "[UringSegmentWriter] Failed to allocate buffers\n";
+        failed_ = true;
+    }
+}
+
+#else  // !LOGGER_HAVE_IO_URING
+
+UringSegmentWriter::UringSegmentWriter() = default;
+UringSegmentWriter::~UringSegmentWriter() = default;
+bool UringSegmentWriter::open(const std::filesystem::path&) { return false; }
+void UringSegmentWriter::close() {}
+void UringSegmentWriter::closeAsync() {}
+bool UringSegmentWriter::write(GatherBuffer&, bool) { return false; }
+bool UringSegmentWriter::write(const char*, size_t) { return false; }
+bool UringSegmentWriter::flush() { return false; }
+void UringSegmentWriter::setBufferSize(size_t) {}
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+#include "SegmentWriter.h"
+#include <cstdint>
+#include <vector>
+
+// 编译环境缺少内核头文件时整体退回 fd 后端
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define LOGGER_HAVE_IO_URING 1
+#  endif
+#endif
+
+/**
+ * @brief io_uring 写出后端（直接使用系统调用，不依赖 liburing）
+ *
+ * 多块页对齐缓冲轮流使用：写满或需要刷新时提交一个按显式偏移的写请求后立即返回，
+ * 缓冲在完成事件到达后回收；只有全部缓冲都在途时才等待。文件与缓冲均注册到 ring，
+ * 省去每次请求的 fd 查找与页固定。开启持久化时写请求后链接 fdatasync。
+ *
+ * 内核不支持（或被 seccomp/sysctl 禁用）时 ok() 为 false，
+ * 由 makeSegmentWriter 自动退回 FdSegmentWriter。
+ */
+class UringSegmentWriter : public ISegmentWriter {
+public:
+    static constexpr unsigned kBuffers = 8;        // 同时在途的缓冲数
+    static constexpr size_t kMinBufferBytes = 64 * 1024;
+    // 注册文件表槽位数：轮转后旧段的在途请求仍按槽位解析文件，
+    // 槽位只有在其上的请求全部完成后才会被新段复用
+    static constexpr unsigned kFileSlots = 4;
+
+    UringSegmentWriter();
+    ~UringSegmentWriter() override;
+
+    UringSegmentWriter(const UringSegmentWriter&) = delete;
+    UringSegmentWriter& operator=(const UringSegmentWriter&) = delete;
+
+    // ring 与缓冲是否初始化成功
+    bool ok() const { return ring_fd_ >= 0; }
+
+    bool open(const std::filesystem::path& path) override;
+    // 等待全部写入完成后关闭
+    void close() override;
+    // 提交剩余数据后立即关闭 fd，在途写请求由 ring 持有的文件引用完成
+    void closeAsync() override;
+    bool isOpen() const override { return fd_ >= 0; }
+    bool good() const override { return fd_ >= 0 && !failed_; }
+
+    bool write(GatherBuffer& buf, bool flush_now) override;
+    bool write(const char* data, size_t n) override;
+    // 提交当前缓冲并等待所有在途请求完成
+    bool flush() override;
+    void setBufferSize(size_t bytes) override;
+    void setDurable(bool durable) override { durable_ = durable; }
+
+private:
+    struct Buffer {
+        char* data = nullptr;
+        size_t used = 0;
+        size_t submitted = 0;   // 在途请求的长度，用于识别短写
+        bool in_flight = false;
+        int slot = -1;          // 请求使用的注册文件槽位（-1 为普通 fd）
+        iovec iov{};            // 未能注册缓冲时 WRITEV 使用
+    };
+
+    bool setupRing(unsigned entries);
+    void teardownRing();
+    bool allocBuffers(size_t bytes);
+    void freeBuffers();
+    void registerFile();
+
+    // 把数据拷进当前缓冲，写满即提交
+    bool copyIn(const char* data, size_t n);
+    // 提交当前缓冲（可选链接 fdatasync），不等待
+    void submitCurrent(bool with_sync);
+    bool acquireBuffer();
+    void* nextSqe();
+    // 提交已排队的 SQE，并至少等待 wait_nr 个完成事件
+    bool enter(unsigned wait_nr);
+    void reap();
+    void waitAll();
+
+    // ring 状态
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    void* cq_ptr_ = nullptr;
+    size_t cq_size_ = 0;
+    void* sqes_ptr_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    void* cqes_ = nullptr;
+    unsigned sq_entries_ = 0;
+    unsigned sq_tail_local_ = 0;    // 已填写但尚未发布给内核的尾指针
+    unsigned to_submit_ = 0;
+
+    // 缓冲与文件
+    std::vector<Buffer> buffers_;
+    size_t buffer_bytes_ = 0;
+    int current_ = -1;
+    unsigned in_flight_ = 0;
+    unsigned syncs_in_flight_ = 0;
+    bool buffers_registered_ = false;
+    bool files_registered_ = false;
+    bool file_fixed_ = false;       // 当前 fd 已放入注册表槽位 slot_
+    unsigned slot_ = 0;
+    unsigned slot_in_flight_[kFileSlots] = {};
+
+    int fd_ = -1;
+    uint64_t offset_ = 0;           // 下一次写入的文件偏移（请求可能乱序完成，偏移显式指定）
+    bool failed_ = false;
+    bool durable_ = false;
+};
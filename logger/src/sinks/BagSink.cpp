@@ -1,6 +1,16 @@
 #include "BagSink.h"
 #include <iostream>
 
+namespace {
+#pragma pack(push, 1)
+struct MessageRecordPrefix {
+    uint64_t timestamp;
+    uint32_t topic_len;
+};
+#pragma pack(pop)
+static_assert(sizeof(MessageRecordPrefix) == 12, "on-disk record prefix must stay packed");
+}  // namespace
+
 BagSink::BagSink(
     const std::filesystem::path& base_dir,
     const std::string& module_name,
@@ -8,50 +18,48 @@ BagSink::BagSink(
     size_t max_bytes,
     std::chrono::minutes max_age,
     size_t reserve_n,
-    bool compress_old)
+    bool compress_old,
+    IoBackend io_backend,
+    std::shared_ptr<ICompressionStrategy> compression)
 {
     auto module_dir = base_dir / module_name;
     
     rolling_mgr_ = std::make_unique<RollingFileManager>(
-        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old
+        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old,
+        std::move(compression)
     );
+    if (io_backend != IoBackend::Stream) {
+        rolling_mgr_->setIoBackend(io_backend);
+    }
 }
 
 void BagSink::writeMessage(
-    const std::string& topic,
-    const std::string& type,
-    const std::vector<uint8_t>& data,
+    std::string_view topic,
+    std::string_view type,
+    const uint8_t* data, size_t size,
     uint64_t timestamp)
 {
+    MessageRecord record{topic, type, data, size, timestamp};
+    writeMessageBatch({&record, 1});
+}
+
+void BagSink::writeMessageBatch(RecordSpan<MessageRecord> records) {
     std::lock_guard<std::mutex> lock(mtx_);
     
-    if (needRotate()) {
-        rotate();
-    }
-    
-    uint32_t topic_len = static_cast<uint32_t>(topic.size());
-    uint32_t type_len = static_cast<uint32_t>(type.size());
-    uint32_t data_len = static_cast<uint32_t>(data.size());
-    
-    size_t total_size = sizeof(timestamp) + 
-                       sizeof(topic_len) + topic_len +
-                       sizeof(type_len) + type_len +
-                       sizeof(data_len) + data_len;
-    
-    if (!ensureWritable(total_size)) {
-        return; // 磁盘空间不足
-    }
-    
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-        os.write(reinterpret_cast<const char*>(&topic_len), sizeof(topic_len));
-        os.write(topic.data(), topic_len);
-        os.write(reinterpret_cast<const char*>(&type_len), sizeof(type_len));
-        os.write(type.data(), type_len);
-        os.write(reinterpret_cast<const char*>(&data_len), sizeof(data_len));
-        os.write(reinterpret_cast<const char*>(data.data()), data_len);
-    }
+    // 记录格式：u64 timestamp | u32 topic_len | topic | u32 type_len | type | u32 data_len | data
+    // 定长前缀整体拷贝；大负载在 fd 后端下以 iovec 引用，不经过暂存区
+    rolling_mgr_->writeBatch(records.ptr, records.size(), batch_buf_,
+        [](const MessageRecord& r, GatherBuffer& buf) {
+            MessageRecordPrefix prefix{r.timestamp, static_cast<uint32_t>(r.topic.size())};
+            uint32_t type_len = static_cast<uint32_t>(r.type.size());
+            uint32_t data_len = static_cast<uint32_t>(r.size);
+            buf.appendPod(prefix);
+            buf.appendCopy(r.topic.data(), prefix.topic_len);
+            buf.appendPod(type_len);
+            buf.appendCopy(r.type.data(), type_len);
+            buf.appendPod(data_len);
+            buf.append(r.data, data_len);
+        });
 }
 
 bool BagSink::needRotate() {
@@ -68,8 +76,5 @@ bool BagSink::ensureWritable(size_t bytes_hint) {
 
 void BagSink::flush() {
     std::lock_guard<std::mutex> lock(mtx_);
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os.flush();
-    }
+    rolling_mgr_->flush();
 }
\ No newline at end of file
@@ -13,20 +13,27 @@ public:
            size_t max_bytes,
            std::chrono::minutes max_age,
            size_t reserve_n,
-           bool compress_old);
+           bool compress_old,
+           IoBackend io_backend = IoBackend::Stream,
+           std::shared_ptr<ICompressionStrategy> compression = nullptr);
     
     void writeText(const std::string&) override {
         // Bag Sink 不处理文本数据
     }
     
-    void writeBinary(const std::vector<uint8_t>&, const std::string&, uint64_t) override {
+    void writeBinary(const uint8_t*, size_t, std::string_view, uint64_t) override {
         // Bag Sink 不处理二进制数据
     }
     
-    void writeMessage(const std::string& topic,
-                     const std::string& type,
-                     const std::vector<uint8_t>& data,
+    void writeMessage(std::string_view topic,
+                     std::string_view type,
+                     const uint8_t* data, size_t size,
                      uint64_t timestamp) override;
+    void writeMessageBatch(RecordSpan<MessageRecord> records) override;
+    
+    void writeCompact(uint32_t, uint64_t, const uint8_t*, size_t) override {
+        // Bag Sink 不处理紧凑文本
+    }
     
     bool needRotate() override;
     void rotate() override;
@@ -36,4 +43,5 @@ public:
 private:
     std::unique_ptr<RollingFileManager> rolling_mgr_;
     std::mutex mtx_;
+    GatherBuffer batch_buf_;  // 批量编码缓冲，跨批次复用
 };
\ No newline at end of file
@@ -1,6 +1,22 @@
 #include "BinaryRollingFileSink.h"
+#include <cstring>
 #include <iostream>
 
+namespace {
+#pragma pack(push, 1)
+struct BinaryRecordPrefix {
+    uint64_t timestamp;
+    uint32_t tag_len;
+};
+#pragma pack(pop)
+static_assert(sizeof(BinaryRecordPrefix) == 12, "on-disk record prefix must stay packed");
+
+int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
 BinaryRollingFileSink::BinaryRollingFileSink(
     const std::filesystem::path& base_dir,
     const std::string& module_name,
@@ -8,42 +24,145 @@ BinaryRollingFileSink::BinaryRollingFileSink(
     size_t max_bytes,
     std::chrono::minutes max_age,
     size_t reserve_n,
-    bool compress_old)
+    bool compress_old,
+    IoBackend io_backend,
+    std::shared_ptr<ICompressionStrategy> compression)
+    : max_bytes_(max_bytes)
 {
     auto module_dir = base_dir / module_name;
     
     rolling_mgr_ = std::make_unique<RollingFileManager>(
-        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old
+        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old,
+        std::move(compression)
     );
+    if (io_backend == IoBackend::Mmap) {
+        // 段文件由映射段直接写入，管理器只负责命名、轮转、压缩与保留；
+        // 映射区写入无法逐帧压缩，只能轮转后整段压缩
+        rolling_mgr_->setStreamCompression(false);
+        rolling_mgr_->setIoBackend(IoBackend::Mmap);
+        mapped_ = std::make_unique<MappedSegment>();
+        std::lock_guard<std::mutex> lock(mtx_);
+        openMapped();
+    } else if (io_backend != IoBackend::Stream) {
+        rolling_mgr_->setIoBackend(io_backend);
+    }
+}
+
+BinaryRollingFileSink::~BinaryRollingFileSink() {
+    if (mapped_) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        mapped_->seal();
+        rolling_mgr_->setCurrentRecords(mapped_->committedRecords());
+        mapped_->close();
+    }
 }
 
 void BinaryRollingFileSink::writeBinary(
-    const std::vector<uint8_t>& data,
-    const std::string& tag,
+    const uint8_t* data, size_t size,
+    std::string_view tag,
     uint64_t timestamp)
 {
+    BinaryRecord record{tag, data, size, timestamp};
+    writeBinaryBatch({&record, 1});
+}
+
+void BinaryRollingFileSink::writeBinaryBatch(RecordSpan<BinaryRecord> records) {
+    if (mapped_) {
+        for (const auto& r : records) {
+            appendMapped(r);
+        }
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(mtx_);
     
-    if (needRotate()) {
-        rotate();
+    // 记录格式：u64 timestamp | u32 tag_len | tag | u32 data_len | data
+    // 定长前缀整体拷贝；大负载在 fd 后端下以 iovec 引用，不经过暂存区
+    rolling_mgr_->writeBatch(records.ptr, records.size(), batch_buf_,
+        [](const BinaryRecord& r, GatherBuffer& buf) {
+            BinaryRecordPrefix prefix{r.timestamp, static_cast<uint32_t>(r.tag.size())};
+            uint32_t data_len = static_cast<uint32_t>(r.size);
+            buf.appendPod(prefix);
+            buf.appendCopy(r.tag.data(), prefix.tag_len);
+            buf.appendPod(data_len);
+            buf.append(r.data, data_len);
+        });
+}
+
+void BinaryRollingFileSink::appendMapped(const BinaryRecord& r) {
+    // 负载与流式格式相同：u64 timestamp | u32 tag_len | tag | u32 data_len | data
+    BinaryRecordPrefix prefix{r.timestamp, static_cast<uint32_t>(r.tag.size())};
+    uint32_t data_len = static_cast<uint32_t>(r.size);
+    size_t len = sizeof(prefix) + prefix.tag_len + sizeof(data_len) + data_len;
+    if (MappedSegment::frameBytes(len) + MappedSegment::kFileHeaderBytes > max_bytes_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
     
-    uint32_t tag_len = static_cast<uint32_t>(tag.size());
-    uint32_t data_len = static_cast<uint32_t>(data.size());
-    size_t total_size = sizeof(timestamp) + sizeof(tag_len) + tag_len + 
-                       sizeof(data_len) + data_len;
-    
-    if (!ensureWritable(total_size)) {
-        return; // 磁盘空间不足
+    // 同步模式或持续负载下工作线程不会空闲：段龄轮转与磁盘恢复后的重新映射也在写入路径上检查
+    if (steadyNanos() >= next_check_ns_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (steadyNanos() >= next_check_ns_.load(std::memory_order_relaxed)) {
+            checkMappedLocked();
+        }
     }
     
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-        os.write(reinterpret_cast<const char*>(&tag_len), sizeof(tag_len));
-        os.write(tag.data(), tag_len);
-        os.write(reinterpret_cast<const char*>(&data_len), sizeof(data_len));
-        os.write(reinterpret_cast<const char*>(data.data()), data_len);
+    // 段满时轮转后重试；其它线程可能抢先把新段写满，重试次数有限
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint64_t generation = mapped_->generation();
+        MappedSegment::Reservation slot = mapped_->reserve(len);
+        if (slot) {
+            uint8_t* p = slot.data;
+            std::memcpy(p, &prefix, sizeof(prefix));
+            p += sizeof(prefix);
+            std::memcpy(p, r.tag.data(), prefix.tag_len);
+            p += prefix.tag_len;
+            std::memcpy(p, &data_len, sizeof(data_len));
+            p += sizeof(data_len);
+            std::memcpy(p, r.data, data_len);
+            mapped_->commit(slot);
+            return;
+        }
+        if (slot.status == MappedSegment::ReserveStatus::Closed) {
+            // 其它线程正在轮转：等它换好段；仍未就绪说明磁盘不足，到检查间隔时重试映射，否则丢弃
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!mapped_->isOpen() && steadyNanos() >= next_check_ns_.load(std::memory_order_relaxed)) {
+                checkMappedLocked();
+            }
+            if (!mapped_->isOpen()) break;
+            continue;
+        }
+        rotateMapped(generation);
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BinaryRollingFileSink::rotateMapped(uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (mapped_->generation() != generation) {
+        return;  // 已被其它写入线程轮转
+    }
+    rotateMappedLocked();
+}
+
+void BinaryRollingFileSink::rotateMappedLocked() {
+    mapped_->seal();
+    rolling_mgr_->setCurrentRecords(mapped_->committedRecords());
+    mapped_->close();
+    rolling_mgr_->rotate();
+    openMapped();
+}
+
+void BinaryRollingFileSink::openMapped() {
+    next_check_ns_.store(steadyNanos() + std::chrono::nanoseconds(kMappedCheckInterval).count(),
+                         std::memory_order_relaxed);
+    if (!rolling_mgr_->preallocate(max_bytes_)) {
+        return;
+    }
+    if (!mapped_->open(rolling_mgr_->currentPath(), max_bytes_)) {
+        // 续写的段不是映射格式（如刚从其它后端切换过来）：换新段
+        rolling_mgr_->rotate();
+        mapped_->open(rolling_mgr_->currentPath(), max_bytes_);
     }
 }
 
@@ -52,6 +171,10 @@ bool BinaryRollingFileSink::needRotate() {
 }
 
 void BinaryRollingFileSink::rotate() {
+    if (mapped_) {
+        rotateMapped(mapped_->generation());
+        return;
+    }
     rolling_mgr_->rotate();
 }
 
@@ -60,9 +183,28 @@ bool BinaryRollingFileSink::ensureWritable(size_t bytes_hint) {
 }
 
 void BinaryRollingFileSink::flush() {
+    if (mapped_) {
+        return;  // 映射区写入即进入页缓存，由内核回写
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    rolling_mgr_->flush();
+}
+
+void BinaryRollingFileSink::flushIfDue() {
+    if (!mapped_) {
+        return;
+    }
     std::lock_guard<std::mutex> lock(mtx_);
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os.flush();
+    checkMappedLocked();
+}
+
+void BinaryRollingFileSink::checkMappedLocked() {
+    if (!mapped_->isOpen()) {
+        openMapped();  // 此前磁盘不足未能映射，预算恢复后重试
+    } else if (rolling_mgr_->needRotate()) {
+        rotateMappedLocked();
+    } else {
+        next_check_ns_.store(steadyNanos() + std::chrono::nanoseconds(kMappedCheckInterval).count(),
+                             std::memory_order_relaxed);
     }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "../core/ILogSink.h"
+#include "../manager/MappedSegment.h"
 #include "../manager/RollingFileManager.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <filesystem>
@@ -13,27 +15,61 @@ public:
                          size_t max_bytes,
                          std::chrono::minutes max_age,
                          size_t reserve_n,
-                         bool compress_old);
+                         bool compress_old,
+                         IoBackend io_backend = IoBackend::Stream,
+                         std::shared_ptr<ICompressionStrategy> compression = nullptr);
+    ~BinaryRollingFileSink() override;
     
     void writeText(const std::string&) override {
         // 二进制 Sink 不处理文本数据
     }
     
-    void writeBinary(const std::vector<uint8_t>& data,
-                    const std::string& tag,
+    void writeBinary(const uint8_t* data, size_t size,
+                    std::string_view tag,
                     uint64_t timestamp) override;
+    void writeBinaryBatch(RecordSpan<BinaryRecord> records) override;
     
-    void writeMessage(const std::string&, const std::string&,
-                     const std::vector<uint8_t>&, uint64_t) override {
+    void writeMessage(std::string_view, std::string_view,
+                     const uint8_t*, size_t, uint64_t) override {
         // 二进制 Sink 不处理消息数据
     }
     
+    void writeCompact(uint32_t, uint64_t, const uint8_t*, size_t) override {
+        // 二进制 Sink 不处理紧凑文本
+    }
+    
     bool needRotate() override;
     void rotate() override;
     bool ensureWritable(size_t bytes_hint) override;
     void flush() override;
+    // 映射段模式下按段龄轮转、重试映射（写入路径也按 kMappedCheckInterval 检查）
+    void flushIfDue() override;
+    
+    // 映射段模式：生产者线程可直接并发调用 writeBinary，不经队列
+    bool appendsConcurrently() const override { return mapped_ != nullptr; }
+    // 映射段模式下因段未就绪（磁盘不足）或记录超过段容量而丢弃的记录数
+    uint64_t droppedRecords() const { return dropped_.load(std::memory_order_relaxed); }
     
 private:
+    // 映射段模式：预留 → 编码 → 提交，段满时轮转后重试
+    void appendMapped(const BinaryRecord& r);
+    // generation 与当前段一致时才轮转（并发写入者只轮转一次）
+    void rotateMapped(uint64_t generation);
+    void rotateMappedLocked();
+    // 预分配并映射当前路径；已有文件格式不符时换新段
+    void openMapped();
+    // 段未映射（此前磁盘不足）时重试映射，段龄到期时轮转；调用方持有 mtx_
+    void checkMappedLocked();
+    
+    // 写入路径检查段状态的最小间隔：只比较单调时钟，到期才加锁
+    static constexpr std::chrono::milliseconds kMappedCheckInterval{100};
+    
     std::unique_ptr<RollingFileManager> rolling_mgr_;
     std::mutex mtx_;
+    GatherBuffer batch_buf_;  // 批量编码缓冲，跨批次复用
+    
+    size_t max_bytes_;
+    std::unique_ptr<MappedSegment> mapped_;  // 仅 IoBackend::Mmap
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int64_t> next_check_ns_{0};   // 下次检查的单调时钟刻度
 };
\ No newline at end of file
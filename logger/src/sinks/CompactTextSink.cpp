@@ -0,0 +1,168 @@
+#include "CompactTextSink.h"
+#include "../core/CallSiteRegistry.h"
+#include "../core/CompactLogFormat.h"
+#include "../core/Timestamp.h"
+#include <algorithm>
+#include <iostream>
+
+CompactTextSink::CompactTextSink(
+    const std::filesystem::path& base_dir,
+    const std::string& module_name,
+    const std::string& pattern,
+    size_t max_bytes,
+    std::chrono::minutes max_age,
+    size_t reserve_n,
+    bool compress_old,
+    IoBackend io_backend,
+    std::shared_ptr<ICompressionStrategy> compression)
+{
+    auto module_dir = base_dir / module_name;
+    
+    rolling_mgr_ = std::make_unique<RollingFileManager>(
+        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old,
+        std::move(compression)
+    );
+    if (io_backend != IoBackend::Stream) {
+        rolling_mgr_->setIoBackend(io_backend);
+    }
+    rolling_mgr_->setSegmentStart([this] { beginSegment(); });
+    beginSegment();
+}
+
+CompactTextSink::~CompactTextSink() {
+    try {
+        flush();
+    } catch (...) {
+        // 析构函数不应该抛出异常
+    }
+}
+
+namespace {
+#pragma pack(push, 1)
+// 事件定长头：u8 kEvent | u32 id | u64 mono_ns | u32 args_len
+struct CompactEventPrefix {
+    uint8_t kind;
+    uint32_t site_id;
+    uint64_t mono_ns;
+    uint32_t args_len;
+};
+#pragma pack(pop)
+static_assert(sizeof(CompactEventPrefix) == 17, "on-disk event prefix must stay packed");
+}  // namespace
+
+void CompactTextSink::writeCompact(
+    uint32_t site_id,
+    uint64_t mono_ns,
+    const uint8_t* args,
+    size_t size)
+{
+    CompactRecord record{site_id, mono_ns, args, size};
+    writeCompactBatch({&record, 1});
+}
+
+void CompactTextSink::writeCompactBatch(RecordSpan<CompactRecord> records) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    
+    // 先轮转再补定义，避免把定义写进即将封口的段
+    if (needRotate()) {
+        rotate();
+    }
+    if (!rolling_mgr_->good()) return;
+    
+    // 本段尚未定义的调用点在事件之前一次写出；批内再轮转时由 beginSegment 在新段重写
+    batch_sites_.clear();
+    record_buf_.clear();
+    for (const auto& r : records) {
+        if (std::find(batch_sites_.begin(), batch_sites_.end(), r.site_id) != batch_sites_.end()) continue;
+        batch_sites_.push_back(r.site_id);
+        if (defined_sites_.insert(r.site_id).second) {
+            appendSiteDef(record_buf_, r.site_id);
+        }
+    }
+    if (!record_buf_.empty()) {
+        commitRecord();
+    }
+    
+    rolling_mgr_->writeBatch(records.ptr, records.size(), batch_buf_,
+        [](const CompactRecord& r, GatherBuffer& buf) {
+            CompactEventPrefix prefix{CompactLogFormat::kEvent, r.site_id, r.mono_ns,
+                                      static_cast<uint32_t>(r.size)};
+            buf.appendPod(prefix);
+            buf.append(r.args, prefix.args_len);
+        });
+    batch_sites_.clear();
+}
+
+void CompactTextSink::commitRecord() {
+    rolling_mgr_->append(record_buf_.data(), record_buf_.size());
+}
+
+void CompactTextSink::appendSiteDef(std::string& out, uint32_t site_id) {
+    const CallSiteInfo* info = CallSiteRegistry::instance().lookup(site_id);
+    if (!info) {
+        std::cerr << "[CompactSink] Unknown call site " << site_id << "\n";
+        return;
+    }
+    
+    auto appendStr = [&out](const std::string& s) {
+        uint16_t len = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+        out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.append(s.data(), len);
+    };
+    
+    uint8_t level = static_cast<uint8_t>(info->level);
+    int32_t line = info->line;
+    uint8_t nargs = static_cast<uint8_t>(info->arg_types.size());
+    
+    out.push_back(static_cast<char>(CompactLogFormat::kSiteDef));
+    out.append(reinterpret_cast<const char*>(&site_id), sizeof(site_id));
+    out.append(reinterpret_cast<const char*>(&level), sizeof(level));
+    out.append(reinterpret_cast<const char*>(&line), sizeof(line));
+    out.append(reinterpret_cast<const char*>(&nargs), sizeof(nargs));
+    out.append(reinterpret_cast<const char*>(info->arg_types.data()), nargs);
+    appendStr(info->file);
+    appendStr(info->function);
+    appendStr(info->format);
+}
+
+void CompactTextSink::beginSegment() {
+    defined_sites_.clear();
+    
+    if (!rolling_mgr_->good()) return;
+    
+    record_buf_.clear();
+    if (rolling_mgr_->currentBytes() == 0) {
+        uint16_t version = CompactLogFormat::kVersion;
+        uint16_t reserved = 0;
+        record_buf_.append(CompactLogFormat::kMagic, sizeof(CompactLogFormat::kMagic));
+        record_buf_.append(reinterpret_cast<const char*>(&version), sizeof(version));
+        record_buf_.append(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    }
+    ClockAnchor anchor = ClockAnchor::capture();
+    record_buf_.push_back(static_cast<char>(CompactLogFormat::kAnchor));
+    record_buf_.append(reinterpret_cast<const char*>(&anchor.mono_ns), sizeof(anchor.mono_ns));
+    record_buf_.append(reinterpret_cast<const char*>(&anchor.wall_ns), sizeof(anchor.wall_ns));
+    for (uint32_t site_id : batch_sites_) {
+        defined_sites_.insert(site_id);
+        appendSiteDef(record_buf_, site_id);
+    }
+    commitRecord();
+}
+
+bool CompactTextSink::needRotate() {
+    return rolling_mgr_->needRotate();
+}
+
+void CompactTextSink::rotate() {
+    // 新段的段头由 RollingFileManager 的换段回调写入
+    rolling_mgr_->rotate();
+}
+
+bool CompactTextSink::ensureWritable(size_t bytes_hint) {
+    return rolling_mgr_->ensureWritable(bytes_hint);
+}
+
+void CompactTextSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    rolling_mgr_->flush();
+}
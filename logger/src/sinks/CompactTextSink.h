@@ -0,0 +1,62 @@
+#pragma once
+#include "../core/ILogSink.h"
+#include "../manager/RollingFileManager.h"
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// compact_text 模式的输出：调用点定义 + 二进制事件，格式见 CompactLogFormat.h
+class CompactTextSink : public ILogSink {
+public:
+    CompactTextSink(const std::filesystem::path& base_dir,
+                    const std::string& module_name,
+                    const std::string& pattern,
+                    size_t max_bytes,
+                    std::chrono::minutes max_age,
+                    size_t reserve_n,
+                    bool compress_old,
+                    IoBackend io_backend = IoBackend::Stream,
+                    std::shared_ptr<ICompressionStrategy> compression = nullptr);
+    ~CompactTextSink() override;
+    
+    void writeText(const std::string&) override {
+        // 紧凑 Sink 不处理格式化文本
+    }
+    
+    void writeBinary(const uint8_t*, size_t, std::string_view, uint64_t) override {
+        // 紧凑 Sink 不处理二进制数据
+    }
+    
+    void writeMessage(std::string_view, std::string_view,
+                     const uint8_t*, size_t, uint64_t) override {
+        // 紧凑 Sink 不处理消息数据
+    }
+    
+    void writeCompact(uint32_t site_id, uint64_t mono_ns,
+                      const uint8_t* args, size_t size) override;
+    // 一次加锁、一次轮转检查，事件经 RollingFileManager::writeBatch 连续写出
+    void writeCompactBatch(RecordSpan<CompactRecord> records) override;
+    
+    bool needRotate() override;
+    void rotate() override;
+    bool ensureWritable(size_t bytes_hint) override;
+    void flush() override;
+    
+private:
+    // 新段开始：空文件写文件头，写入时钟锚点，重置已定义调用点集合，
+    // 并补写当前批次用到的调用点定义（批次中途轮转时新段仍可独立解码）
+    void beginSegment();
+    void appendSiteDef(std::string& out, uint32_t site_id);
+    // 把 record_buf_ 写入当前段并上报写入量
+    void commitRecord();
+    
+    std::unique_ptr<RollingFileManager> rolling_mgr_;
+    std::unordered_set<uint32_t> defined_sites_;
+    std::string record_buf_;
+    GatherBuffer batch_buf_;
+    std::vector<uint32_t> batch_sites_;   // 正在写入的批次引用的调用点
+    std::mutex mtx_;
+};
@@ -0,0 +1,142 @@
+#include "ConsoleSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+ConsoleSink::ConsoleSink(int fd, LogLevel level, size_t max_pending_bytes)
+    : level_(level)
+    , max_pending_bytes_(max_pending_bytes)
+{
+    fd_ = openNonBlocking(fd, owned_fd_);
+}
+
+ConsoleSink::~ConsoleSink() {
+    try {
+        flush();
+    } catch (...) {
+        // 析构函数不应该抛出异常
+    }
+    if (owned_fd_) {
+        ::close(fd_);
+    }
+    if (uint64_t n = droppedLines()) {
+        std::fprintf(stderr, "[ConsoleSink] Dropped %llu lines (console too slow)\n",
+                     static_cast<unsigned long long>(n));
+    }
+}
+
+int ConsoleSink::openNonBlocking(int fd, bool& owned) {
+    owned = false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || S_ISREG(st.st_mode)) {
+        // 重定向到普通文件时写入不会阻塞；重新打开会丢失原描述的偏移
+        return fd;
+    }
+
+    // 终端/管道：经 /proc 重新打开得到独立的文件描述，
+    // 直接给 fd 设 O_NONBLOCK 会影响共享该描述的其它进程
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    int nb = ::open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (nb >= 0) {
+        owned = true;
+        return nb;
+    }
+    return fd;  // 无法重新打开（如 socket）：退化为写前 poll
+}
+
+void ConsoleSink::writeText(const std::string& formatted_message) {
+    append(formatted_message);
+}
+
+void ConsoleSink::append(std::string_view formatted_message) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    size_t bytes = formatted_message.size() + 1;
+    if (pending_bytes_ + bytes > max_pending_bytes_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (line_count_ == lines_.size()) {
+        lines_.emplace_back();
+    }
+    std::string& line = lines_[line_count_++];
+    line.assign(formatted_message);
+    line.push_back('\n');
+    pending_bytes_ += bytes;
+}
+
+void ConsoleSink::flush() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (fd_ < 0) return;
+
+    if (!owned_fd_) {
+        pollfd pfd{fd_, POLLOUT, 0};
+        if (::poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLOUT)) {
+            return;
+        }
+    }
+
+    iovec iov[IOV_MAX < 256 ? IOV_MAX : 256];
+    const size_t max_iov = sizeof(iov) / sizeof(iov[0]);
+
+    while (first_ < line_count_) {
+        size_t n = std::min(line_count_ - first_, max_iov);
+        for (size_t i = 0; i < n; ++i) {
+            const std::string& line = lines_[first_ + i];
+            size_t skip = i == 0 ? first_offset_ : 0;
+            iov[i].iov_base = const_cast<char*>(line.data() + skip);
+            iov[i].iov_len = line.size() - skip;
+        }
+
+        ssize_t written = ::writev(fd_, iov, static_cast<int>(n));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;  // 写不动：留到下次
+            // EPIPE 等不可恢复错误：丢弃积压
+            dropped_.fetch_add(line_count_ - first_, std::memory_order_relaxed);
+            first_ = line_count_;
+            first_offset_ = 0;
+            break;
+        }
+
+        size_t left = static_cast<size_t>(written);
+        pending_bytes_ -= left;
+        while (left > 0) {
+            size_t remain = lines_[first_].size() - first_offset_;
+            if (left < remain) {
+                first_offset_ += left;
+                break;
+            }
+            left -= remain;
+            ++first_;
+            first_offset_ = 0;
+        }
+        if (first_ < line_count_ && first_offset_ > 0) break;  // 部分写出：管道已满
+    }
+
+    compact();
+}
+
+void ConsoleSink::compact() {
+    if (first_ == 0) return;
+    if (first_ == line_count_) {
+        line_count_ = 0;
+        first_ = 0;
+        pending_bytes_ = 0;
+        return;
+    }
+    // 把未写完的行移到前面，交换而非拷贝以保留各字符串的容量
+    for (size_t i = first_; i < line_count_; ++i) {
+        lines_[i - first_].swap(lines_[i]);
+    }
+    line_count_ -= first_;
+    first_ = 0;
+}
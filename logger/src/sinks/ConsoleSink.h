@@ -0,0 +1,69 @@
+#pragma once
+#include "../core/ILogSink.h"
+#include "../../include/logger/LoggerConfig.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 控制台输出 Sink（非阻塞、批量 writev）
+ *
+ * writeText 只把行追加到待写缓冲；flush 时一次 writev 写出整批。
+ * 终端或管道写不动时保留未写完的部分，待写字节超过上限后新行直接丢弃并计数，
+ * 不会阻塞工作线程，也就不会拖慢文件日志。
+ */
+class ConsoleSink : public ILogSink {
+public:
+    // fd 通常为 STDOUT_FILENO / STDERR_FILENO
+    ConsoleSink(int fd, LogLevel level, size_t max_pending_bytes);
+    ~ConsoleSink() override;
+
+    // 控制台有独立的级别阈值
+    bool accepts(LogLevel level) const { return level >= level_; }
+
+    void writeText(const std::string& formatted_message) override;
+    // 追加一行到待写缓冲（消费者直接传入渲染缓冲中的视图，免去一次拷贝）
+    void append(std::string_view line);
+
+    void writeBinary(const uint8_t*, size_t, std::string_view, uint64_t) override {
+        // 控制台 Sink 不处理二进制数据
+    }
+
+    void writeMessage(std::string_view, std::string_view,
+                     const uint8_t*, size_t, uint64_t) override {
+        // 控制台 Sink 不处理消息数据
+    }
+
+    void writeCompact(uint32_t, uint64_t, const uint8_t*, size_t) override {
+        // 控制台 Sink 不处理紧凑文本
+    }
+    void flush() override;
+
+    uint64_t droppedLines() const { return dropped_.load(std::memory_order_relaxed); }
+
+protected:
+    bool needRotate() override { return false; }
+    void rotate() override {}
+    bool ensureWritable(size_t) override { return true; }
+
+private:
+    // 为 fd 打开独立的非阻塞文件描述（不影响进程其它地方对 stdout 的使用）
+    static int openNonBlocking(int fd, bool& owned);
+    void compact();
+
+    int fd_ = -1;
+    bool owned_fd_ = false;
+    LogLevel level_;
+    size_t max_pending_bytes_;
+
+    // 待写行：只增不缩，字符串容量跨批次复用
+    std::vector<std::string> lines_;
+    size_t line_count_ = 0;
+    size_t first_ = 0;          // 第一条未写完的行
+    size_t first_offset_ = 0;   // 该行已写出的字节数
+    size_t pending_bytes_ = 0;
+
+    std::atomic<uint64_t> dropped_{0};
+    std::mutex mtx_;
+};
@@ -8,14 +8,23 @@ TextRollingFileSink::TextRollingFileSink(
     size_t max_bytes,
     std::chrono::minutes max_age,
     size_t reserve_n,
-    bool compress_old)
+    bool compress_old,
+    const FlushPolicy& flush_policy,
+    IoBackend io_backend,
+    std::shared_ptr<ICompressionStrategy> compression)
+    : flush_policy_(flush_policy)
 {
     // 拼接模块子目录：<base>/<proc_name>/<pid>/<module>/
     auto module_dir = base_dir / module_name;
     
     rolling_mgr_ = std::make_unique<RollingFileManager>(
-        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old
+        module_dir, pattern, max_bytes, max_age, reserve_n, compress_old,
+        std::move(compression)
     );
+    if (io_backend != IoBackend::Stream) {
+        rolling_mgr_->setIoBackend(io_backend);
+    }
+    rolling_mgr_->setFlushPolicy(flush_policy_);
 }
 TextRollingFileSink::~TextRollingFileSink() {
     try {
@@ -26,26 +35,38 @@ TextRollingFileSink::~TextRollingFileSink() {
 }
 
 void TextRollingFileSink::writeText(const std::string& formatted_message) {
+    TextRecord record{formatted_message};
+    writeTextBatch({&record, 1});
+}
+
+void TextRollingFileSink::writeTextBatch(RecordSpan<TextRecord> records) {
     std::lock_guard<std::recursive_mutex> lock(mtx_);
     
-    if (needRotate()) {
-        rotate();
+    bool urgent = false;
+    if (flush_policy_.flush_on_level) {
+        for (const auto& r : records) {
+            if (r.level >= flush_policy_.level) {
+                urgent = true;
+                break;
+            }
+        }
     }
-    size_t estimated_size = formatted_message.size() + 1;
-    if (!ensureWritable(estimated_size)) {
+    
+    size_t written = rolling_mgr_->writeBatch(records.ptr, records.size(), batch_buf_,
+        [](const TextRecord& r, GatherBuffer& buf) {
+            buf.appendCopy(r.line.data(), r.line.size());
+            buf.push_back('\n');
+        }, urgent);
+    
+    if (written < records.size()) {
         // 磁盘空间不足，记录错误但不抛异常
-        std::cerr << "[TextSink] Disk space insufficient, dropping log entry\n";
-        return; // 磁盘空间不足，跳过写入
+        std::cerr << "[TextSink] Disk space insufficient, dropping "
+                  << records.size() - written << " log entries\n";
     }
-    
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os << formatted_message << std::endl;
-        // 更新统计
-        ++total_writes_;
-        total_bytes_ += estimated_size;
-    } else {
-        std::cerr << "[TextSink] Stream not good, skipping write\n";
+    // 更新统计
+    total_writes_ += written;
+    for (size_t i = 0; i < written; ++i) {
+        total_bytes_ += records[i].line.size() + 1;
     }
 }
 bool TextRollingFileSink::needRotate() {
@@ -62,8 +83,10 @@ bool TextRollingFileSink::ensureWritable(size_t bytes_hint) {
 
 void TextRollingFileSink::flush() {
     std::lock_guard<std::recursive_mutex> lock(mtx_);
-    auto& os = rolling_mgr_->stream();
-    if (os.good()) {
-        os.flush();
-    }
+    rolling_mgr_->flush();
+}
+
+void TextRollingFileSink::flushIfDue() {
+    std::lock_guard<std::recursive_mutex> lock(mtx_);
+    rolling_mgr_->flushIfDue();
 }
\ No newline at end of file
@@ -13,19 +13,28 @@ public:
                        size_t max_bytes,
                        std::chrono::minutes max_age,
                        size_t reserve_n,
-                       bool compress_old);
+                       bool compress_old,
+                       const FlushPolicy& flush_policy = FlushPolicy{},
+                       IoBackend io_backend = IoBackend::Stream,
+                       std::shared_ptr<ICompressionStrategy> compression = nullptr);
     ~TextRollingFileSink() override;
     void writeText(const std::string& formatted_message) override;
+    void writeTextBatch(RecordSpan<TextRecord> records) override;
     
-    void writeBinary(const std::vector<uint8_t>&, const std::string&, uint64_t) override {
+    void writeBinary(const uint8_t*, size_t, std::string_view, uint64_t) override {
         // 文本 Sink 不处理二进制数据
     }
     
-    void writeMessage(const std::string&, const std::string&, 
-                     const std::vector<uint8_t>&, uint64_t) override {
+    void writeMessage(std::string_view, std::string_view, 
+                     const uint8_t*, size_t, uint64_t) override {
         // 文本 Sink 不处理消息数据
     }
+    
+    void writeCompact(uint32_t, uint64_t, const uint8_t*, size_t) override {
+        // 文本 Sink 不处理紧凑文本
+    }
     void flush() override;
+    void flushIfDue() override;
     
 protected:
     bool needRotate() override;
@@ -40,4 +49,6 @@ private:
     mutable std::recursive_mutex mtx_;
     size_t total_writes_{0};
     size_t total_bytes_{0};
+    GatherBuffer batch_buf_;  // 批量编码缓冲，跨批次复用
+    FlushPolicy flush_policy_;
 };
\ No newline at end of file
@@ -4,11 +4,36 @@
  */
 
 #include <logger/Logger.h>
+#include <logger/LoggerMacros.h>
+#include "core/CompactLogReader.h"
+#include "sinks/ConsoleSink.h"
+#include "sinks/TextRollingFileSink.h"
+#include "sinks/BagSink.h"
+#include "sinks/BinaryRollingFileSink.h"
+#include "manager/MappedSegment.h"
+#include "manager/CompressionPool.h"
+#include "manager/CompressionStrategies.h"
+#include "manager/AdaptiveCompression.h"
+#include "manager/DictionaryCompression.h"
+#include "manager/SegmentManifest.h"
+#include "manager/DiskQuotaManager.h"
+#include "manager/TierMigrator.h"
+#include <zlib.h>
 #include <iostream>
 #include <cassert>
 #include <filesystem>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <regex>
+#include <set>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -37,6 +62,11 @@ void cleanupTestDir(const std::string& dir) {
     }
 }
 
+// 段文件（排除目录中的段目录日志）
+bool isSegmentFile(const fs::directory_entry& entry) {
+    return entry.is_regular_file() && entry.path().filename() != SegmentManifest::kJournalName;
+}
+
 // 检查日志文件是否存在
 bool logFileExists(const std::string& base_dir, const std::string& pattern) {
     if (!fs::exists(base_dir)) return false;
@@ -78,7 +108,7 @@ void test_basic_logging() {
     LOG_CRITICAL("Critical message");
     
     // 格式化日志
-    LOG_INFO_FMT("Formatted: %d + %d = %d", 1, 2, 3);
+    LOG_INFO_FMT("Formatted: {} + {} = {}", 1, 2, 3);
     
     // 验证日志文件存在
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -139,7 +169,7 @@ void test_async_mode() {
     
     // 快速写入大量日志
     for (int i = 0; i < 100; ++i) {
-        LOG_INFO_FMT("Async log %d", i);
+        LOG_INFO_FMT("Async log {}", i);
     }
     
     // 等待异步队列处理
@@ -327,7 +357,7 @@ void test_performance() {
     
     // 写入10000条日志
     for (int i = 0; i < 10000; ++i) {
-        LOG_INFO_FMT("Performance test log %d", i);
+        LOG_INFO_FMT("Performance test log {}", i);
     }
     
     auto end = std::chrono::high_resolution_clock::now();
@@ -345,6 +375,2267 @@ void test_performance() {
                 "性能测试通过");
 }
 
+// ============================================
+// 测试9: 多生产者无锁队列
+// ============================================
+size_t countLinesContaining(const std::string& base_dir, const std::string& needle) {
+    size_t count = 0;
+    if (!fs::exists(base_dir)) return 0;
+    for (const auto& entry : fs::recursive_directory_iterator(base_dir)) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path());
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.find(needle) != std::string::npos) ++count;
+        }
+    }
+    return count;
+}
+
+void test_mpmc_queue() {
+    TEST_CASE("多生产者无锁队列");
+    
+    cleanupTestDir("./test_logs_mpmc");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_mpmc";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    config.async_queue_size = 1024;
+    config.overflow_policy = OverflowPolicy::Block;  // 不丢日志，便于计数
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "mpmc_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    const int kThreads = 8;
+    const int kPerThread = 2000;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                LOG_INFO_FMT("MPMC producer {} seq {}", t, i);
+            }
+        });
+    }
+    for (auto& th : producers) th.join();
+    
+    // 关闭异步模式会排空队列
+    logger::Logger::instance().setAsync(false);
+    
+    size_t lines = countLinesContaining("./test_logs_mpmc", "MPMC producer");
+    TEST_ASSERT(lines == static_cast<size_t>(kThreads * kPerThread),
+                "Block 策略下无丢失 (" + std::to_string(lines) + " 行)");
+}
+
+// 未经 initFromConfig 时使用默认容量（须在任何初始化之前运行）
+void test_default_queue_capacity() {
+    TEST_CASE("默认异步队列容量");
+    
+    size_t capacity = logger::Logger::instance().queueCapacity();
+    TEST_ASSERT(capacity >= LoggerConfig{}.async_queue_size,
+                "未初始化时队列容量不小于默认值 (" + std::to_string(capacity) + ")");
+}
+
+// 生产者持续写入时反复重配置：队列只在容量变化时重建，且不丢条目
+void test_reconfigure_under_load() {
+    TEST_CASE("写入中重配置");
+    
+    cleanupTestDir("./test_logs_reconf");
+    
+    auto make_config = [](size_t queue_size, AsyncQueueMode mode) {
+        LoggerConfig config;
+        config.base_dir = "./test_logs_reconf";
+        config.log_level = LogLevel::INFO;
+        config.async_mode = true;
+        config.async_queue_size = queue_size;
+        config.async_queue_mode = mode;
+        config.overflow_policy = OverflowPolicy::Block;
+        config.console.enabled = false;
+        config.modules.push_back(ModuleConfig{
+            "text", "reconf_%Y%m%d.log",
+            10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+        });
+        return config;
+    };
+    
+    logger::Logger::instance().init(make_config(256, AsyncQueueMode::Shared));
+    size_t before = logger::Logger::instance().queueCapacity();
+    
+    const int kThreads = 4;
+    const int kPerThread = 5000;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                LOG_INFO_FMT("Reconf producer {} seq {}", t, i);
+            }
+        });
+    }
+    // 重配置期间并发 flush：Sink 表在重建时不能被遍历
+    std::atomic<bool> reconfiguring{true};
+    std::thread flusher([&reconfiguring] {
+        while (reconfiguring.load()) {
+            logger::Logger::instance().flush();
+        }
+    });
+    const size_t sizes[] = {1024, 1024, 64, 4096, 256};
+    for (int round = 0; round < 5; ++round) {
+        logger::Logger::instance().init(make_config(
+            sizes[round], round % 2 ? AsyncQueueMode::PerThread : AsyncQueueMode::Shared));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    reconfiguring.store(false);
+    flusher.join();
+    for (auto& th : producers) th.join();
+    logger::Logger::instance().setAsync(false);
+    
+    size_t lines = countLinesContaining("./test_logs_reconf", "Reconf producer");
+    TEST_ASSERT(lines == static_cast<size_t>(kThreads * kPerThread),
+                "重配置期间无丢失 (" + std::to_string(lines) + " 行)");
+    TEST_ASSERT(logger::Logger::instance().queueCapacity() == before, "容量回到 256 时队列容量一致");
+}
+
+// ============================================
+// 测试10: 每线程 SPSC 缓冲 + 时间戳归并
+// ============================================
+void test_per_thread_queue() {
+    TEST_CASE("每线程缓冲归并");
+    
+    cleanupTestDir("./test_logs_spsc");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_spsc";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    config.async_queue_mode = AsyncQueueMode::PerThread;
+    config.thread_queue_size = 256;
+    config.overflow_policy = OverflowPolicy::Block;
+    // 单核机器上生产者可能在打时间戳与入缓冲之间被长时间抢占，放宽乱序窗口
+    config.merge_window_ms = 200;
+    config.timestamp_precision = TimestampPrecision::Nanos;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "spsc_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    const int kThreads = 8;
+    const int kPerThread = 2000;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                LOG_INFO_FMT("SPSC producer {} seq {}", t, i);
+            }
+        });
+    }
+    for (auto& th : producers) th.join();
+    
+    // 被水位线挡住的条目出窗后由工作线程放行，不依赖停止时的排空
+    auto count_lines = [] {
+        size_t n = 0;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_spsc")) {
+            if (!entry.is_regular_file()) continue;
+            std::ifstream ifs(entry.path());
+            std::string line;
+            while (std::getline(ifs, line)) {
+                if (line.find("SPSC producer ") != std::string::npos) ++n;
+            }
+        }
+        return n;
+    };
+    const size_t kTotal = static_cast<size_t>(kThreads * kPerThread);
+    size_t released = 0;
+    for (int i = 0; i < 50 && released < kTotal; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        logger::Logger::instance().flush();
+        released = count_lines();
+    }
+    TEST_ASSERT(released == kTotal,
+                "出窗的条目无需排空即被写出 (" + std::to_string(released) + " 行)");
+    
+    logger::Logger::instance().setAsync(false);
+    
+    // 同一生产者的条目必须保持先后顺序；跨线程按时间戳全局有序
+    std::vector<int> last_seq(kThreads, -1);
+    bool ordered = true;
+    size_t lines = 0;
+    size_t inversions = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_spsc")) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path());
+        std::string line;
+        std::string last_stamp;
+        while (std::getline(ifs, line)) {
+            auto pos = line.find("SPSC producer ");
+            if (pos == std::string::npos) continue;
+            int t = -1, seq = -1;
+            if (std::sscanf(line.c_str() + pos, "SPSC producer %d seq %d", &t, &seq) != 2) continue;
+            if (t < 0 || t >= kThreads) continue;
+            if (seq <= last_seq[t]) ordered = false;
+            last_seq[t] = seq;
+            ++lines;
+            // 定宽的纳秒时间戳可直接按字符串比较
+            std::string stamp = line.substr(0, line.find(" INFO"));
+            if (stamp < last_stamp) ++inversions;
+            last_stamp = std::move(stamp);
+        }
+    }
+    
+    TEST_ASSERT(lines == kTotal,
+                "线程退出后缓冲被排空 (" + std::to_string(lines) + " 行)");
+    TEST_ASSERT(ordered, "单线程内顺序保持");
+    TEST_ASSERT(inversions == 0,
+                "跨线程按时间戳全局有序 (逆序 " + std::to_string(inversions) + " 处)");
+}
+
+// ============================================
+// 测试11: 超出内联容量的大条目
+// ============================================
+void test_large_entries() {
+    TEST_CASE("大条目溢出缓冲");
+    
+    cleanupTestDir("./test_logs_large");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_large";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    config.overflow_policy = OverflowPolicy::Block;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "large_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    // 覆盖内联、池化和超大块三种存储路径
+    const size_t sizes[] = {16, 1000, 20000, 300000};
+    for (int round = 0; round < 50; ++round) {
+        for (size_t sz : sizes) {
+            LOG_INFO("LARGE:" + std::string(sz, 'x') + ":END");
+        }
+    }
+    logger::Logger::instance().setAsync(false);
+    
+    size_t intact = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_large")) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path());
+        std::string line;
+        while (std::getline(ifs, line)) {
+            auto b = line.find("LARGE:");
+            auto e = line.rfind(":END");
+            if (b == std::string::npos || e == std::string::npos) continue;
+            size_t n = e - (b + 6);
+            if (std::find(std::begin(sizes), std::end(sizes), n) != std::end(sizes) &&
+                line.find_first_not_of('x', b + 6) == e) {
+                ++intact;
+            }
+        }
+    }
+    TEST_ASSERT(intact == 50 * 4, "大条目完整写出 (" + std::to_string(intact) + " 条)");
+}
+
+// ============================================
+// 测试12: 级别闸门与惰性求值
+// ============================================
+void test_lazy_evaluation() {
+    TEST_CASE("级别闸门与惰性求值");
+    
+    cleanupTestDir("./test_logs_lazy");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_lazy";
+    config.log_level = LogLevel::WARNING;
+    config.async_mode = false;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "lazy_%Y%m%d.log",
+        1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    int evaluated = 0;
+    auto expensive = [&evaluated] { ++evaluated; return std::string("expensive"); };
+    
+    LOG_DEBUG(expensive());
+    LOG_INFO(expensive());
+    LOG_LAZY(DEBUG, expensive);
+    LOG_INFO_FMT("{}", expensive());
+    TEST_ASSERT(evaluated == 0, "被过滤的调用不求值参数");
+    
+    LOG_LAZY(ERROR, expensive);
+    LOG_WARN_FMT("warn {}", 1);
+    TEST_ASSERT(evaluated == 1, "启用级别的惰性调用被执行");
+    
+    std::string owned = "rvalue message";
+    LOG_ERROR(std::move(owned));
+    LOG_ERROR(std::string_view("view message"));
+    TEST_ASSERT(countLinesContaining("./test_logs_lazy", "expensive") == 1 &&
+                countLinesContaining("./test_logs_lazy", "warn 1") == 1 &&
+                countLinesContaining("./test_logs_lazy", "view message") == 1,
+                "启用的日志正常写出");
+}
+
+// ============================================
+// 测试13: {} 风格格式化
+// ============================================
+void test_format() {
+    TEST_CASE("{} 风格格式化");
+    
+    cleanupTestDir("./test_logs_fmt");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_fmt";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = false;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "fmt_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    std::string name = "sensor";
+    const char* null_str = nullptr;
+    LOG_INFO_FMT("FMT1 {} {} {} {} {}", -42, 18446744073709551615ULL, true, 'c', name);
+    LOG_INFO_FMT("FMT2 {:x} {:X} {:b} {:.3f} {}", 255, 255, 5, 3.14159, 0.5);
+    LOG_INFO_FMT("FMT3 {{literal}} {} {}", std::string_view("view"), null_str);
+    LOG_INFO_FMT("FMT4 no args");
+    
+    std::string big(5000, 'y');
+    LOG_INFO_FMT("FMT5 {}|", big);
+    
+    TEST_ASSERT(countLinesContaining("./test_logs_fmt",
+                "FMT1 -42 18446744073709551615 true c sensor") == 1, "整数/布尔/字符/字符串");
+    TEST_ASSERT(countLinesContaining("./test_logs_fmt",
+                "FMT2 ff FF 101 3.142 0.5") == 1, "进制与浮点精度");
+    TEST_ASSERT(countLinesContaining("./test_logs_fmt",
+                "FMT3 {literal} view (null)") == 1, "花括号转义与空指针");
+    TEST_ASSERT(countLinesContaining("./test_logs_fmt", "FMT4 no args") == 1, "无参数格式串");
+    TEST_ASSERT(countLinesContaining("./test_logs_fmt", "FMT5 " + big + "|") == 1, "长消息不截断");
+}
+
+// ============================================
+// 测试14: 紧凑二进制文本 + 离线解码
+// ============================================
+void test_compact_text() {
+    TEST_CASE("紧凑二进制文本");
+    
+    cleanupTestDir("./test_logs_compact");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_compact";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    config.compact_text = true;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "plain_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    config.modules.push_back(ModuleConfig{
+        "compact", "compact_%Y%m%d.clog",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    for (int i = 0; i < 3; ++i) {
+        LOG_INFO_FMT("CLOG1 seq={} ratio={:.2f} ok={} tag={}", i, i * 0.5, i % 2 == 0, "abc");
+    }
+    LOG_WARN_FMT("CLOG2 {:x} {:.1f} {}|", 0xbeefu, 2.25f, std::string("pad"));
+    LOG_INFO("CLOG3 plain message");
+    
+    logger::Logger::instance().setAsync(false);
+    logger::Logger::instance().flush();
+    
+    std::vector<std::string> lines;
+    bool ok = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_compact")) {
+        if (entry.path().extension() != ".clog") continue;
+        ok = CompactLogReader::decodeFile(entry.path(), [&](const std::string& line) {
+            lines.push_back(line);
+        }) && ok;
+    }
+    
+    auto contains = [&](const std::string& needle) {
+        return std::count_if(lines.begin(), lines.end(), [&](const std::string& l) {
+            return l.find(needle) != std::string::npos;
+        });
+    };
+    
+    TEST_ASSERT(ok && lines.size() == 5, "解码出全部日志 (" + std::to_string(lines.size()) + " 行)");
+    TEST_ASSERT(contains(" INFO ") == 4 && contains("seq=2 ratio=1.00 ok=true tag=abc") == 1,
+                "参数按格式串还原");
+    TEST_ASSERT(contains(" WARNING ") == 1 && contains("CLOG2 beef 2.2 pad|") == 1, "进制与浮点精度");
+    bool text_written = false;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_compact")) {
+        if (entry.path().extension() == ".log" && fs::file_size(entry.path()) > 0) text_written = true;
+    }
+    TEST_ASSERT(contains("CLOG3 plain message") == 1 && !text_written, "紧凑模式不写文本模块");
+    
+    // 小段 + 异步突发：一批事件跨越多次轮转，每个段仍带段头、锚点与调用点定义
+    config.base_dir = "./test_logs_compact/batch";
+    config.modules = {ModuleConfig{
+        "compact", "cb_%Y%m%d_%H%M%S_%03d.clog",
+        2048, std::chrono::minutes(60), 1000, false
+    }};
+    logger::Logger::instance().init(config);
+    const int kBurst = 600;
+    for (int i = 0; i < kBurst; ++i) {
+        if (i % 3 == 0) {
+            LOG_INFO_FMT("CBATCH a seq={} {}", i, std::string(16, 'a'));
+        } else if (i % 3 == 1) {
+            LOG_WARN_FMT("CBATCH b seq={} {:.1f}", i, i * 0.5);
+        } else {
+            LOG_INFO_FMT("CBATCH c seq={}", i);
+        }
+    }
+    logger::Logger::instance().setAsync(false);
+    logger::Logger::instance().flush();
+    
+    size_t segments = 0, decoded = 0;
+    ok = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_compact/batch")) {
+        if (entry.path().extension() != ".clog") continue;
+        ++segments;
+        ok = CompactLogReader::decodeFile(entry.path(), [&](const std::string& line) {
+            if (line.find("CBATCH ") != std::string::npos) ++decoded;
+        }) && ok;
+    }
+    TEST_ASSERT(segments > 3 && ok && decoded == static_cast<size_t>(kBurst),
+                "批量写入跨段后每段可独立解码 (" + std::to_string(segments) + " 段, " +
+                std::to_string(decoded) + " 行)");
+}
+
+// ============================================
+// 测试15: 单调时钟刻度 + 消费者侧时间戳渲染
+// ============================================
+void test_timestamp_precision() {
+    TEST_CASE("时间戳精度");
+    
+    cleanupTestDir("./test_logs_ts");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_ts";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    config.timestamp_precision = TimestampPrecision::Micros;
+    
+    config.modules.push_back(ModuleConfig{
+        "text", "ts_%Y%m%d.log",
+        10 * 1024 * 1024, std::chrono::minutes(60), 3, false
+    });
+    
+    logger::Logger::instance().init(config);
+    
+    std::time_t before = std::time(nullptr);
+    for (int i = 0; i < 100; ++i) {
+        LOG_INFO_FMT("TS seq {}", i);
+    }
+    logger::Logger::instance().setAsync(false);
+    logger::Logger::instance().flush();
+    std::time_t after = std::time(nullptr);
+    
+    std::vector<std::string> stamps;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_ts")) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path());
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.find("TS seq") != std::string::npos) stamps.push_back(line.substr(0, 26));
+        }
+    }
+    
+    std::regex pattern(R"(\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{6})");
+    bool all_match = !stamps.empty() && std::all_of(stamps.begin(), stamps.end(),
+        [&](const std::string& ts) { return std::regex_match(ts, pattern); });
+    TEST_ASSERT(stamps.size() == 100 && all_match, "微秒精度格式");
+    TEST_ASSERT(std::is_sorted(stamps.begin(), stamps.end()), "时间戳单调不减");
+    
+    bool in_range = false;
+    if (!stamps.empty()) {
+        std::tm tm{};
+        std::istringstream iss(stamps.front().substr(0, 19));
+        iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+        tm.tm_isdst = -1;
+        std::time_t t = std::mktime(&tm);
+        in_range = t >= before - 1 && t <= after + 1;
+    }
+    TEST_ASSERT(in_range, "墙钟换算与系统时间一致");
+}
+
+// ============================================
+// 测试16: 非阻塞控制台 Sink
+// ============================================
+void test_console_sink() {
+    TEST_CASE("非阻塞控制台输出");
+    
+    int fds[2];
+    if (pipe(fds) != 0) {
+        TEST_ASSERT(false, "创建管道");
+        return;
+    }
+    
+    const std::string payload(80, 'c');
+    uint64_t dropped = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        // 无人读取的管道：写满后必须丢弃而不是阻塞
+        ConsoleSink sink(fds[1], LogLevel::WARNING, 16 * 1024);
+        TEST_ASSERT(!sink.accepts(LogLevel::INFO) && sink.accepts(LogLevel::ERROR),
+                    "独立级别阈值");
+        
+        for (int batch = 0; batch < 20; ++batch) {
+            for (int i = 0; i < 100; ++i) {
+                sink.writeText("CONSOLE " + std::to_string(batch * 100 + i) + " " + payload);
+            }
+            sink.flush();
+        }
+        dropped = sink.droppedLines();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    TEST_ASSERT(elapsed < 2000 && dropped > 0,
+                "管道写满时不阻塞 (丢弃 " + std::to_string(dropped) + " 行)");
+    
+    // 读出已写入的内容：每行必须完整
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    std::string data;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+        data.append(buf, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+    close(fds[1]);
+    
+    // 析构时仍在积压的行会丢失，末尾可能留下半行，只检查完整的行
+    data.erase(data.rfind('\n') + 1);
+    std::istringstream iss(data);
+    std::string line;
+    size_t lines = 0;
+    bool intact = true;
+    while (std::getline(iss, line)) {
+        ++lines;
+        if (line.rfind("CONSOLE ", 0) != 0 || line.size() < payload.size() ||
+            line.compare(line.size() - payload.size(), payload.size(), payload) != 0) {
+            intact = false;
+        }
+    }
+    TEST_ASSERT(lines > 0 && intact && lines + dropped <= 2000, "部分写出后续写，完整行无错位");
+}
+
+// ============================================
+// 测试17: 按 sink_type / topic 路由
+// ============================================
+// 读取某个模块目录下所有文件的原始内容
+std::string readModuleFiles(const std::string& dir) {
+    std::string all;
+    if (!fs::exists(dir)) return all;
+    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path(), std::ios::binary);
+        all.append(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    return all;
+}
+
+void test_routing_table() {
+    TEST_CASE("路由表与多 Sink");
+    
+    cleanupTestDir("./test_logs_route");
+    
+    LoggerConfig config;
+    config.base_dir = "./test_logs_route";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = false;
+    
+    ModuleConfig app{"app", "app_%Y%m%d.log", 1024 * 1024, std::chrono::minutes(60), 3, false};
+    app.sink_type = "text";
+    ModuleConfig audit{"audit", "audit_%Y%m%d.log", 1024 * 1024, std::chrono::minutes(60), 3, false};
+    audit.sink_type = "text";
+    ModuleConfig camera{"camera", "camera_%Y%m%d.bag", 1024 * 1024, std::chrono::minutes(60), 3, false};
+    camera.sink_type = "bag";
+    camera.topics = {"/camera/image"};
+    ModuleConfig other{"bag", "msg_%Y%m%d.bag", 1024 * 1024, std::chrono::minutes(60), 3, false};
+    config.modules = {app, audit, camera, other};
+    
+    logger::Logger::instance().init(config);
+    
+    LOG_INFO("ROUTE text line");
+    std::vector<uint8_t> payload = {0x01, 0x02};
+    logger::Logger::instance().message("/camera/image", "Image", payload);
+    logger::Logger::instance().message("/imu/data", "Imu", payload);
+    logger::Logger::instance().flush();
+    
+    std::string app_data = readModuleFiles("./test_logs_route/app");
+    std::string audit_data = readModuleFiles("./test_logs_route/audit");
+    std::string camera_data = readModuleFiles("./test_logs_route/camera");
+    std::string bag_data = readModuleFiles("./test_logs_route/bag");
+    
+    TEST_ASSERT(app_data.find("ROUTE text line") != std::string::npos &&
+                audit_data.find("ROUTE text line") != std::string::npos,
+                "同类型多个模块都收到条目");
+    TEST_ASSERT(camera_data.find("/camera/image") != std::string::npos &&
+                camera_data.find("/imu/data") == std::string::npos,
+                "专用 topic 定向到指定模块");
+    TEST_ASSERT(bag_data.find("/imu/data") != std::string::npos &&
+                bag_data.find("/camera/image") == std::string::npos,
+                "未认领的 topic 落到默认模块");
+    
+    auto round_trip = ModuleConfig::fromJson(camera.toJson());
+    TEST_ASSERT(round_trip.resolvedSinkType() == "bag" && round_trip.topics == camera.topics,
+                "sink_type/topics 配置往返");
+}
+
+// ============================================
+// 测试18: 批量写入在段边界处切分
+// ============================================
+void test_batch_write() {
+    TEST_CASE("Sink 批量写入");
+    
+    cleanupTestDir("./test_logs_batch");
+    cleanupTestDir("./test_logs_acct");
+    cleanupTestDir("./test_logs_flush");
+    cleanupTestDir("./test_logs_fd");
+    cleanupTestDir("./test_logs_uring");
+    cleanupTestDir("./test_logs_mmap");
+    cleanupTestDir("./test_logs_mmap_reconf");
+    cleanupTestDir("./test_logs_direct");
+    cleanupTestDir("./test_logs_cpool");
+    cleanupTestDir("./test_logs_codec");
+    cleanupTestDir("./test_logs_stream");
+    cleanupTestDir("./test_logs_pcomp");
+    cleanupTestDir("./test_logs_adapt");
+    cleanupTestDir("./test_logs_dict");
+    cleanupTestDir("./test_logs_manifest");
+    cleanupTestDir("./test_logs_budget");
+    cleanupTestDir("./test_logs_tier");
+    cleanupTestDir("./test_logs_tier_cold");
+    
+    const size_t kMaxBytes = 4096;
+    std::vector<std::string> lines;
+    for (int i = 0; i < 500; ++i) {
+        lines.push_back("BATCH line " + std::to_string(i) + " " + std::string(40, 'b'));
+    }
+    std::vector<TextRecord> text_records;
+    for (const auto& l : lines) text_records.push_back(TextRecord{l});
+    
+    std::vector<uint8_t> payload(100, 0x5A);
+    std::vector<MessageRecord> msg_records;
+    for (int i = 0; i < 200; ++i) {
+        msg_records.push_back(MessageRecord{"/batch/topic", "Blob", payload.data(), payload.size(),
+                                            static_cast<uint64_t>(i)});
+    }
+    
+    {
+        TextRollingFileSink text("./test_logs_batch", "text", "batch_%Y%m%d_%H%M%S_%03d.log",
+                                 kMaxBytes, std::chrono::minutes(60), 100, false);
+        BagSink bag("./test_logs_batch", "bag", "batch_%Y%m%d_%H%M%S_%03d.bag",
+                    kMaxBytes, std::chrono::minutes(60), 100, false);
+        // 一批跨越多个段
+        text.writeTextBatch({text_records.data(), text_records.size()});
+        bag.writeMessageBatch({msg_records.data(), msg_records.size()});
+    }
+    
+    size_t text_files = 0, bag_files = 0, total_lines = 0;
+    bool within_limit = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_batch")) {
+        if (!entry.is_regular_file()) continue;
+        if (fs::file_size(entry.path()) > kMaxBytes) within_limit = false;
+        if (entry.path().extension() == ".log") {
+            ++text_files;
+            std::ifstream ifs(entry.path());
+            std::string line;
+            while (std::getline(ifs, line)) {
+                if (line.rfind("BATCH line ", 0) == 0) ++total_lines;
+            }
+        } else if (entry.path().extension() == ".bag") {
+            ++bag_files;
+        }
+    }
+    
+    TEST_ASSERT(total_lines == lines.size(), "批量写入不丢行 (" + std::to_string(total_lines) + ")");
+    TEST_ASSERT(text_files > 1 && bag_files > 1, "批次在段边界处切分并轮转");
+    TEST_ASSERT(within_limit, "每个段不超过大小上限");
+}
+
+void test_write_accounting() {
+    TEST_CASE("内存段大小记账与磁盘预算");
+    
+    cleanupTestDir("./test_logs_acct");
+    
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100; ++i) {
+        lines.push_back("ACCT line " + std::to_string(i));
+    }
+    auto encode = [](const std::string& l, GatherBuffer& out) {
+        out.appendCopy(l.data(), l.size());
+        out.push_back('\n');
+    };
+    
+    fs::path first_path;
+    size_t counted = 0;
+    {
+        RollingFileManager mgr("./test_logs_acct", "acct_%Y%m%d_%H%M%S_%03d.log",
+                               1024 * 1024, std::chrono::minutes(60), 10, false);
+        GatherBuffer buf;
+        size_t n = mgr.writeBatch(lines.data(), lines.size(), buf, encode);
+        TEST_ASSERT(n == lines.size(), "批量写入全部记录");
+        
+        first_path = mgr.currentPath();
+        counted = mgr.currentBytes();
+        TEST_ASSERT(counted == fs::file_size(first_path), "内存计数与文件实际大小一致");
+        TEST_ASSERT(!mgr.needRotate(), "未达上限时不轮转");
+    }
+    {
+        // 续写已有段：计数从实际大小恢复
+        RollingFileManager mgr("./test_logs_acct", "acct_%Y%m%d_%H%M%S_%03d.log",
+                               1024 * 1024, std::chrono::minutes(60), 10, false);
+        TEST_ASSERT(mgr.currentPath() == first_path && mgr.currentBytes() == counted,
+                    "续写段时以实际大小初始化计数");
+    }
+    
+    DiskBudget budget("./test_logs_acct");
+    int64_t before = budget.available();
+    budget.consume(4096);
+    TEST_ASSERT(before > 0 && budget.available() == before - 4096, "写入只在缓存预算上扣减");
+    budget.refresh();
+    TEST_ASSERT(budget.available() > before - 4096 - 1024 * 1024, "重新采样纠正预算");
+    
+    // 空间持续不足时回收慢路径每个采样间隔最多执行一次
+    const fs::path guard_dir = "./test_logs_acct/guard";
+    fs::create_directories(guard_dir);
+    auto makeFiles = [&](int from) {
+        for (int i = from; i < from + 3; ++i) {
+            std::ofstream(guard_dir / ("g" + std::to_string(i) + ".log")) << "guard";
+        }
+    };
+    auto countFiles = [&] {
+        return static_cast<size_t>(std::distance(fs::directory_iterator(guard_dir), fs::directory_iterator{}));
+    };
+    DiskSpaceGuard guard(guard_dir, "", ".log", DiskPolicy{1ULL << 60, 1, 1});
+    makeFiles(0);
+    bool first = guard.ensureSoft();
+    TEST_ASSERT(!first && countFiles() == 1, "慢路径回收到最少保留数");
+    makeFiles(10);
+    bool second = guard.ensureSoft();
+    TEST_ASSERT(!second && countFiles() == 4, "间隔内不重复 statfs 与回收");
+    std::this_thread::sleep_for(DiskBudgetSampler::instance().interval() + std::chrono::milliseconds(50));
+    guard.ensureSoft();
+    TEST_ASSERT(countFiles() == 1, "间隔过后重新执行慢路径");
+}
+
+void test_flush_policy() {
+    TEST_CASE("文本模块刷新策略");
+    
+    cleanupTestDir("./test_logs_flush");
+    
+    std::string line = "FLUSH line " + std::string(50, 'f');
+    TextRecord info{line, LogLevel::INFO};
+    TextRecord error{line, LogLevel::ERROR};
+    
+    auto diskSize = [](const std::string& module) -> uintmax_t {
+        uintmax_t total = 0;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_flush")) {
+            if (isSegmentFile(entry) &&
+                entry.path().string().find("/" + module + "/") != std::string::npos) {
+                total += fs::file_size(entry.path());
+            }
+        }
+        return total;
+    };
+    
+    FlushPolicy never;
+    never.mode = FlushPolicy::Mode::Never;
+    never.level = LogLevel::ERROR;
+    {
+        TextRollingFileSink sink("./test_logs_flush", "never", "flush_%Y%m%d_%H%M%S_%03d.log",
+                                 1024 * 1024, std::chrono::minutes(60), 10, false, never);
+        for (int i = 0; i < 10; ++i) sink.writeTextBatch({&info, 1});
+        TEST_ASSERT(diskSize("never") == 0, "Never 模式下普通记录停留在用户态缓冲");
+        sink.writeTextBatch({&error, 1});
+        TEST_ASSERT(diskSize("never") == 11 * (line.size() + 1), "达到刷新级别的记录立即落盘");
+    }
+    
+    FlushPolicy bytes;
+    bytes.mode = FlushPolicy::Mode::Bytes;
+    bytes.every_bytes = 1024;
+    bytes.flush_on_level = false;
+    {
+        TextRollingFileSink sink("./test_logs_flush", "bytes", "flush_%Y%m%d_%H%M%S_%03d.log",
+                                 1024 * 1024, std::chrono::minutes(60), 10, false, bytes);
+        for (int i = 0; i < 10; ++i) sink.writeTextBatch({&error, 1});
+        TEST_ASSERT(diskSize("bytes") == 0, "未满字节阈值时不刷新");
+        for (int i = 0; i < 10; ++i) sink.writeTextBatch({&info, 1});
+        TEST_ASSERT(diskSize("bytes") >= 1024, "累计达到字节阈值后刷新");
+    }
+    
+    FlushPolicy interval;
+    interval.mode = FlushPolicy::Mode::Interval;
+    interval.interval = std::chrono::milliseconds(50);
+    {
+        TextRollingFileSink sink("./test_logs_flush", "interval", "flush_%Y%m%d_%H%M%S_%03d.log",
+                                 1024 * 1024, std::chrono::minutes(60), 10, false, interval);
+        sink.writeTextBatch({&info, 1});
+        sink.flushIfDue();
+        TEST_ASSERT(diskSize("interval") == 0, "未到时间间隔时不刷新");
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        sink.flushIfDue();
+        TEST_ASSERT(diskSize("interval") == line.size() + 1, "到期后空闲检查完成刷新");
+    }
+}
+
+void test_fd_backend() {
+    TEST_CASE("裸 fd 写出后端");
+    
+    cleanupTestDir("./test_logs_fd");
+    
+    // 大小负载混合：小负载进暂存区，大负载以 iovec 引用
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<BinaryRecord> records;
+    for (int i = 0; i < 300; ++i) {
+        payloads.emplace_back(i % 3 == 0 ? 4000 : 40, static_cast<uint8_t>(i));
+    }
+    for (int i = 0; i < 300; ++i) {
+        records.push_back(BinaryRecord{"fd_tag", payloads[i].data(), payloads[i].size(),
+                                       static_cast<uint64_t>(i)});
+    }
+    
+    {
+        BinaryRollingFileSink stream_sink("./test_logs_fd", "stream", "fd_%Y%m%d_%H%M%S_%03d.bin",
+                                          16 * 1024 * 1024, std::chrono::minutes(60), 10, false);
+        BinaryRollingFileSink fd_sink("./test_logs_fd", "fd", "fd_%Y%m%d_%H%M%S_%03d.bin",
+                                      16 * 1024 * 1024, std::chrono::minutes(60), 10, false,
+                                      IoBackend::Fd);
+        for (size_t i = 0; i < records.size(); i += 50) {
+            stream_sink.writeBinaryBatch({records.data() + i, 50});
+            fd_sink.writeBinaryBatch({records.data() + i, 50});
+        }
+        fd_sink.writeBinary(payloads[1].data(), payloads[1].size(), "single", 999);
+        stream_sink.writeBinary(payloads[1].data(), payloads[1].size(), "single", 999);
+    }
+    
+    auto readModule = [](const std::string& module) {
+        std::string bytes;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_fd")) {
+            if (isSegmentFile(entry) &&
+                entry.path().string().find("/" + module + "/") != std::string::npos) {
+                std::ifstream ifs(entry.path(), std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            }
+        }
+        return bytes;
+    };
+    std::string stream_bytes = readModule("stream");
+    std::string fd_bytes = readModule("fd");
+    TEST_ASSERT(!fd_bytes.empty() && fd_bytes == stream_bytes, "fd 后端输出与流后端逐字节一致");
+    
+    // 文本：暂存区攒批，关闭时写出
+    FlushPolicy never;
+    never.mode = FlushPolicy::Mode::Never;
+    never.flush_on_level = false;
+    std::string line = "FD text line";
+    {
+        TextRollingFileSink text("./test_logs_fd", "text", "fd_%Y%m%d_%H%M%S_%03d.log",
+                                 1024 * 1024, std::chrono::minutes(60), 10, false, never,
+                                 IoBackend::Fd);
+        for (int i = 0; i < 100; ++i) text.writeText(line);
+        TEST_ASSERT(readModule("text").empty(), "未刷新的文本停留在页对齐暂存区");
+    }
+    TEST_ASSERT(countLinesContaining("./test_logs_fd", line) == 100, "析构时暂存区完整写出");
+}
+
+void test_uring_backend() {
+    TEST_CASE("io_uring 写出后端");
+    
+    cleanupTestDir("./test_logs_uring");
+    
+    // 总量超过全部缓冲之和，覆盖缓冲在途回收
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<BinaryRecord> records;
+    for (int i = 0; i < 2000; ++i) {
+        payloads.emplace_back(i % 4 == 0 ? 3000 : 100, static_cast<uint8_t>(i));
+    }
+    for (int i = 0; i < 2000; ++i) {
+        records.push_back(BinaryRecord{"uring", payloads[i].data(), payloads[i].size(),
+                                       static_cast<uint64_t>(i)});
+    }
+    {
+        BinaryRollingFileSink stream_sink("./test_logs_uring", "stream", "u_%Y%m%d_%H%M%S_%03d.bin",
+                                          64 * 1024 * 1024, std::chrono::minutes(60), 10, false);
+        BinaryRollingFileSink uring_sink("./test_logs_uring", "uring", "u_%Y%m%d_%H%M%S_%03d.bin",
+                                         64 * 1024 * 1024, std::chrono::minutes(60), 10, false,
+                                         IoBackend::Uring);
+        for (size_t i = 0; i < records.size(); i += 100) {
+            stream_sink.writeBinaryBatch({records.data() + i, 100});
+            uring_sink.writeBinaryBatch({records.data() + i, 100});
+        }
+        uring_sink.flush();
+    }
+    
+    auto readModule = [](const std::string& module) {
+        std::string bytes;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_uring")) {
+            if (isSegmentFile(entry) &&
+                entry.path().string().find("/" + module + "/") != std::string::npos) {
+                std::ifstream ifs(entry.path(), std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            }
+        }
+        return bytes;
+    };
+    std::string stream_bytes = readModule("stream");
+    TEST_ASSERT(!stream_bytes.empty() && readModule("uring") == stream_bytes,
+                "uring 后端输出与流后端逐字节一致");
+    
+    // 轮转时旧段异步关闭，持久化模式链接 fdatasync
+    FlushPolicy durable;
+    durable.sync = true;
+    const size_t kMaxBytes = 8 * 1024;
+    std::vector<std::string> lines;
+    for (int i = 0; i < 1000; ++i) {
+        lines.push_back("URING line " + std::to_string(i) + " " + std::string(30, 'u'));
+    }
+    std::vector<TextRecord> text_records;
+    for (const auto& l : lines) text_records.push_back(TextRecord{l});
+    {
+        TextRollingFileSink text("./test_logs_uring", "text", "u_%Y%m%d_%H%M%S_%03d.log",
+                                 kMaxBytes, std::chrono::minutes(60), 1000, false, durable,
+                                 IoBackend::Uring);
+        for (size_t i = 0; i < text_records.size(); i += 25) {
+            text.writeTextBatch({text_records.data() + i, 25});
+        }
+    }
+    size_t segments = 0;
+    bool within_limit = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_uring")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".log") {
+            ++segments;
+            if (fs::file_size(entry.path()) > kMaxBytes) within_limit = false;
+        }
+    }
+    TEST_ASSERT(countLinesContaining("./test_logs_uring", "URING line ") == lines.size(),
+                "跨段异步写入不丢行");
+    TEST_ASSERT(segments > 1 && within_limit, "按内存计数轮转，段不超过上限");
+}
+
+void test_mmap_segment() {
+    TEST_CASE("映射段多生产者直接写入");
+    
+    cleanupTestDir("./test_logs_mmap");
+    fs::create_directories("./test_logs_mmap");
+    
+    // 未提交的记录被读者跳过；关闭时截断到已用长度
+    const fs::path seg_path = "./test_logs_mmap/raw.seg";
+    {
+        MappedSegment seg;
+        TEST_ASSERT(seg.open(seg_path, 64 * 1024), "预分配并映射段");
+        TEST_ASSERT(fs::file_size(seg_path) == 64 * 1024, "段按容量预分配");
+        auto a = seg.reserve(10);
+        auto b = seg.reserve(20);
+        std::memset(a.data, 'a', 10);
+        std::memset(b.data, 'b', 20);
+        seg.commit(b);
+        
+        size_t seen = 0, skipped = 0;
+        MappedSegment::forEachRecord(seg_path, [&](const uint8_t* p, size_t n) {
+            seen += (n == 20 && p[0] == 'b') ? 1 : 0;
+        }, &skipped);
+        TEST_ASSERT(seen == 1 && skipped == 1, "读者跳过未提交的记录");
+        
+        seg.commit(a);
+        seg.seal();
+        seg.close();
+    }
+    TEST_ASSERT(fs::file_size(seg_path) == MappedSegment::kFileHeaderBytes +
+                MappedSegment::frameBytes(10) + MappedSegment::frameBytes(20),
+                "关闭时截断到已用长度");
+    
+    // 多线程直接写入 Sink，段满时由写入线程轮转
+    const size_t kMaxBytes = 64 * 1024;
+    const int kThreads = 4;
+    const int kPerThread = 2000;
+    {
+        BinaryRollingFileSink sink("./test_logs_mmap", "sink", "m_%Y%m%d_%H%M%S_%03d.bin",
+                                   kMaxBytes, std::chrono::minutes(60), 1000, false,
+                                   IoBackend::Mmap);
+        TEST_ASSERT(sink.appendsConcurrently(), "映射段模式允许并发直接写入");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&sink, t] {
+                std::vector<uint8_t> payload(40 + t * 10);
+                for (int i = 0; i < kPerThread; ++i) {
+                    std::memset(payload.data(), t, payload.size());
+                    std::memcpy(payload.data(), &i, sizeof(i));
+                    sink.writeBinary(payload.data(), payload.size(), "mm" + std::to_string(t),
+                                     static_cast<uint64_t>(i));
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        TEST_ASSERT(sink.droppedRecords() == 0, "无记录被丢弃");
+    }
+    
+    std::vector<std::vector<bool>> got(kThreads, std::vector<bool>(kPerThread, false));
+    size_t segments = 0, records = 0;
+    bool intact = true, truncated = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_mmap")) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".bin") continue;
+        ++segments;
+        size_t used = MappedSegment::kFileHeaderBytes;
+        MappedSegment::forEachRecord(entry.path(), [&](const uint8_t* p, size_t n) {
+            ++records;
+            used += MappedSegment::frameBytes(n);
+            // u64 ts | u32 tag_len | tag | u32 data_len | data
+            uint32_t tag_len, data_len;
+            std::memcpy(&tag_len, p + 8, 4);
+            std::memcpy(&data_len, p + 12 + tag_len, 4);
+            int t = p[12 + 2] - '0';
+            const uint8_t* data = p + 16 + tag_len;
+            int i;
+            std::memcpy(&i, data, sizeof(i));
+            if (n != 16 + tag_len + data_len || t < 0 || t >= kThreads || i < 0 ||
+                i >= kPerThread || data_len != static_cast<uint32_t>(40 + t * 10) ||
+                data[data_len - 1] != t) {
+                intact = false;
+                return;
+            }
+            got[t][i] = true;
+        });
+        if (fs::file_size(entry.path()) != used) truncated = false;
+    }
+    bool complete = true;
+    for (const auto& v : got) {
+        complete = complete && std::all_of(v.begin(), v.end(), [](bool b) { return b; });
+    }
+    TEST_ASSERT(intact && records == static_cast<size_t>(kThreads * kPerThread) && complete,
+                "并发写入的记录完整且不重不漏");
+    TEST_ASSERT(segments > 1 && truncated, "段满轮转，旧段截断到已用长度");
+    
+    auto segmentDir = [](const fs::path& root) {
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            if (isSegmentFile(entry)) return entry.path().parent_path();
+        }
+        return fs::path{};
+    };
+    {
+        SegmentManifest manifest(segmentDir("./test_logs_mmap/sink"), ".bin");
+        uint64_t counted = 0;
+        bool nonzero = true;
+        for (const auto& seg : manifest.segments()) {
+            counted += seg.records;
+            nonzero = nonzero && seg.records > 0;
+        }
+        TEST_ASSERT(counted == static_cast<uint64_t>(kThreads * kPerThread) && nonzero,
+                    "段目录记下映射段的记录数");
+    }
+    
+    // 同步写入（无空闲回调）也按段龄轮转；管理器不另持段文件的句柄
+    {
+        BinaryRollingFileSink sink("./test_logs_mmap", "aged", "a_%Y%m%d_%H%M%S_%03d.bin",
+                                   kMaxBytes, std::chrono::minutes(0), 1000, false,
+                                   IoBackend::Mmap);
+        size_t handles = 0;
+        for (const auto& fd : fs::directory_iterator("/proc/self/fd")) {
+            std::error_code ec;
+            auto target = fs::read_symlink(fd.path(), ec);
+            if (!ec && target.string().find("/test_logs_mmap/aged/") != std::string::npos &&
+                target.extension() == ".bin") {
+                ++handles;
+            }
+        }
+        TEST_ASSERT(handles == 1, "映射段只有一个文件句柄 (" + std::to_string(handles) + ")");
+        uint8_t one = 1;
+        for (int i = 0; i < 3; ++i) {
+            sink.writeBinary(&one, sizeof(one), "aged", static_cast<uint64_t>(i));
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        }
+    }
+    size_t aged_segments = 0, aged_records = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_mmap/aged")) {
+        if (!isSegmentFile(entry)) continue;
+        ++aged_segments;
+        MappedSegment::forEachRecord(entry.path(), [&](const uint8_t*, size_t) { ++aged_records; });
+    }
+    TEST_ASSERT(aged_segments == 3 && aged_records == 3,
+                "写入路径按段龄轮转 (" + std::to_string(aged_segments) + " 段)");
+    
+    // 经 Logger 写入：生产者线程直接落入映射段，不经工作线程
+    LoggerConfig config;
+    config.base_dir = "./test_logs_mmap";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = true;
+    ModuleConfig module{"binary", "lg_%Y%m%d_%H%M%S_%03d.bin",
+                        1024 * 1024, std::chrono::minutes(60), 3, false};
+    module.io_backend = IoBackend::Mmap;
+    config.modules.push_back(module);
+    logger::Logger::instance().init(config);
+    
+    uint8_t data[] = {0x11, 0x22, 0x33, 0x44};
+    for (int i = 0; i < 100; ++i) {
+        logger::Logger::instance().binary(data, sizeof(data), "direct");
+    }
+    size_t direct = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_mmap")) {
+        if (entry.is_regular_file() && entry.path().string().find("/binary/") != std::string::npos) {
+            MappedSegment::forEachRecord(entry.path(), [&](const uint8_t*, size_t) { ++direct; });
+        }
+    }
+    TEST_ASSERT(direct == 100, "binary() 返回时记录已在映射段中可见");
+    
+    // 生产者直写期间反复重配置：旧 Sink 须在所有直写线程离开后才释放
+    cleanupTestDir("./test_logs_mmap_reconf");
+    config.base_dir = "./test_logs_mmap_reconf";
+    logger::Logger::instance().init(config);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&data] {
+            for (int i = 0; i < kPerThread; ++i) {
+                logger::Logger::instance().binary(data, sizeof(data), "reconf");
+            }
+        });
+    }
+    for (int round = 0; round < 5; ++round) {
+        logger::Logger::instance().init(config);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    for (auto& th : writers) th.join();
+    size_t written = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_mmap_reconf")) {
+        if (isSegmentFile(entry)) {
+            MappedSegment::forEachRecord(entry.path(), [&](const uint8_t*, size_t) { ++written; });
+        }
+    }
+    TEST_ASSERT(written == static_cast<size_t>(kThreads * kPerThread),
+                "重配置期间直写记录不丢失 (" + std::to_string(written) + ")");
+}
+
+void test_direct_backend() {
+    TEST_CASE("O_DIRECT 对齐写出后端");
+    
+    cleanupTestDir("./test_logs_direct");
+    
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<BinaryRecord> records;
+    for (int i = 0; i < 600; ++i) {
+        payloads.emplace_back(i % 5 == 0 ? 5000 : 70, static_cast<uint8_t>(i));
+    }
+    for (int i = 0; i < 600; ++i) {
+        records.push_back(BinaryRecord{"direct", payloads[i].data(), payloads[i].size(),
+                                       static_cast<uint64_t>(i)});
+    }
+    
+    // 中途 flush（尾块补零后截回）、析构、再续写（尾块读回重写），输出须与流后端一致
+    auto writeRange = [&](size_t begin, size_t end, bool flush_between) {
+        BinaryRollingFileSink stream_sink("./test_logs_direct", "stream", "d_%Y%m%d_%H%M%S_%03d.bin",
+                                          64 * 1024 * 1024, std::chrono::minutes(60), 10, false);
+        BinaryRollingFileSink direct_sink("./test_logs_direct", "direct", "d_%Y%m%d_%H%M%S_%03d.bin",
+                                          64 * 1024 * 1024, std::chrono::minutes(60), 10, false,
+                                          IoBackend::Direct);
+        for (size_t i = begin; i < end; i += 20) {
+            stream_sink.writeBinaryBatch({records.data() + i, 20});
+            direct_sink.writeBinaryBatch({records.data() + i, 20});
+            if (flush_between && i == begin + 100) {
+                direct_sink.flush();
+            }
+        }
+    };
+    writeRange(0, 300, true);
+    writeRange(300, 600, false);
+    
+    auto readModule = [](const std::string& module) {
+        std::string bytes;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_direct")) {
+            if (isSegmentFile(entry) &&
+                entry.path().string().find("/" + module + "/") != std::string::npos) {
+                std::ifstream ifs(entry.path(), std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            }
+        }
+        return bytes;
+    };
+    std::string stream_bytes = readModule("stream");
+    TEST_ASSERT(!stream_bytes.empty() && readModule("direct") == stream_bytes,
+                "直写输出（含续写与尾块）与流后端逐字节一致");
+    
+    // 轮转下来的段不留在页缓存
+    const size_t kMaxBytes = 64 * 1024;
+    {
+        BinaryRollingFileSink sink("./test_logs_direct", "rotated", "d_%Y%m%d_%H%M%S_%03d.bin",
+                                   kMaxBytes, std::chrono::minutes(60), 100, false,
+                                   IoBackend::Direct);
+        for (size_t i = 0; i < records.size(); i += 20) {
+            sink.writeBinaryBatch({records.data() + i, 20});
+        }
+    }
+    std::vector<fs::path> segments;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_direct")) {
+        if (isSegmentFile(entry) &&
+            entry.path().string().find("/rotated/") != std::string::npos) {
+            segments.push_back(entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    size_t resident = 0;
+    bool within_limit = true;
+    for (size_t k = 0; k + 1 < segments.size(); ++k) {  // 最后一段是析构时关闭的当前段
+        size_t size = fs::file_size(segments[k]);
+        if (size > kMaxBytes) within_limit = false;
+        int fd = ::open(segments[k].c_str(), O_RDONLY);
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        std::vector<unsigned char> pages((size + 4095) / 4096);
+        if (p != MAP_FAILED && ::mincore(p, size, pages.data()) == 0) {
+            for (unsigned char c : pages) resident += c & 1;
+        }
+        if (p != MAP_FAILED) ::munmap(p, size);
+        ::close(fd);
+    }
+    TEST_ASSERT(segments.size() > 2 && within_limit, "直写模式按大小轮转");
+    TEST_ASSERT(resident == 0, "轮转后的段已移出页缓存");
+    
+    ModuleConfig bag{"bag", "b_%Y%m%d.bag", 1024 * 1024, std::chrono::minutes(60), 3, false};
+    bag.io_backend = IoBackend::Direct;
+    TEST_ASSERT(ModuleConfig::fromJson(bag.toJson()).io_backend == IoBackend::Direct,
+                "io_backend \"direct\" 配置往返");
+}
+
+// 压缩前阻塞到放行，用于观察正在压缩的段
+class GatedCompressionStrategy : public ICompressionStrategy {
+public:
+    std::atomic<bool> open{false};
+    std::atomic<int> started{0};
+    
+    bool compress(const fs::path& src) override {
+        ++started;
+        while (!open.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::error_code ec;
+        fs::rename(src, src.string() + compressedExtension(), ec);
+        return !ec;
+    }
+    std::string compressedExtension() const override { return ".z"; }
+};
+
+void test_compression_pool() {
+    TEST_CASE("后台压缩线程池");
+    
+    cleanupTestDir("./test_logs_cpool");
+    
+    // 轮转只入队；压缩完成后段全部变为 .gz，内容完整
+    const size_t kMaxBytes = 4096;
+    std::vector<std::string> lines;
+    for (int i = 0; i < 400; ++i) {
+        lines.push_back("CPOOL line " + std::to_string(i) + " " + std::string(40, 'c'));
+    }
+    std::vector<TextRecord> text_records;
+    for (const auto& l : lines) text_records.push_back(TextRecord{l});
+    {
+        TextRollingFileSink sink("./test_logs_cpool", "text", "c_%Y%m%d_%H%M%S_%03d.log",
+                                 kMaxBytes, std::chrono::minutes(60), 1000, true);
+        for (size_t i = 0; i < text_records.size(); i += 20) {
+            sink.writeTextBatch({text_records.data() + i, 20});
+        }
+    }
+    CompressionPool::instance().waitIdle();
+    
+    size_t gz = 0, tmp = 0, gz_lines = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_cpool")) {
+        if (!entry.is_regular_file()) continue;
+        if (entry.path().extension() == ".tmp") ++tmp;
+        if (entry.path().extension() != ".gz") continue;
+        ++gz;
+        gzFile in = gzopen(entry.path().c_str(), "rb");
+        char buf[4096];
+        int n;
+        while ((n = gzread(in, buf, sizeof(buf))) > 0) {
+            gz_lines += static_cast<size_t>(std::count(buf, buf + n, '\n'));
+        }
+        gzclose(in);
+    }
+    TEST_ASSERT(gz > 1 && tmp == 0, "轮转下来的段由后台线程压缩，无临时文件残留");
+    TEST_ASSERT(gz_lines + countLinesContaining("./test_logs_cpool", "CPOOL line ") == lines.size(),
+                "压缩后内容完整");
+    
+    // 启动时清理临时文件并重新压缩上次遗留的段
+    fs::path module_dir;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_cpool")) {
+        if (entry.path().extension() == ".gz") module_dir = entry.path().parent_path();
+    }
+    std::ofstream(module_dir / "c_leftover.log") << "LEFTOVER line\n";
+    std::ofstream(module_dir / "c_crashed.log.gz.tmp") << "partial";
+    fs::last_write_time(module_dir / "c_leftover.log",
+                        fs::file_time_type::clock::now() - std::chrono::hours(1));
+    {
+        TextRollingFileSink sink("./test_logs_cpool", "text", "c_%Y%m%d_%H%M%S_%03d.log",
+                                 kMaxBytes, std::chrono::minutes(60), 1000, true);
+    }
+    CompressionPool::instance().waitIdle();
+    TEST_ASSERT(!fs::exists(module_dir / "c_crashed.log.gz.tmp"), "启动时删除残留的压缩临时文件");
+    TEST_ASSERT(!fs::exists(module_dir / "c_leftover.log") &&
+                fs::exists(module_dir / "c_leftover.log.gz"), "启动时重新压缩遗留的段");
+    
+    // 正在压缩的段不被保留数量清理删除
+    auto gated = std::make_shared<GatedCompressionStrategy>();
+    {
+        RollingFileManager::Config cfg;
+        cfg.base_dir = "./test_logs_cpool/gated";
+        cfg.pattern = "g_%Y%m%d_%H%M%S_%03d.log";
+        cfg.max_bytes = 1024;
+        cfg.max_age = std::chrono::minutes(60);
+        cfg.reserve_n = 1;
+        cfg.compress_old = true;
+        cfg.compression_strategy = gated;
+        RollingFileManager mgr(cfg);
+        mgr.append("first\n", 6);
+        mgr.rotate();
+        while (gated->started.load() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        mgr.append("second\n", 7);
+        mgr.rotate();
+        TEST_ASSERT(CompressionPool::instance().pending() == 2, "两个段排队/正在压缩");
+        gated->open = true;
+    }
+    CompressionPool::instance().waitIdle();
+    size_t packed = 0;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_cpool/gated")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".z") ++packed;
+    }
+    TEST_ASSERT(packed == 2, "保留数量清理跳过正在压缩的段");
+}
+
+// ============================================
+// 测试: zstd / LZ4 压缩策略与按模块选择编解码器
+// ============================================
+// 编解码器是否编译进来（缺少压缩库时退回 gzip）
+bool codecBuiltIn(CompressionCodec codec) {
+    return codec == CompressionCodec::Gzip ||
+           makeCompressionStrategy(codec)->compressedExtension() != ".gz";
+}
+
+void test_compression_codecs() {
+    TEST_CASE("压缩编解码器");
+    
+    cleanupTestDir("./test_logs_codec");
+    
+    std::vector<std::string> lines;
+    for (int i = 0; i < 400; ++i) {
+        lines.push_back("CODEC line " + std::to_string(i) + " " + std::string(40, 'z'));
+    }
+    std::vector<TextRecord> records;
+    for (const auto& l : lines) records.push_back(TextRecord{l});
+    
+    // 每种编解码器轮转出若干段，压缩产物经 readSegmentFile 还原后内容完整
+    struct Case { std::string name; std::shared_ptr<ICompressionStrategy> strategy; std::string ext; };
+    std::vector<Case> cases{
+        {"gzip", makeCompressionStrategy(CompressionCodec::Gzip), ".gz"},
+        {"zstd", makeCompressionStrategy(CompressionCodec::Zstd, 3, 2), ".zst"},
+        {"lz4", makeCompressionStrategy(CompressionCodec::Lz4), ".lz4"},
+    };
+    for (const auto& c : cases) {
+        if (c.strategy->compressedExtension() != c.ext) {
+            std::cout << "  ⚠️ " << c.name << " 未编译进来，退回 gzip，跳过" << std::endl;
+            continue;
+        }
+        fs::path dir = "./test_logs_codec/" + c.name;
+        {
+            TextRollingFileSink sink(dir, "text", "k_%Y%m%d_%H%M%S_%03d.log",
+                                     4096, std::chrono::minutes(60), 1000, true,
+                                     FlushPolicy{}, IoBackend::Stream, c.strategy);
+            for (size_t i = 0; i < records.size(); i += 20) {
+                sink.writeTextBatch({records.data() + i, 20});
+            }
+        }
+        CompressionPool::instance().waitIdle();
+        
+        // LZ4 字面量会原样出现在压缩文件里，这里只按扩展名逐个还原计数
+        size_t packed = 0, total_lines = 0;
+        bool ok = true;
+        for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+            if (!entry.is_regular_file()) continue;
+            const auto ext = entry.path().extension();
+            if (ext != c.ext && ext != ".log") continue;
+            if (ext == c.ext) ++packed;
+            std::string data;
+            ok = readSegmentFile(entry.path(), data) && ok;
+            total_lines += static_cast<size_t>(std::count(data.begin(), data.end(), '\n'));
+        }
+        TEST_ASSERT(packed > 1 && ok, c.name + " 段压缩为 " + c.ext + " 且可解压");
+        TEST_ASSERT(total_lines == records.size(),
+                    c.name + " 解压后内容完整");
+    }
+    
+    // 按模块配置选择编解码器，JSON 往返保持一致
+    ModuleConfig mod = ModuleConfig::fromJson(json{
+        {"name", "compact"}, {"pattern", "k_%Y%m%d_%H%M%S_%03d.clog"},
+        {"compression_codec", "zstd"}, {"compression_level", 5}, {"compression_workers", 1}});
+    ModuleConfig back = ModuleConfig::fromJson(mod.toJson());
+    TEST_ASSERT(back.compression_codec == CompressionCodec::Zstd && back.compression_level == 5 &&
+                back.compression_workers == 1, "编解码器配置 JSON 往返");
+    if (!codecBuiltIn(CompressionCodec::Zstd)) return;
+    
+    // 紧凑段压缩为 .zst 后仍可直接解码
+    LoggerConfig config;
+    config.base_dir = "./test_logs_codec/compact";
+    config.log_level = LogLevel::INFO;
+    config.async_mode = false;
+    config.compact_text = true;
+    mod.max_bytes = 2048;
+    config.modules.push_back(mod);
+    logger::Logger::instance().init(config);
+    for (int i = 0; i < 300; ++i) {
+        LOG_INFO_FMT("CODEC compact seq={} {}", i, std::string(20, 'q'));
+    }
+    logger::Logger::instance().flush();
+    CompressionPool::instance().waitIdle();
+    
+    size_t zst = 0, decoded = 0;
+    bool ok = true;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_codec/compact")) {
+        const auto ext = entry.path().extension();
+        if (ext == ".zst") ++zst;
+        if (ext != ".zst" && ext != ".clog") continue;
+        ok = CompactLogReader::decodeFile(entry.path(), [&](const std::string& line) {
+            if (line.find("CODEC compact seq=") != std::string::npos) ++decoded;
+        }) && ok;
+    }
+    TEST_ASSERT(zst > 1 && ok && decoded == 300,
+                "紧凑段按模块配置压缩为 .zst 并可解码 (" + std::to_string(decoded) + " 行)");
+}
+
+// ============================================
+// 测试: 边写边压缩（带帧索引的可定位压缩段）
+// ============================================
+void test_stream_compression() {
+    TEST_CASE("边写边压缩");
+    
+    cleanupTestDir("./test_logs_stream");
+    
+    std::vector<std::string> lines;
+    for (int i = 0; i < 600; ++i) {
+        lines.push_back("STREAM line " + std::to_string(i) + " " + std::string(40, 's'));
+    }
+    std::vector<TextRecord> records;
+    for (const auto& l : lines) records.push_back(TextRecord{l});
+    
+    FlushPolicy lazy;
+    lazy.mode = FlushPolicy::Mode::Never;
+    
+    // 段在写入时即为压缩文件，轮转不经过压缩线程池；索引覆盖段内全部数据
+    for (auto codec : {CompressionCodec::Gzip, CompressionCodec::Zstd, CompressionCodec::Lz4}) {
+        if (!codecBuiltIn(codec)) continue;
+        auto strategy = makeCompressionStrategy(codec, 0, 0, 2048);
+        const std::string ext = strategy->compressedExtension();
+        fs::path dir = "./test_logs_stream/" + ext.substr(1);
+        {
+            TextRollingFileSink sink(dir, "text", "s_%Y%m%d_%H%M%S_%03d.log",
+                                     16 * 1024, std::chrono::minutes(60), 1000, true,
+                                     lazy, IoBackend::Fd, strategy);
+            for (size_t i = 0; i < records.size(); i += 10) {
+                sink.writeTextBatch({records.data() + i, 10});
+            }
+            TEST_ASSERT(CompressionPool::instance().pending() == 0, ext + " 轮转不再二次压缩");
+        }
+        
+        size_t segments = 0, plain = 0, frames = 0, total_lines = 0;
+        bool indexed = true, ok = true;
+        fs::path seg_dir;
+        for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+            if (!isSegmentFile(entry)) continue;
+            if (entry.path().extension() != ext) {
+                ++plain;
+                continue;
+            }
+            ++segments;
+            seg_dir = entry.path().parent_path();
+            FramedSegmentReader reader;
+            indexed = reader.open(entry.path()) && !reader.frames().empty() && indexed;
+            frames += reader.frames().size();
+            std::string data;
+            ok = readSegmentFile(entry.path(), data) && ok;
+            size_t raw = 0;
+            for (const auto& f : reader.frames()) raw += f.raw_size;
+            indexed = indexed && raw == data.size();
+            std::string last;
+            ok = reader.readFrame(reader.frames().size() - 1, last) && ok;
+            indexed = indexed && data.size() >= last.size() &&
+                      data.compare(data.size() - last.size(), last.size(), last) == 0;
+            total_lines += static_cast<size_t>(std::count(data.begin(), data.end(), '\n'));
+        }
+        TEST_ASSERT(segments > 1 && plain == 0, ext + " 段直接以压缩文件写出");
+        TEST_ASSERT(indexed && ok && frames > segments, ext + " 帧索引完整，可单独解压任意帧");
+        TEST_ASSERT(total_lines == lines.size(), ext + " 标准顺序解压得到全部内容");
+        
+        // 配额按段目录中的大小计算，必须是压缩后的磁盘大小
+        SegmentManifest manifest(seg_dir, ".log");
+        size_t sized = 0;
+        bool on_disk = true;
+        for (const auto& seg : manifest.segments()) {
+            std::error_code ec;
+            auto size = fs::file_size(seg_dir / seg.fileName(), ec);
+            on_disk = on_disk && !ec && seg.bytes == size;
+            ++sized;
+        }
+        TEST_ASSERT(sized == segments && on_disk, ext + " 段目录记录压缩后的磁盘大小");
+    }
+    
+    // 按策略逐批刷新（binary 模块默认 Always）不逐批结束帧
+    {
+        auto strategy = makeCompressionStrategy(CompressionCodec::Gzip, 0, 0, 2048);
+        std::vector<uint8_t> payload(100, 'b');
+        {
+            BinaryRollingFileSink sink("./test_logs_stream/always", "bin", "b_%Y%m%d_%H%M%S_%03d.bin",
+                                       64 * 1024, std::chrono::minutes(60), 1000, true,
+                                       IoBackend::Fd, strategy);
+            for (int i = 0; i < 600; ++i) {
+                sink.writeBinary(payload.data(), payload.size(), "always", static_cast<uint64_t>(i));
+            }
+        }
+        size_t frames = 0, raw = 0;
+        for (const auto& entry : fs::recursive_directory_iterator("./test_logs_stream/always")) {
+            if (!isSegmentFile(entry)) continue;
+            FramedSegmentReader reader;
+            if (!reader.open(entry.path())) continue;
+            frames += reader.frames().size();
+            for (const auto& f : reader.frames()) raw += f.raw_size;
+        }
+        TEST_ASSERT(raw > 0 && frames <= raw / 2048 + 2,
+                    "逐批刷新时帧仍按帧大小切分 (" + std::to_string(frames) + " 帧)");
+    }
+    
+    // gzip 脚注放不下全部帧时合并索引项，脚注不丢
+    {
+        const fs::path path = "./test_logs_stream/many_frames.gz";
+        FramedSegmentWriter writer(makeSegmentWriter(IoBackend::Fd),
+                                   makeCompressionStrategy(CompressionCodec::Gzip, 0, 0, 2048)
+                                       ->makeFrameEncoder());
+        writer.open(path);
+        std::string expect;
+        for (int i = 0; i < 3000; ++i) {
+            std::string line = "frame " + std::to_string(i) + "\n";
+            writer.write(line.data(), line.size());
+            writer.flush();
+            expect += line;
+        }
+        writer.close();
+        FramedSegmentReader reader;
+        std::string first, all;
+        bool opened = reader.open(path);
+        size_t raw = 0;
+        for (const auto& f : reader.frames()) raw += f.raw_size;
+        bool read = opened && reader.readFrame(0, first) && readSegmentFile(path, all);
+        TEST_ASSERT(opened && reader.frames().size() < 3000 && raw == expect.size() && read &&
+                    expect.compare(0, first.size(), first) == 0 && all == expect,
+                    "gzip 帧过多时合并索引项 (" + std::to_string(reader.frames().size()) + " 项)");
+    }
+    
+    // 按时间窗只解压相关的帧
+    const auto range_codec = codecBuiltIn(CompressionCodec::Zstd) ? CompressionCodec::Zstd
+                                                                  : CompressionCodec::Gzip;
+    std::vector<std::string> early(50, "STREAM early " + std::string(60, 'e'));
+    std::vector<std::string> late(50, "STREAM late " + std::string(60, 'l'));
+    std::vector<TextRecord> early_records, late_records;
+    for (const auto& l : early) early_records.push_back(TextRecord{l});
+    for (const auto& l : late) late_records.push_back(TextRecord{l});
+    std::chrono::system_clock::time_point mid;
+    {
+        TextRollingFileSink sink("./test_logs_stream/range", "text", "r_%Y%m%d_%H%M%S_%03d.log",
+                                 1024 * 1024, std::chrono::minutes(60), 10, true, lazy,
+                                 IoBackend::Stream,
+                                 makeCompressionStrategy(range_codec, 0, 0, 64 * 1024));
+        for (int round = 0; round < 4; ++round) {
+            sink.writeTextBatch({early_records.data(), early_records.size()});
+            sink.flush();   // 刷新结束当前帧
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        mid = std::chrono::system_clock::now();
+        for (int round = 0; round < 2; ++round) {
+            sink.writeTextBatch({late_records.data(), late_records.size()});
+            sink.flush();
+        }
+    }
+    std::string window;
+    FramedSegmentReader reader;
+    for (const auto& entry : fs::recursive_directory_iterator("./test_logs_stream/range")) {
+        if (isSegmentFile(entry) && entry.path().extension() != ".log") {
+            reader.open(entry.path());
+        }
+    }
+    bool ranged = reader.frames().size() == 6 &&
+                  reader.readRange(mid, std::chrono::system_clock::now(), window);
+    TEST_ASSERT(ranged && window.find("STREAM early") == std::string::npos &&
+                static_cast<size_t>(std::count(window.begin(), window.end(), '\n')) == 2 * late.size(),
+                "按时间窗只解压覆盖该时段的帧");
+    
+    // 模块配置 JSON 往返
+    ModuleConfig mod = ModuleConfig::fromJson(json{{"compress_stream", true}, {"compress_frame_kb", 512}});
+    ModuleConfig back = ModuleConfig::fromJson(mod.toJson());
+    TEST_ASSERT(back.compress_stream && back.compress_frame_kb == 512, "边写边压缩配置 JSON 往返");
+}
+
+// ============================================
+// 测试: 大段按块并行压缩
+// ============================================
+size_t countGzipMembers(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    z_stream zs{};
+    inflateInit2(&zs, 15 + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(&packed[0]);
+    zs.avail_in = static_cast<uInt>(packed.size());
+    size_t members = 0;
+    char buf[1 << 16];
+    while (zs.avail_in > 0) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        int rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc == Z_STREAM_END) {
+            ++members;
+            inflateReset(&zs);
+        } else if (rc != Z_OK) {
+            break;
+        }
+    }
+    inflateEnd(&zs);
+    return members;
+}
+
+void test_parallel_compression() {
+    TEST_CASE("按块并行压缩");
+    
+    cleanupTestDir("./test_logs_pcomp");
+    fs::create_directories("./test_logs_pcomp");
+    
+    // 约 12 MB，跨多个 4 MiB 块
+    const size_t kBlock = 4 * 1024 * 1024;
+    std::string original;
+    for (int i = 0; i < 250000; ++i) {
+        original += "PCOMP seq=" + std::to_string(i) + " value=" + std::to_string(i * 7919 % 100003) +
+                    " payload=" + std::string(static_cast<size_t>(i % 40), 'p') + "\n";
+    }
+    auto writeSource = [&](const std::string& name) {
+        fs::path p = fs::path("./test_logs_pcomp") / name;
+        std::ofstream(p, std::ios::binary) << original;
+        return p;
+    };
+    
+    struct Case { std::string name; std::shared_ptr<ICompressionStrategy> strategy; };
+    std::vector<Case> cases{
+        {"gzip_serial", makeCompressionStrategy(CompressionCodec::Gzip, 0, 0)},
+        {"gzip_parallel", makeCompressionStrategy(CompressionCodec::Gzip, 0, 4)},
+        {"lz4_parallel", makeCompressionStrategy(CompressionCodec::Lz4, 0, 4)},
+        {"zstd_parallel", makeCompressionStrategy(CompressionCodec::Zstd, 0, 4)},
+    };
+    for (const auto& c : cases) {
+        if (c.name == "zstd_parallel" && !codecBuiltIn(CompressionCodec::Zstd)) continue;
+        auto src = writeSource(c.name + ".log");
+        auto start = std::chrono::steady_clock::now();
+        bool ok = c.strategy->compress(src);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << c.name << ": " << ms << " ms\n";
+        
+        fs::path dst = src.string() + c.strategy->compressedExtension();
+        std::string restored;
+        TEST_ASSERT(ok && !fs::exists(src) && readSegmentFile(dst, restored) && restored == original,
+                    c.name + " 压缩后可完整还原");
+    }
+    TEST_ASSERT(countGzipMembers("./test_logs_pcomp/gzip_serial.log.gz") == 1 &&
+                countGzipMembers("./test_logs_pcomp/gzip_parallel.log.gz") ==
+                    (original.size() + kBlock - 1) / kBlock,
+                "并行压缩输出为按块拼接的标准多成员 gzip");
+    if (codecBuiltIn(CompressionCodec::Zstd)) {
+        // zstd 同样按块并行（辅助线程计入 CPU 预算），每块一个 zstd 帧
+        std::string packed;
+        std::ifstream in("./test_logs_pcomp/zstd_parallel.log.zst", std::ios::binary);
+        packed.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        const std::string magic("\x28\xb5\x2f\xfd", 4);
+        size_t frames = 0;
+        for (size_t pos = packed.find(magic); pos != std::string::npos; pos = packed.find(magic, pos + 1)) {
+            ++frames;
+        }
+        TEST_ASSERT(frames >= (original.size() + kBlock - 1) / kBlock, "zstd 并行压缩按块输出多帧");
+    }
+}
+
+// ============================================
+// 测试: 自适应压缩级别与 CPU 预算
+// ============================================
+class BurnCompressionStrategy : public ICompressionStrategy {
+public:
+    bool compress(const fs::path&) override {
+        timespec start{}, now{};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        do {
+            ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        } while ((now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec) < 100000000L);
+        return true;
+    }
+    std::string compressedExtension() const override { return ".burn"; }
+};
+
+void test_adaptive_compression() {
+    TEST_CASE("自适应压缩级别");
+    
+    cleanupTestDir("./test_logs_adapt");
+    fs::create_directories("./test_logs_adapt");
+    CompressionPool::instance().configure(1, 10);
+    
+    using Tier = AdaptiveCompressionStrategy::Tier;
+    auto load = std::make_shared<std::atomic<double>>(0.0);
+    AdaptiveCompressionStrategy::Options options;
+    options.load_probe = [load] { return load->load(); };
+    auto adaptive = std::make_shared<AdaptiveCompressionStrategy>(CompressionCodec::Gzip, 6, 0, options);
+    
+    // 单线程池：积压 >= 2 降到 Fast，>= 4 只存储；负载同理
+    TEST_ASSERT(adaptive->chooseTier(0, 0.0) == Tier::High && adaptive->chooseTier(0, 0.5) == Tier::Balanced &&
+                adaptive->chooseTier(1, 0.0) == Tier::Balanced, "空闲时高压缩率，平时用配置级别");
+    TEST_ASSERT(adaptive->chooseTier(2, 0.0) == Tier::Fast && adaptive->chooseTier(4, 0.0) == Tier::Store &&
+                adaptive->chooseTier(0, 1.0) == Tier::Fast && adaptive->chooseTier(0, 2.0) == Tier::Store,
+                "积压或负载高时降到最快级别或只存储");
+    
+    // 压住线程池制造积压：先到的段降级，空闲后逐个以高压缩率重压
+    std::string content;
+    for (int i = 0; i < 20000; ++i) {
+        content += "ADAPT seq=" + std::to_string(i) + " " + std::string(static_cast<size_t>(i % 30), 'a') + "\n";
+    }
+    auto gated = std::make_shared<GatedCompressionStrategy>();
+    std::ofstream("./test_logs_adapt/gate.log") << "gate";
+    CompressionPool::instance().submit("./test_logs_adapt/gate.log", gated);
+    while (gated->started.load() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::vector<fs::path> segments;
+    for (int i = 0; i < 6; ++i) {
+        fs::path p = "./test_logs_adapt/seg" + std::to_string(i) + ".log";
+        std::ofstream(p, std::ios::binary) << content;
+        segments.push_back(p);
+        CompressionPool::instance().submit(p, adaptive);
+    }
+    gated->open = true;
+    CompressionPool::instance().waitIdle();
+    
+    bool restored = true;
+    size_t max_packed = 0;
+    for (const auto& p : segments) {
+        std::string data;
+        fs::path packed = p.string() + ".gz";
+        restored = restored && readSegmentFile(packed, data) && data == content;
+        max_packed = std::max<size_t>(max_packed, fs::file_size(packed));
+    }
+    // 实测吞吐跟不上连续到达的段时，积压较浅的段也可能降到 Fast
+    size_t lowered = adaptive->stats(Tier::Store).segments + adaptive->stats(Tier::Fast).segments;
+    TEST_ASSERT(adaptive->stats(Tier::Store).segments == 2 && adaptive->stats(Tier::Fast).segments >= 2,
+                "积压时按积压深度降档");
+    TEST_ASSERT(adaptive->stats(Tier::High).segments >= lowered && adaptive->pendingRecompress() == 0,
+                "空闲后以高压缩率重压降档的段");
+    TEST_ASSERT(restored && max_packed * 3 < content.size(), "重压后内容完整且全部为高压缩率");
+    TEST_ASSERT(adaptive->stats(Tier::High).ratio() < adaptive->stats(Tier::Store).ratio() &&
+                adaptive->stats(Tier::Fast).throughput() > 0, "按档记录压缩率与吞吐");
+    
+    // 经 RollingFileManager 轮转的段：重压后段目录记下新的大小
+    {
+        auto gate = std::make_shared<GatedCompressionStrategy>();
+        std::ofstream("./test_logs_adapt/gate2.log") << "gate";
+        CompressionPool::instance().submit("./test_logs_adapt/gate2.log", gate);
+        while (gate->started.load() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const size_t high_before = adaptive->stats(Tier::High).segments;
+        RollingFileManager mgr("./test_logs_adapt/mgr", "m_%Y%m%d_%H%M%S_%03d.log",
+                               content.size() * 2, std::chrono::minutes(60), 100, true, adaptive);
+        for (int i = 0; i < 6; ++i) {
+            mgr.append(content.data(), content.size());
+            mgr.rotate();
+        }
+        gate->open = true;
+        CompressionPool::instance().waitIdle();
+        
+        auto manifest = mgr.manifest();
+        size_t packed = 0;
+        bool accurate = true;
+        for (const auto& seg : manifest->segments()) {
+            if (seg.codec.empty()) continue;
+            ++packed;
+            std::error_code ec;
+            auto size = fs::file_size(manifest->path(seg), ec);
+            accurate = accurate && !ec && size == seg.bytes;
+        }
+        TEST_ASSERT(packed == 6 && adaptive->stats(Tier::High).segments > high_before && accurate,
+                    "重压后段目录中的大小与磁盘一致");
+    }
+    
+    // CPU 预算：0.2 核下 4 个各耗 100ms CPU 的任务至少需要约 1.5 秒
+    CompressionPool::instance().setCpuBudget(0.2);
+    auto burn = std::make_shared<BurnCompressionStrategy>();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 4; ++i) {
+        CompressionPool::instance().submit("./test_logs_adapt/burn" + std::to_string(i), burn);
+    }
+    CompressionPool::instance().waitIdle();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CompressionPool::instance().setCpuBudget(0);
+    TEST_ASSERT(elapsed >= std::chrono::milliseconds(1200),
+                "压缩 CPU 受预算约束 (" + std::to_string(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + " ms)");
+}
+
+// ============================================
+// 测试: zstd 训练字典
+// ============================================
+void test_compression_dictionary() {
+    TEST_CASE("zstd 训练字典");
+    if (!codecBuiltIn(CompressionCodec::Zstd)) {
+        std::cout << "  ⚠️ zstd 未编译进来，跳过" << std::endl;
+        return;
+    }
+    
+    cleanupTestDir("./test_logs_dict");
+    fs::create_directories("./test_logs_dict/plain");
+    
+    // 小段、大量重复的行前缀：单段压缩来不及建模，字典效果明显
+    auto makeSegment = [](int n) {
+        std::string s;
+        for (int i = 0; i < 120; ++i) {
+            s += "INFO network/Session.cpp:" + std::to_string(100 + i % 40) +
+                 " handlePacket - session=" + std::to_string(n * 1000 + i) +
+                 " bytes=" + std::to_string((i * 7919) % 65536) + "\n";
+        }
+        return s;
+    };
+    
+    ZstdDictionaryStrategy strategy(3, 4 * 1024, 4);
+    std::vector<fs::path> packed;
+    std::vector<std::string> contents;
+    for (int i = 0; i < 24; ++i) {
+        fs::path p = "./test_logs_dict/seg" + std::to_string(10 + i) + ".log";
+        contents.push_back(makeSegment(i));
+        std::ofstream(p, std::ios::binary) << contents.back();
+        strategy.compress(p);
+        packed.push_back(p.string() + ".zst");
+    }
+    
+    bool restored = true;
+    std::set<uint32_t> used;
+    for (size_t i = 0; i < packed.size(); ++i) {
+        std::string data;
+        restored = restored && readSegmentFile(packed[i], data) && data == contents[i];
+        used.insert(zstdDictionaryId(packed[i]));
+    }
+    TEST_ASSERT(restored, "字典压缩的段可自动加载字典解压");
+    TEST_ASSERT(zstdDictionaryId(packed.front()) == 0 && zstdDictionaryId(packed.back()) != 0,
+                "样本够用前不带字典，之后帧头记录字典 ID");
+    TEST_ASSERT(used.size() >= 3 && strategy.dictionaryId() == zstdDictionaryId(packed.back()),
+                "按段数定期重新训练出新版本");
+    
+    size_t dict_files = 0;
+    bool all_present = true;
+    for (const auto& e : fs::directory_iterator("./test_logs_dict/.dict")) {
+        dict_files += e.path().extension() == ".zdict";
+    }
+    for (uint32_t id : used) {
+        all_present = all_present && (id == 0 || fs::exists(zstdDictionaryPath(packed.front(), id)));
+    }
+    TEST_ASSERT(all_present && dict_files <= used.size(), "被引用的字典都保留，其余版本被清理");
+    
+    // 多线程压缩且每段重训：正在压缩的段所用的字典不会被并发的重训修剪
+    {
+        fs::create_directories("./test_logs_dict/mt");
+        // 高级别、大小悬殊的段：大段压缩期间其他线程能完成多次重训
+        ZstdDictionaryStrategy shared(19, 4 * 1024, 1);
+        const int kSegments = 48;
+        std::vector<std::string> mt_contents;
+        auto mtPath = [](int i) { return fs::path("./test_logs_dict/mt/seg" + std::to_string(100 + i) + ".log"); };
+        for (int i = 0; i < kSegments; ++i) {
+            std::string seg;
+            for (int r = 0; r < (i % 4 == 0 ? 40 : 1); ++r) seg += makeSegment(100 + i * 50 + r);
+            mt_contents.push_back(std::move(seg));
+            std::ofstream(mtPath(i), std::ios::binary) << mt_contents.back();
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = t; i < kSegments; i += 4) {
+                    shared.compress(mtPath(i));
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        bool decodable = true;
+        for (int i = 0; i < kSegments; ++i) {
+            std::string data;
+            decodable = decodable && readSegmentFile(mtPath(i).string() + ".zst", data) && data == mt_contents[i];
+        }
+        TEST_ASSERT(decodable, "并发压缩与重训时所有段仍可解码");
+    }
+    
+    // 与不带字典的同级别 zstd 比较
+    fs::path plain = "./test_logs_dict/plain/seg.log";
+    std::ofstream(plain, std::ios::binary) << contents.back();
+    ZstdCompressionStrategy(3).compress(plain);
+    auto with_dict = fs::file_size(packed.back());
+    auto without = fs::file_size(plain.string() + ".zst");
+    TEST_ASSERT(with_dict * 10 < without * 9,
+                "字典提升小段压缩率 (" + std::to_string(with_dict) + " vs " + std::to_string(without) + ")");
+    
+    // 重启后沿用目录中最新的字典
+    ZstdDictionaryStrategy restarted(3, 4 * 1024, 4);
+    fs::path next = "./test_logs_dict/seg99.log";
+    std::ofstream(next, std::ios::binary) << makeSegment(99);
+    restarted.compress(next);
+    TEST_ASSERT(zstdDictionaryId(next.string() + ".zst") == strategy.dictionaryId(), "重启后沿用最新字典");
+    
+    // 字典丢失时明确失败而不是输出错误内容
+    fs::remove_all("./test_logs_dict/.dict");
+    std::string lost;
+    TEST_ASSERT(!readSegmentFile(packed.back(), lost), "缺少字典时读取失败");
+}
+
+// ============================================
+// 测试: 段目录（manifest）
+// ============================================
+void test_segment_manifest() {
+    TEST_CASE("段目录");
+    
+    cleanupTestDir("./test_logs_manifest");
+    
+    auto diskFiles = [](const fs::path& dir) {
+        std::set<std::string> names;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (isSegmentFile(entry)) names.insert(entry.path().filename().string());
+        }
+        return names;
+    };
+    auto manifestFiles = [](const SegmentManifest& manifest) {
+        std::set<std::string> names;
+        for (const auto& seg : manifest.segments()) names.insert(seg.fileName());
+        return names;
+    };
+    
+    const std::string record(600, 'm');
+    fs::path dir, current;
+    {
+        RollingFileManager mgr("./test_logs_manifest", "m_%Y%m%d_%H%M%S_%03d.log",
+                               1024, std::chrono::minutes(60), 5, true);
+        for (int i = 0; i < 20; ++i) {
+            mgr.append(record.data(), record.size());
+            mgr.append(record.data(), 10);
+            mgr.rotate();
+            // 排队压缩的段不参与保留数量，逐个等待使结果确定
+            CompressionPool::instance().waitIdle();
+        }
+        dir = mgr.currentPath().parent_path();
+        current = mgr.currentPath();
+        
+        auto manifest = mgr.manifest();
+        auto segments = manifest->segments();
+        bool ordered = true, accounted = true;
+        size_t compressed = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const auto& seg = segments[i];
+            ordered = ordered && (i == 0 || segments[i - 1].seq < seg.seq) && seg.first_us <= seg.last_us;
+            if (seg.state == SegmentManifest::State::Compressed) {
+                ++compressed;
+                accounted = accounted && seg.codec == ".gz" && seg.records == 2 &&
+                            seg.bytes == fs::file_size(dir / seg.fileName());
+            }
+        }
+        TEST_ASSERT(manifestFiles(*manifest) == diskFiles(dir), "段目录与磁盘上的段一致");
+        TEST_ASSERT(segments.size() == 6 && compressed == 5 &&
+                    segments.back().state == SegmentManifest::State::Active,
+                    "保留数量按段目录执行，压缩完成后记下编解码器");
+        TEST_ASSERT(ordered && accounted, "记录序号、时间范围、记录数与大小");
+    }
+    
+    SegmentManifest reloaded(dir, ".log");
+    SegmentManifest::Segment last;
+    TEST_ASSERT(!reloaded.rebuilt() && manifestFiles(reloaded) == diskFiles(dir) &&
+                reloaded.latest(last) && last.state == SegmentManifest::State::Sealed,
+                "重放日志恢复段目录，关闭时当前段已封口");
+    {
+        RollingFileManager mgr("./test_logs_manifest", "m_%Y%m%d_%H%M%S_%03d.log",
+                               1024, std::chrono::minutes(60), 5, true);
+        TEST_ASSERT(mgr.currentPath() == current, "按段目录续写最新的未满段");
+    }
+    
+    // 崩溃时写了一半的末行被跳过
+    std::ofstream(dir / SegmentManifest::kJournalName, std::ios::app) << "{\"op\":\"put\",\"na";
+    SegmentManifest torn(dir, ".log");
+    TEST_ASSERT(!torn.rebuilt() && manifestFiles(torn) == diskFiles(dir), "忽略不完整的日志行");
+    
+    // 日志丢失时扫描目录重建
+    fs::remove(dir / SegmentManifest::kJournalName);
+    SegmentManifest rebuilt(dir, ".log");
+    TEST_ASSERT(rebuilt.rebuilt() && manifestFiles(rebuilt) == diskFiles(dir) &&
+                fs::exists(dir / SegmentManifest::kJournalName), "日志缺失时冷扫描重建");
+}
+
+void test_disk_quota() {
+    TEST_CASE("磁盘配额");
+    
+    cleanupTestDir("./test_logs_budget");
+    auto& quotas = DiskQuotaManager::instance();
+    auto diskBytes = [](const fs::path& dir) {
+        uint64_t total = 0;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (isSegmentFile(entry)) total += entry.file_size();
+        }
+        return total;
+    };
+    const std::string record(1000, 'q');
+    
+    // 按字节保留：轮转后只留不超过配额的最旧段
+    {
+        ModuleDiskQuota q;
+        q.max_bytes = 3000;
+        quotas.setQuota("bytes", q);
+        RollingFileManager mgr("./test_logs_budget/bytes", "b_%Y%m%d_%H%M%S_%03d.log",
+                               4096, std::chrono::minutes(60), 100, false);
+        for (int i = 0; i < 10; ++i) {
+            mgr.append(record.data(), record.size());
+            mgr.rotate();
+        }
+        auto manifest = mgr.manifest();
+        TEST_ASSERT(manifest->size() == 4 && manifest->totalBytes() == 3000 &&
+                    diskBytes(manifest->dir()) == 3000, "模块总字节不超过配额");
+        
+        // 写入中的段在封口前就计入配额
+        mgr.append(record.data(), record.size());
+        mgr.flush();
+        quotas.enforceAll();
+        TEST_ASSERT(manifest->size() == 3 && manifest->hotBytes() == 3000 &&
+                    diskBytes(manifest->dir()) == 3000, "写入中段的字节计入配额");
+    }
+    
+    // 按时间保留：最后写入早于保留时长的段被删除
+    {
+        ModuleDiskQuota q;
+        q.max_age = std::chrono::minutes(1);
+        quotas.setQuota("aged", q);
+        RollingFileManager mgr("./test_logs_budget/aged", "a_%Y%m%d_%H%M%S_%03d.log",
+                               4096, std::chrono::minutes(60), 100, false);
+        for (int i = 0; i < 3; ++i) {
+            mgr.append(record.data(), record.size());
+            mgr.rotate();
+        }
+        auto manifest = mgr.manifest();
+        auto segments = manifest->segments();
+        const int64_t old_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            (std::chrono::system_clock::now() - std::chrono::minutes(2)).time_since_epoch()).count();
+        for (size_t i = 0; i < 2; ++i) {
+            manifest->update(segments[i].name, [&](SegmentManifest::Segment& seg) { seg.last_us = old_us; });
+        }
+        mgr.append(record.data(), record.size());
+        mgr.rotate();
+        TEST_ASSERT(manifest->size() == 3 && !manifest->contains(segments[0].name) &&
+                    !manifest->contains(segments[1].name) &&
+                    !fs::exists(manifest->dir() / segments[0].fileName()), "过期段被删除");
+        
+        // 不再轮转的模块由周期检查按时间保留
+        segments = manifest->segments();
+        manifest->update(segments[0].name, [&](SegmentManifest::Segment& seg) { seg.last_us = old_us; });
+        quotas.enforceAll();
+        TEST_ASSERT(manifest->size() == 2 && !manifest->contains(segments[0].name),
+                    "未轮转时周期检查删除过期段");
+    }
+    
+    // 全局回收：权重小的模块先被回收；总预算下仍保留模块的最小保证
+    {
+        ModuleDiskQuota low, high;
+        low.weight = 0.1;
+        high.weight = 0.5;
+        high.min_bytes = 200;
+        quotas.setQuota("low", low);
+        quotas.setQuota("high", high);
+        RollingFileManager low_mgr("./test_logs_budget/low", "l_%Y%m%d_%H%M%S_%03d.log",
+                                   4096, std::chrono::minutes(60), 100, true);
+        RollingFileManager high_mgr("./test_logs_budget/high", "h_%Y%m%d_%H%M%S_%03d.log",
+                                    4096, std::chrono::minutes(60), 100, true);
+        for (int i = 0; i < 5; ++i) {
+            std::string text;
+            for (int j = 0; j < 200; ++j) text += std::to_string(i * 1000 + j * 7919) + " ";
+            low_mgr.append(text.data(), text.size());
+            low_mgr.rotate();
+            high_mgr.append(text.data(), text.size());
+            high_mgr.rotate();
+            CompressionPool::instance().waitIdle();
+        }
+        auto low_manifest = low_mgr.manifest();
+        auto high_manifest = high_mgr.manifest();
+        const size_t high_segments = high_manifest->size();
+        
+        quotas.reclaim([&](uint64_t) { return low_manifest->size() == 1; });
+        TEST_ASSERT(low_manifest->size() == 1 && high_manifest->size() == high_segments,
+                    "先回收权重小的模块，写入中的段不回收");
+        
+        // 空间回收只涉及同一文件系统，且每个目录至少保留 min_keep_files 个段
+        struct stat here{}, shm{};
+        if (::stat("/dev/shm", &shm) == 0 && ::stat(high_manifest->dir().c_str(), &here) == 0 &&
+            shm.st_dev != here.st_dev) {
+            RollingFileManager shm_mgr("/dev/shm/test_logs_budget/shm", "s_%Y%m%d_%H%M%S_%03d.log",
+                                       4096, std::chrono::minutes(60), 100, false);
+            for (int i = 0; i < 5; ++i) {
+                shm_mgr.append("shm segment\n", 12);
+                shm_mgr.rotate();
+            }
+            auto shm_manifest = shm_mgr.manifest();
+            quotas.reclaim([](uint64_t) { return false; }, {"/dev/shm", 2});
+            TEST_ASSERT(shm_manifest->size() == 3 && high_manifest->size() == high_segments,
+                        "空间回收保留最少段数，不删除其他文件系统上的段");
+        }
+        std::error_code shm_ec;
+        fs::remove_all("/dev/shm/test_logs_budget", shm_ec);
+        
+        quotas.configure(1, DiskPolicy::fromMB(100, 50, 2), {{"low", low}, {"high", high}});
+        quotas.enforce("high", high_manifest);
+        TEST_ASSERT(high_manifest->size() < high_segments && high_manifest->totalBytes() >= high.min_bytes,
+                    "超出总预算时回收到最小保证为止");
+        
+        uint64_t usage = 0;
+        for (const auto& u : quotas.usage()) {
+            if (u.module == "low" || u.module == "high") usage += u.bytes;
+        }
+        TEST_ASSERT(usage == low_manifest->totalBytes() + high_manifest->totalBytes() &&
+                    high_manifest->totalBytes() == diskBytes(high_manifest->dir()), "按模块统计占用");
+    }
+    quotas.configure(0, DiskPolicy::fromMB(100, 50, 2), {});
+    
+    auto cfg = LoggerConfig::fromJson(nlohmann::json::parse(R"({
+        "disk": {"total_mb": 7, "soft_min_free_mb": 30, "hard_min_free_mb": 10},
+        "modules": [{"name": "x", "disk_quota_mb": 4, "disk_min_mb": 1,
+                     "disk_weight": 0.5, "retain_minutes": 30}]
+    })"));
+    const auto& mod = cfg.modules.at(0);
+    TEST_ASSERT(cfg.disk.total_mb == 7 && cfg.disk.soft_min_free_mb == 30 && cfg.disk.hard_min_free_mb == 10 &&
+                mod.disk_quota_mb == 4 && mod.disk_min_mb == 1 && mod.disk_weight == 0.5 &&
+                mod.retain_age == std::chrono::minutes(30), "解析磁盘配置");
+}
+
+void test_tiered_storage() {
+    TEST_CASE("分层存储");
+    
+    // 第二个冷层尽量放在另一个文件系统上（tmpfs），走复制而不是 rename
+    std::error_code shm_ec;
+    const bool use_shm = fs::space("/dev/shm", shm_ec).available > 256ULL * 1024 * 1024 && !shm_ec;
+    const fs::path far_root = use_shm ? "/dev/shm/logger_test_tier_far" : "./test_logs_tier_far";
+    cleanupTestDir("./test_logs_tier");
+    cleanupTestDir("./test_logs_tier_cold");
+    cleanupTestDir(far_root.string());
+    
+    auto segmentFiles = [](const fs::path& dir) {
+        size_t n = 0;
+        if (!fs::exists(dir)) return n;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (isSegmentFile(entry)) ++n;
+        }
+        return n;
+    };
+    auto readTimeline = [](const std::vector<fs::path>& paths) {
+        std::string all;
+        for (const auto& p : paths) {
+            std::string data;
+            if (!readSegmentFile(p, data)) return std::string("<unreadable>");
+            all += data;
+        }
+        return all;
+    };
+    auto settle = [] {
+        CompressionPool::instance().waitIdle();
+        TierMigrator::instance().waitIdle();
+    };
+    
+    std::string written;
+    fs::path hot_dir;
+    std::vector<TierMigrator::Tier> tiers{{"./test_logs_tier_cold", 0}, {far_root, 0}};
+    {
+        RollingFileManager mgr("./test_logs_tier/tiered", "t_%Y%m%d_%H%M%S_%03d.log",
+                               4096, std::chrono::minutes(60), 100, true);
+        for (int i = 0; i < 4; ++i) {
+            std::string text;
+            for (int j = 0; j < 150; ++j) text += std::to_string(i * 100000 + j * 7919) + "\n";
+            mgr.append(text.data(), text.size());
+            written += text;
+            mgr.rotate();
+            settle();
+        }
+        auto manifest = mgr.manifest();
+        hot_dir = manifest->dir();
+        
+        // 第一冷层只放得下一个段：设置冷层后已压缩的段迁过去，较旧的继续下沉
+        uint64_t one_segment = 0;
+        for (const auto& seg : manifest->segments()) one_segment = std::max(one_segment, seg.bytes);
+        tiers[0].max_bytes = one_segment;
+        mgr.setColdTiers(tiers);
+        settle();
+        
+        const auto cold_dir = mgr.coldTiers()[0].dir;
+        const auto far_dir = mgr.coldTiers()[1].dir;
+        TEST_ASSERT(cold_dir == fs::path("./test_logs_tier_cold") / "tiered" / hot_dir.filename(),
+                    "冷层目录与热层同构");
+        TEST_ASSERT(segmentFiles(hot_dir) == 1 && segmentFiles(cold_dir) == 1 && segmentFiles(far_dir) == 3 &&
+                    manifest->tierBytes(1) <= one_segment && manifest->tierBytes(0) == 0,
+                    "压缩完的段迁往冷层，超出层上限的最旧段下沉到下一层");
+        
+        for (int i = 4; i < 6; ++i) {
+            std::string text;
+            for (int j = 0; j < 150; ++j) text += std::to_string(i * 100000 + j * 7919) + "\n";
+            mgr.append(text.data(), text.size());
+            written += text;
+            mgr.rotate();
+            settle();
+        }
+        TEST_ASSERT(segmentFiles(hot_dir) == 1 && segmentFiles(far_dir) == 5, "轮转后的段在后台迁移");
+        
+        auto paths = manifest->paths();
+        TEST_ASSERT(readTimeline(paths) == written, "读者按段目录看到跨层的完整时间线");
+        TEST_ASSERT(SegmentManifest::timeline(hot_dir) == paths, "离线读取与在线段目录的时间线一致");
+        
+        // 模拟迁移中途退出：冷层留下复制到一半的临时文件，热层留下已迁走段的源文件
+        std::ofstream(far_dir / "t_partial.log.gz.migrating") << "partial";
+        fs::copy_file(paths[0], hot_dir / paths[0].filename());
+    }
+    
+    DiskQuotaManager::instance().setQuota("tiered", [&] {
+        ModuleDiskQuota q;
+        q.cold_tiers = tiers;
+        return q;
+    }());
+    {
+        RollingFileManager mgr("./test_logs_tier/tiered", "t_%Y%m%d_%H%M%S_%03d.log",
+                               4096, std::chrono::minutes(60), 100, true);
+        settle();
+        const auto far_dir = mgr.coldTiers().at(1).dir;
+        TEST_ASSERT(!fs::exists(far_dir / "t_partial.log.gz.migrating") && segmentFiles(hot_dir) == 1 &&
+                    readTimeline(mgr.manifest()->paths()) == written,
+                    "按模块配置设置冷层，启动时清理迁移残留");
+    }
+    DiskQuotaManager::instance().setQuota("tiered", ModuleDiskQuota{});
+    cleanupTestDir(far_root.string());
+    
+    auto cfg = LoggerConfig::fromJson(nlohmann::json::parse(R"({
+        "disk": {"migrate_mb_per_sec": 4},
+        "modules": [{"name": "x", "cold_tiers": [{"dir": "/mnt/a", "max_mb": 10}, {"dir": "/mnt/b"}]}]
+    })"));
+    const auto& cold = cfg.modules.at(0).cold_tiers;
+    TEST_ASSERT(cfg.disk.migrate_mb_per_sec == 4 && cold.size() == 2 && cold[0].dir == "/mnt/a" &&
+                cold[0].max_mb == 10 && cold[1].max_mb == 0, "解析冷层配置");
+}
+
 // ============================================
 // 主函数
 // ============================================
@@ -355,6 +2646,7 @@ int main() {
     std::cout << "========================================\n";
     
     try {
+        test_default_queue_capacity();
         test_basic_logging();
         test_log_level_filter();
         test_async_mode();
@@ -363,6 +2655,32 @@ int main() {
         test_config_reload();
         test_runtime_level_change();
         test_performance();
+        test_mpmc_queue();
+        test_reconfigure_under_load();
+        test_per_thread_queue();
+        test_large_entries();
+        test_lazy_evaluation();
+        test_format();
+        test_compact_text();
+        test_timestamp_precision();
+        test_console_sink();
+        test_routing_table();
+        test_batch_write();
+        test_write_accounting();
+        test_flush_policy();
+        test_fd_backend();
+        test_uring_backend();
+        test_mmap_segment();
+        test_direct_backend();
+        test_compression_pool();
+        test_compression_codecs();
+        test_stream_compression();
+        test_parallel_compression();
+        test_adaptive_compression();
+        test_compression_dictionary();
+        test_segment_manifest();
+        test_disk_quota();
+        test_tiered_storage();
         
     } catch (const std::exception& e) {
         std::cerr << "\n❌ 测试异常: " << e.what() << std::endl;
@@ -379,6 +2697,16 @@ int main() {
     cleanupTestDir("./test_logs6");
     cleanupTestDir("./test_logs7");
     cleanupTestDir("./test_logs_perf");
+    cleanupTestDir("./test_logs_mpmc");
+    cleanupTestDir("./test_logs_reconf");
+    cleanupTestDir("./test_logs_spsc");
+    cleanupTestDir("./test_logs_large");
+    cleanupTestDir("./test_logs_lazy");
+    cleanupTestDir("./test_logs_fmt");
+    cleanupTestDir("./test_logs_compact");
+    cleanupTestDir("./test_logs_ts");
+    cleanupTestDir("./test_logs_route");
+    cleanupTestDir("./test_logs_batch");
     
     // 输出测试结果
     std::cout << "\n========================================\n";